@@ -0,0 +1,190 @@
+#include "ftl.h"
+#include "logger.h"
+
+/* ---------------- 自适应 OP benchmark ----------------
+   同一串分阶段负载（顺序预写后：hotcold -> uniform -> sequential -> failures -> uniform）分别在固定池、
+   自适应 OP（reserve / spare）与自适应 OP + 导出容量（resize_export）下运行。failures 阶段是 uniform 写加上
+   均匀注入的运行时失效块（读 / 编程 / 擦除都失败，擦除时判坏），三种配置注入同样的块；P/E 上限让后期出现
+   磨损坏块。逐阶段输出 WAF、GC 效率、判坏数、各池当前大小与成功写入的主机扇区数；最后按池对照：固定配置列出各阶段结束时的大小，
+   自适应配置列出 op_log() 里落在该阶段的调整（起点 -> 终点，次数）
+   用法：aop_bench [--turns N] [--seed S] [--pe-limit N] [--epoch N] [--eff-low X] [--eff-high X] [--fails N]
+   --turns：每个阶段写入的 LBA 遍数；--epoch：自适应评估间隔（主机写数，默认 LBA 数 / 8）
+   --fails：failures 阶段注入的失效块数（默认 4，只取数据区的块；注入过多时 reserve 降到 0 的
+   自适应配置会因 JIT GC 没有余量而停止接收写入，host 列随之变小）
+*/
+
+struct AopConfig
+{
+    int dies = 2, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85;
+    int turns = 2;
+    uint32_t pe_limit = 60;
+    uint64_t epoch = 0;
+    double eff_low = 0.5, eff_high = 0.8;
+    int fails = 4;
+    uint32_t seed = 1;
+};
+
+enum class OpMode
+{
+    FIXED,
+    ADAPTIVE,
+    ADAPTIVE_EXPORT
+};
+
+static const char *const kPhase[] = {"hotcold", "uniform", "sequential", "failures", "uniform"};
+static const int kPhases = 5, kFailPhase = 3;
+static const char *const kKnob[] = {"reserve", "spare", "export"};
+
+struct RunResult
+{
+    const char *name = "";
+    bool adaptive = false;
+    vector<array<long, 3>> ends;                  // [phase] 阶段结束时的 reserve / spare / export
+    vector<pair<uint64_t, uint64_t>> phase_sectors; // [phase] 阶段起止时的主机写扇区数
+    vector<FTL::OpAdjustment> log;
+};
+
+static RunResult run(const AopConfig &c, OpMode mode)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    NandCellParams cp;
+    cp.pe_limit = c.pe_limit;
+    driver.set_cell_params(cp);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    int lbas = (int)(writable * c.user_ratio);
+    FTL ftl(driver, runtime, bm, lbas);
+    for (int l = 0; l < lbas; ++l)
+        ftl.write(l, "P");
+    RunResult r;
+    r.adaptive = mode != OpMode::FIXED;
+    r.name = mode == OpMode::FIXED ? "fixed" : mode == OpMode::ADAPTIVE ? "adaptive" : "adaptive+export";
+    if (mode != OpMode::FIXED)
+    {
+        FTL::AdaptiveOpParams ap;
+        ap.epoch_sectors = c.epoch ? c.epoch : max(1, lbas / 8);
+        ap.eff_low = c.eff_low;
+        ap.eff_high = c.eff_high;
+        ap.resize_export = mode == OpMode::ADAPTIVE_EXPORT;
+        ftl.set_adaptive_op(ap);
+    }
+
+    cout << "-- " << r.name << "\n";
+    cout << left << setw(12) << "phase" << right << setw(8) << "WAF" << setw(9) << "gc_eff" << setw(8) << "gc"
+         << setw(6) << "bad" << setw(9) << "reserve" << setw(7) << "spare" << setw(9) << "export" << setw(8) << "host" << "\n";
+    mt19937 rng(c.seed);
+    // 失效块单独一个随机源：在数据区（不含 spare 区）随机挑块注入运行中失效，此后读 / 编程 / 擦除都失败。
+    // 块里的有效数据在 GC 搬移时读不出而丢失；擦除失败后走 grown-bad 重映射（spare 用完则该 lane 退出条带）
+    mt19937 frng(c.seed + 1);
+    for (int ph = 0; ph < kPhases; ++ph)
+    {
+        FTL::WriteStats w0 = ftl.write_stats();
+        long n = (long)lbas * c.turns;
+        long fail_every = ph == kFailPhase && c.fails > 0 ? max(1L, n / c.fails) : 0;
+        int seq = 0;
+        for (long i = 0; i < n; ++i)
+        {
+            if (fail_every && i % fail_every == 0 && i / fail_every < c.fails)
+                driver.inject_runtime_fail(frng() % c.dies, frng() % c.planes, frng() % (c.blocks - c.reserved_spare));
+            int exp = ftl.exported_lbas(), hot = max(1, exp / 5), lba;
+            if (ph == 0)
+                lba = rng() % 100 < 80 ? rng() % hot : hot + rng() % max(1, exp - hot);
+            else if (ph == 2)
+                lba = seq++ % exp;
+            else
+                lba = rng() % exp;
+            ftl.write(lba, "W");
+        }
+        FTL::WriteStats d = ftl.write_stats() - w0;
+        uint64_t reclaimed = d.gc_freed_pages + d.gc_pages;
+        cout << left << setw(12) << kPhase[ph] << right << fixed << setprecision(3) << setw(8) << d.waf()
+             << setw(9) << (reclaimed ? (double)d.gc_freed_pages / reclaimed : 0.0) << defaultfloat << setw(8)
+             << d.gc_runs << setw(6) << d.bad_blocks << setw(9) << bm.reserved_write() << setw(7)
+             << bm.spare_blocks_left() << setw(9) << ftl.exported_lbas() << setw(8) << d.host_sectors << "\n";
+        r.ends.push_back({bm.reserved_write(), bm.spare_blocks_left(), ftl.exported_lbas()});
+        r.phase_sectors.push_back({w0.host_sectors, ftl.write_stats().host_sectors});
+    }
+    if (mode != OpMode::FIXED)
+        ftl.dump_op_log();
+    r.log = ftl.op_log();
+    return r;
+}
+
+// 各池的轨迹：固定配置取阶段结束时的大小；自适应取 op_log() 里落在该阶段的调整（from -> to，次数），没有调整记 "-"
+static void print_trajectories(const vector<RunResult> &runs)
+{
+    cout << "-- pool trajectories (fixed: size at phase end; adaptive: op_log() moves in phase)\n";
+    cout << left << setw(9) << "pool" << setw(17) << "run" << right;
+    for (int ph = 0; ph < kPhases; ++ph)
+        cout << setw(17) << kPhase[ph];
+    cout << setw(7) << "moves" << "\n";
+    for (int k = 0; k < 3; ++k)
+        for (const auto &r : runs)
+        {
+            cout << left << setw(9) << kKnob[k] << setw(17) << r.name << right;
+            int moves = 0;
+            for (int ph = 0; ph < kPhases; ++ph)
+            {
+                if (!r.adaptive)
+                {
+                    cout << setw(17) << r.ends[ph][k];
+                    continue;
+                }
+                long from = 0, to = 0;
+                int cnt = 0;
+                for (const auto &a : r.log)
+                    if (string(a.knob) == kKnob[k] && a.host_sectors > r.phase_sectors[ph].first &&
+                        a.host_sectors <= r.phase_sectors[ph].second)
+                    {
+                        if (cnt++ == 0)
+                            from = a.from;
+                        to = a.to;
+                    }
+                moves += cnt;
+                cout << setw(17) << (cnt ? to_string(from) + "->" + to_string(to) + " (" + to_string(cnt) + ")" : "-");
+            }
+            cout << setw(7) << moves << "\n";
+        }
+}
+
+int main(int argc, char **argv)
+{
+    AopConfig cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--turns" && i + 1 < argc)
+            cfg.turns = max(1, stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--pe-limit" && i + 1 < argc)
+            cfg.pe_limit = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--epoch" && i + 1 < argc)
+            cfg.epoch = stoull(argv[++i]);
+        else if (arg == "--eff-low" && i + 1 < argc)
+            cfg.eff_low = stod(argv[++i]);
+        else if (arg == "--eff-high" && i + 1 < argc)
+            cfg.eff_high = stod(argv[++i]);
+        else if (arg == "--fails" && i + 1 < argc)
+            cfg.fails = max(0, stoi(argv[++i]));
+        else
+        {
+            cerr << "usage: aop_bench [--turns N] [--seed S] [--pe-limit N] [--epoch N] [--eff-low X] [--eff-high X]"
+                    " [--fails N]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+         << " turns/phase=" << cfg.turns << " pe_limit=" << cfg.pe_limit << " gc_eff target=[" << cfg.eff_low << ", "
+         << cfg.eff_high << "] fails=" << cfg.fails << "\n";
+    vector<RunResult> runs;
+    for (OpMode m : {OpMode::FIXED, OpMode::ADAPTIVE, OpMode::ADAPTIVE_EXPORT})
+        runs.push_back(run(cfg, m));
+    print_trajectories(runs);
+    return 0;
+}
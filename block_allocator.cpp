@@ -1,12 +1,19 @@
 #include "block_allocator.h"
+#include "mem_account.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 
 /* ---------------- BlockManager with BAD BLOCK TABLE ---------------- */
-BlockManager::BlockManager(NandDriver &drv, NandRuntime &rt, int reserved_write_per_plane, int reserved_spare_per_plane)
-    : drv_(drv), nand_runtime(rt), reserved_write_(reserved_write_per_plane), reserved_spare_(reserved_spare_per_plane)
+BlockManager::BlockManager(NandDriver &drv, NandRuntime &rt, int reserved_write_per_plane, int reserved_spare_per_plane,
+                           int slc_blocks_per_plane)
+    : drv_(drv), geo_(drv.geometry()), nand_runtime(rt), reserved_write_(reserved_write_per_plane), reserved_spare_(reserved_spare_per_plane),
+      slc_blocks_(max(0, slc_blocks_per_plane)), reserve_target_(max(0, reserved_write_per_plane))
 {
-    plane_manager.resize(drv_.dies_per_nand(), vector<PlaneManager>(drv_.planes_per_die()));
+    {
+        MemScope scope(MemComponent::BM_POOLS);
+        plane_manager.resize(drv_.dies_per_nand(), vector<PlaneManager>(drv_.planes_per_die()));
+    }
+    MemScope scope(MemComponent::BM_REMAP);
     remap_.resize(drv_.dies_per_nand(), vector<vector<int>>(drv_.planes_per_die(), vector<int>(drv_.blocks_per_plane(), -1)));
     // 初始化反向映射表
     reverse_remap_.resize(drv_.dies_per_nand(), vector<vector<int>>(drv_.planes_per_die(), vector<int>(drv_.blocks_per_plane(), -1)));
@@ -23,6 +30,7 @@ BlockManager::BlockManager(NandDriver &drv, NandRuntime &rt, int reserved_write_
 // 初始化：构建 BAD BLOCK TABLE 前的列表，随后对 FACTORY BAD BLOCK 做 remap
 void BlockManager::init_from_bbt(function<bool(int, int, int)> is_bad_block)
 {
+    MemScope scope(MemComponent::BM_POOLS);
     for (int d = 0; d < drv_.dies_per_nand(); ++d)
     {
         for (int p = 0; p < drv_.planes_per_die(); ++p)
@@ -31,8 +39,9 @@ void BlockManager::init_from_bbt(function<bool(int, int, int)> is_bad_block)
             pl.free_vbns.clear();
             pl.reserved_write_vbns.clear();
             pl.reserved_spare_pbns.clear();
+            pl.slc_free_vbns.clear();
 
-            // 末尾划分： [.. normal .. | reserved_write | reserved_spare ]
+            // 划分： [ slc | .. normal .. | reserved_write | reserved_spare ]
             int total = drv_.blocks_per_plane();
             int reserved_spare = max(0, reserved_spare_);
             int reserved_write = max(0, reserved_write_);
@@ -44,29 +53,35 @@ void BlockManager::init_from_bbt(function<bool(int, int, int)> is_bad_block)
 
             int start_write = total - (reserved_write + reserved_spare);
             int start_spare = total - reserved_spare;
+            slc_blocks_ = min(slc_blocks_, start_write);
+
+            // 每块只探测一次
+            vector<uint8_t> bad(total);
+            for (int b = 0; b < total; ++b)
+                bad[b] = is_bad_block(d, p, b);
 
             // reserved_spare 用 PBN 列表存（因为仅做替换，不直接作为 VBN 分配）
             for (int b = start_spare; b < total; ++b)
             {
-                if (!is_bad_block(d, p, b))
+                if (!bad[b])
                     pl.reserved_spare_pbns.push_back(b);
             }
             // reserved_write 和 normal 作为 VBN 列表存
             for (int b = start_write; b < start_spare; ++b)
             {
-                if (!is_bad_block(d, p, b))
+                if (!bad[b])
                     pl.reserved_write_vbns.push_back(b);
             }
             for (int b = 0; b < start_write; ++b)
             {
-                if (!is_bad_block(d, p, b))
-                    pl.free_vbns.push_back(b);
+                if (!bad[b])
+                    (is_slc_vbn(b) ? pl.slc_free_vbns : pl.free_vbns).push_back(b);
             }
 
             // 工厂坏块：对每个 FACTORY BAD BLOCK vbn 进行 remap（占用一个 spare_pbn）
             for (int vbn = 0; vbn < drv_.blocks_per_plane(); ++vbn)
             {
-                if (is_bad_block(d, p, vbn))
+                if (bad[vbn])
                 {
                     int spare = take_spare_pbn(d, p);
                     if (spare != -1)
@@ -75,7 +90,7 @@ void BlockManager::init_from_bbt(function<bool(int, int, int)> is_bad_block)
                         reverse_remap_[d][p][spare] = vbn; // 更新反向映射
                         // FACTORY BAD BLOCK 的 VBN 也应该可用（映射到 spare），加入 free_vbns
                         // 注意避免把它放到 reserved 区（让它进入 normal free 更简单）
-                        pl.free_vbns.push_back(vbn);
+                        (is_slc_vbn(vbn) ? pl.slc_free_vbns : pl.free_vbns).push_back(vbn);
                     }
                     else
                     {
@@ -84,11 +99,336 @@ void BlockManager::init_from_bbt(function<bool(int, int, int)> is_bad_block)
                 }
             }
 
-            pl.open_vbn = !pl.free_vbns.empty() ? pl.free_vbns.front() : -1;
-            if(pl.open_vbn == pl.free_vbns.front()) pl.free_vbns.pop_front();
+            // 单元模式跟随 VBN：SLC VBN 当前对应的 PBN 设为 SLC 模式
+            for (int vbn = 0; vbn < total; ++vbn)
+                drv_.set_block_slc(d, p, resolve_pbn(d, p, vbn), is_slc_vbn(vbn));
+
+            // open 由 alloc_page 按需从 free 中取
+            pl.open_vbn = -1;
             pl.next_page_on_open_pbn = 0;
         }
     }
+    build_superblocks();
+}
+
+// 超级块表：VBN 号相同的各 lane 成员，凡在 lane 池中者即可用
+void BlockManager::build_superblocks()
+{
+    MemScope scope(MemComponent::BM_SUPERBLOCKS);
+    int lanes = drv_.dies_per_nand() * drv_.planes_per_die();
+    sbs_.assign(drv_.blocks_per_plane(), Superblock{});
+    for (auto &sb : sbs_)
+        sb.lane_ok.assign(lanes, 0);
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+        {
+            auto &pl = plane_manager[d][p];
+            pl.queued.assign(drv_.blocks_per_plane(), 0);
+            for (int k : {POOL_FREE, POOL_RESERVED, POOL_SLC})
+                for (int v : pool(d, p, k))
+                {
+                    pl.queued[v] |= (uint8_t)(1 << k);
+                    sbs_[v].lane_ok[lane_of(d, p)] = 1;
+                    sbs_[v].lane_cnt++;
+                    if (k == POOL_RESERVED)
+                        sbs_[v].reserved = true;
+                }
+        }
+    free_sbs_[0] = free_sbs_[1] = 0;
+    free_lanes_[0] = free_lanes_[1] = 0;
+    reserved_free_ = reserved_lanes_ = 0;
+    free_order_[0].clear();
+    free_order_[1].clear();
+    free_key_.assign(sbs_.size(), FreeKey{false, 0, 0.0, -1});
+    for (int v = 0; v < (int)sbs_.size(); ++v)
+    {
+        sbs_[v].state = sbs_[v].lane_cnt > 0 ? SbState::FREE : SbState::DEAD;
+        sbs_[v].reserved = sbs_[v].reserved && sbs_[v].state == SbState::FREE;
+        link_free(v);
+    }
+    fill(stripe_.begin(), stripe_.end(), StripeCursor{});
+    slc_stripe_ = StripeCursor{};
+    slc_fold_queue_.clear();
+    closed_queue_.clear();
+    for (auto &q : closed_by_stream_)
+        q.clear();
+    close_ticks_ = 0;
+    initialized_ = true;
+}
+
+int BlockManager::spare_region_start() const
+{
+    int total = drv_.blocks_per_plane();
+    return total - min(max(0, reserved_spare_), total);
+}
+
+bool BlockManager::vbn_usable(int d, int p, int vbn) const
+{
+    int pbn = resolve_pbn(d, p, vbn);
+    if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, pbn)] || reverse_remap_[d][p][pbn] != vbn)
+        return false;
+    const auto &sp = plane_manager[d][p].reserved_spare_pbns;
+    return find(sp.begin(), sp.end(), pbn) == sp.end();
+}
+
+/* 系统区快照格式（小端）：
+     magic "FTLSYS01" | dies planes blocks reserved_write reserved_spare slc_blocks (uint32)
+     每个 plane：BBT 位图 ceil(blocks/8) 字节 | n_remap (uint32) + n × (vbn, pbn) (uint32)
+                 | n_spare (uint32) + n × pbn (uint32)
+     | FNV-1a 校验 (uint64，覆盖之前全部字节)
+   各池成员不单独存：VBN 在 spare 区之前且 vbn_usable() 即按区间进 slc / free / reserved_write 池
+   日志记录：op (uint8) die plane (uint8) pad (uint8) | vbn a b (int32) | FNV-1a 低 32 位 */
+static const char kSysMagic[8] = {'F', 'T', 'L', 'S', 'Y', 'S', '0', '1'};
+
+static uint64_t fnv1a(const char *p, size_t n, uint64_t h = 1469598103934665603ull)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+struct JournalRecord
+{
+    uint8_t op, die, plane, pad;
+    int32_t vbn, a, b;
+    uint32_t check;
+};
+static_assert(sizeof(JournalRecord) == 20, "journal record layout");
+
+bool BlockManager::save_system_area(const string &path)
+{
+    string buf(kSysMagic, sizeof(kSysMagic));
+    auto put = [&](uint32_t v) { buf.append(reinterpret_cast<const char *>(&v), sizeof(v)); };
+    int blocks = drv_.blocks_per_plane();
+    for (int v : {drv_.dies_per_nand(), drv_.planes_per_die(), blocks, reserved_write_, reserved_spare_, slc_blocks_})
+        put((uint32_t)v);
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+        {
+            string bits((blocks + 7) / 8, '\0');
+            for (int b = 0; b < blocks; ++b)
+                if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+                    bits[b >> 3] |= (char)(1 << (b & 7));
+            buf += bits;
+            vector<pair<int, int>> rm;
+            for (int v = 0; v < blocks; ++v)
+                if (remap_[d][p][v] >= 0)
+                    rm.push_back({v, remap_[d][p][v]});
+            put((uint32_t)rm.size());
+            for (auto [v, b] : rm)
+            {
+                put((uint32_t)v);
+                put((uint32_t)b);
+            }
+            const auto &sp = plane_manager[d][p].reserved_spare_pbns;
+            put((uint32_t)sp.size());
+            for (int b : sp)
+                put((uint32_t)b);
+        }
+    uint64_t h = fnv1a(buf.data(), buf.size());
+    buf.append(reinterpret_cast<const char *>(&h), sizeof(h));
+
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out || !out.write(buf.data(), buf.size()))
+        {
+            LOG_ERROR("[SYS] cannot write " << tmp);
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        LOG_ERROR("[SYS] cannot rename " << tmp);
+        return false;
+    }
+    // 快照已含全部事件：日志从空开始
+    journal_.close();
+    journal_.open(path + ".jnl", ios::binary | ios::trunc);
+    return (bool)journal_;
+}
+
+bool BlockManager::load_system_area(const string &path)
+{
+    MemScope scope(MemComponent::BM_POOLS);
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (buf.size() < sizeof(kSysMagic) + 6 * 4 + 8 || memcmp(buf.data(), kSysMagic, sizeof(kSysMagic)) != 0)
+    {
+        LOG_ERROR("[SYS] bad system area: " << path);
+        return false;
+    }
+    uint64_t h;
+    memcpy(&h, buf.data() + buf.size() - sizeof(h), sizeof(h));
+    if (fnv1a(buf.data(), buf.size() - sizeof(h)) != h)
+    {
+        LOG_ERROR("[SYS] checksum mismatch: " << path);
+        return false;
+    }
+    size_t pos = sizeof(kSysMagic), end = buf.size() - sizeof(h);
+    bool ok = true;
+    auto get = [&]() -> uint32_t
+    {
+        uint32_t v = 0;
+        if (pos + sizeof(v) > end)
+            ok = false;
+        else
+            memcpy(&v, buf.data() + pos, sizeof(v));
+        pos += sizeof(v);
+        return v;
+    };
+    int blocks = drv_.blocks_per_plane();
+    uint32_t hdr[6];
+    for (auto &v : hdr)
+        v = get();
+    if ((int)hdr[0] != drv_.dies_per_nand() || (int)hdr[1] != drv_.planes_per_die() || (int)hdr[2] != blocks ||
+        (int)hdr[3] != reserved_write_ || (int)hdr[4] != reserved_spare_ || (int)hdr[5] != slc_blocks_)
+    {
+        LOG_ERROR("[SYS] geometry / reserved layout mismatch: " << path);
+        return false;
+    }
+
+    // 先解析、重放到临时表里，全部通过后才替换 BBT / remap / 各池：失败时 BlockManager 保持原样
+    int dies = drv_.dies_per_nand(), planes = drv_.planes_per_die();
+    vector<uint8_t> bbt(nand_runtime.bad_block_table.size(), 0);
+    auto remap = remap_, reverse = reverse_remap_;
+    vector<vector<deque<int>>> spares(dies, vector<deque<int>>(planes));
+    for (int d = 0; d < dies && ok; ++d)
+        for (int p = 0; p < planes && ok; ++p)
+        {
+            size_t nbits = (blocks + 7) / 8;
+            if (pos + nbits > end)
+            {
+                ok = false;
+                break;
+            }
+            for (int b = 0; b < blocks; ++b)
+                bbt[nand_runtime.idx(d, p, b)] = (buf[pos + (b >> 3)] >> (b & 7)) & 1;
+            pos += nbits;
+            auto &rm = remap[d][p];
+            auto &rv = reverse[d][p];
+            fill(rm.begin(), rm.end(), -1);
+            iota(rv.begin(), rv.end(), 0);
+            uint32_t n = get();
+            for (uint32_t i = 0; i < n && ok; ++i)
+            {
+                uint32_t v = get(), b = get();
+                if (v >= (uint32_t)blocks || b >= (uint32_t)blocks)
+                {
+                    ok = false;
+                    break;
+                }
+                rm[v] = b;
+                rv[b] = v;
+            }
+            n = get();
+            for (uint32_t i = 0; i < n && ok; ++i)
+            {
+                uint32_t b = get();
+                if (b >= (uint32_t)blocks)
+                    ok = false;
+                else
+                    spares[d][p].push_back((int)b);
+            }
+        }
+    if (!ok || pos != end)
+    {
+        LOG_ERROR("[SYS] truncated system area: " << path);
+        return false;
+    }
+
+    // 重放日志：快照之后的运行时坏块事件（遇到坏记录即停，之前的照常生效）
+    size_t replayed = 0;
+    ifstream jin(path + ".jnl", ios::binary);
+    JournalRecord r;
+    while (jin.read(reinterpret_cast<char *>(&r), sizeof(r)))
+    {
+        if (r.check != (uint32_t)fnv1a(reinterpret_cast<const char *>(&r), offsetof(JournalRecord, check)))
+            break; // 写了一半的尾记录
+        int d = r.die, p = r.plane;
+        if (!valid_plane(d, p) || r.vbn < 0 || r.vbn >= blocks || r.a < 0 || r.a >= blocks || r.b >= blocks ||
+            ((JournalOp)r.op == JournalOp::REMAP && r.b < 0))
+            break;
+        auto &sp = spares[d][p];
+        switch ((JournalOp)r.op)
+        {
+        case JournalOp::REMAP:
+            bbt[nand_runtime.idx(d, p, r.a)] = 1;
+            if (auto it = find(sp.begin(), sp.end(), r.b); it != sp.end())
+                sp.erase(it);
+            remap[d][p][r.vbn] = r.b;
+            reverse[d][p][r.b] = r.vbn;
+            reverse[d][p][r.a] = -1;
+            break;
+        case JournalOp::DROP:
+            bbt[nand_runtime.idx(d, p, r.a)] = 1;
+            break;
+        case JournalOp::SPARE:
+            sp.push_back(r.a);
+            break;
+        case JournalOp::UNSPARE:
+            if (auto it = find(sp.begin(), sp.end(), r.a); it != sp.end())
+                sp.erase(it);
+            break;
+        default:
+            break;
+        }
+        replayed++;
+    }
+
+    // 提交
+    for (size_t i = 0; i < bbt.size(); ++i)
+        nand_runtime.bad_block_table[i] = bbt[i];
+    remap_.swap(remap);
+    reverse_remap_.swap(reverse);
+    for (int d = 0; d < dies; ++d)
+        for (int p = 0; p < planes; ++p)
+        {
+            plane_manager[d][p] = PlaneManager{};
+            plane_manager[d][p].reserved_spare_pbns.swap(spares[d][p]);
+        }
+
+    // 按区间把可用 VBN 放回各池：[ slc | .. normal .. | reserved_write | reserved_spare ]
+    int start_spare = spare_region_start();
+    int start_write = max(0, start_spare - max(0, reserved_write_));
+    slc_blocks_ = min(slc_blocks_, start_write);
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+        {
+            auto &pl = plane_manager[d][p];
+            for (int v = 0; v < start_spare; ++v)
+            {
+                if (!vbn_usable(d, p, v))
+                    continue;
+                if (v >= start_write)
+                    pl.reserved_write_vbns.push_back(v);
+                else
+                    (is_slc_vbn(v) ? pl.slc_free_vbns : pl.free_vbns).push_back(v);
+            }
+            for (int v = 0; v < blocks; ++v)
+                drv_.set_block_slc(d, p, resolve_pbn(d, p, v), is_slc_vbn(v));
+        }
+    build_superblocks();
+    LOG_INFO("[SYS] loaded " << path << " (" << replayed << " journal records)");
+    // 之后的事件接着追加
+    journal_.close();
+    journal_.open(path + ".jnl", ios::binary | ios::app);
+    return true;
+}
+
+void BlockManager::journal(JournalOp op, int d, int p, int vbn, int a, int b)
+{
+    if (!journal_.is_open())
+        return;
+    JournalRecord r{(uint8_t)op, (uint8_t)d, (uint8_t)p, 0, vbn, a, b, 0};
+    r.check = (uint32_t)fnv1a(reinterpret_cast<const char *>(&r), offsetof(JournalRecord, check));
+    journal_.write(reinterpret_cast<const char *>(&r), sizeof(r));
+    journal_.flush();
 }
 
 // 分配一个页（返回 PBA），VBN 由 allocator 维护
@@ -120,6 +460,354 @@ int BlockManager::alloc_page(int die, int plane)
     return pba_from_indices(die, plane, pbn, page);
 }
 
+// 按 page-stripe 顺序分配：同一页号依次跨所有成员 lane，写满后再到下一页号
+int BlockManager::alloc_stripe_page(bool slc, int stream)
+{
+    auto &cur = cursor(slc, stream);
+    int ppb = slc ? drv_.slc_pages_per_block() : drv_.pages_per_block();
+    if (cur.sb == -1 || cur.page >= ppb)
+    {
+        if (cur.sb != -1)
+        {
+            // 写满：原生条带成为 GC 候选，SLC 条带进入 folding 队列
+            close_superblock(cur.sb);
+        }
+        cur = StripeCursor{};
+        cur.sb = alloc_superblock(slc);
+        if (cur.sb == -1)
+            return -1;
+        sbs_[cur.sb].stream = slc ? 0 : stream;
+    }
+
+    auto [d, p] = sbs_[cur.sb].members[cur.lane];
+    int pba = pba_from_indices(d, p, resolve_pbn(d, p, cur.sb), cur.page);
+    if (++cur.lane >= sbs_[cur.sb].members.size())
+    {
+        cur.lane = 0;
+        cur.page++;
+    }
+    return pba;
+}
+
+// 挑一个 FREE 超级块：先非 reserved，再按可用 lane 数（宽度）降序，再按平均擦除次数升序（即有序索引的队首）
+int BlockManager::alloc_superblock(bool slc)
+{
+    MemScope scope(MemComponent::BM_SUPERBLOCKS);
+    auto &order = free_order_[slc ? 1 : 0];
+    if (order.empty())
+        return -1;
+    int best = get<3>(*order.begin());
+    unlink_free(best);
+
+    auto &sb = sbs_[best];
+    if (sb.reserved)
+        reserved_allocs_++;
+    sb.reserved = false;
+    // 各 lane 池里的队列项就此失效（条带不再空闲），不逐个出队
+    sb.members.clear();
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+            if (sb.lane_ok[lane_of(d, p)])
+                sb.members.push_back({d, p});
+    sb.state = SbState::OPEN;
+    return best;
+}
+
+// 空闲条带进入有序索引：键按当前各可用 lane 的擦除次数算
+void BlockManager::link_free(int vbn)
+{
+    auto &sb = sbs_[vbn];
+    if (sb.state != SbState::FREE || get<3>(free_key_[vbn]) != -1)
+        return;
+    MemScope scope(MemComponent::BM_SUPERBLOCKS);
+    uint64_t ec = 0;
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+            if (sb.lane_ok[lane_of(d, p)])
+                ec += nand_runtime.erase_count[nand_runtime.idx(d, p, resolve_pbn(d, p, vbn))];
+    int slc = is_slc_vbn(vbn) ? 1 : 0;
+    free_key_[vbn] = FreeKey{sb.reserved, -sb.lane_cnt, (double)ec / sb.lane_cnt, vbn};
+    free_order_[slc].insert(free_key_[vbn]);
+    free_sbs_[slc]++;
+    free_lanes_[slc] += sb.lane_cnt;
+    if (sb.reserved)
+    {
+        reserved_free_++;
+        reserved_lanes_ += sb.lane_cnt;
+    }
+}
+
+void BlockManager::unlink_free(int vbn)
+{
+    auto &key = free_key_[vbn];
+    if (get<3>(key) == -1)
+        return;
+    int slc = is_slc_vbn(vbn) ? 1 : 0;
+    free_order_[slc].erase(key);
+    free_sbs_[slc]--;
+    free_lanes_[slc] += get<1>(key);
+    if (get<0>(key))
+    {
+        reserved_free_--;
+        reserved_lanes_ += get<1>(key);
+    }
+    get<3>(key) = -1;
+}
+
+void BlockManager::relink_free(int vbn)
+{
+    unlink_free(vbn);
+    link_free(vbn);
+}
+
+void BlockManager::refresh_free_order()
+{
+    for (int v = 0; v < (int)sbs_.size(); ++v)
+        if (get<3>(free_key_[v]) != -1)
+            relink_free(v);
+}
+
+deque<int> &BlockManager::pool(int d, int p, int kind)
+{
+    auto &pl = plane_manager[d][p];
+    return kind == POOL_SLC ? pl.slc_free_vbns : kind == POOL_RESERVED ? pl.reserved_write_vbns : pl.free_vbns;
+}
+
+bool BlockManager::in_pool(int d, int p, int vbn, int kind) const
+{
+    const auto &sb = sbs_[vbn];
+    return sb.state == SbState::FREE && sb.lane_ok[lane_of(d, p)] && pool_kind(vbn) == kind;
+}
+
+void BlockManager::pool_push(int d, int p, int vbn, int kind)
+{
+    MemScope scope(MemComponent::BM_POOLS);
+    auto &bits = plane_manager[d][p].queued[vbn];
+    if (bits & (1 << kind))
+        return;
+    bits |= (uint8_t)(1 << kind);
+    pool(d, p, kind).push_back(vbn);
+}
+
+int BlockManager::pool_size(int d, int p, int kind) const
+{
+    int n = 0;
+    for (int v : pool(d, p, kind))
+        n += in_pool(d, p, v, kind) ? 1 : 0;
+    return n;
+}
+
+int BlockManager::take_superblock()
+{
+    int sb = alloc_superblock(false);
+    if (sb != -1)
+        sbs_[sb].stream = 0;
+    return sb;
+}
+
+void BlockManager::close_superblock(int sb_id)
+{
+    MemScope scope(MemComponent::BM_SUPERBLOCKS);
+    auto &sb = sbs_[sb_id];
+    if (is_slc_vbn(sb_id))
+    {
+        sb.state = SbState::SLC_FULL;
+        slc_fold_queue_.push_back(sb_id);
+        return;
+    }
+    sb.state = SbState::CLOSED;
+    sb.close_seq = close_ticks_++;
+    closed_queue_.push_back(sb_id);
+    closed_by_stream_[sb.stream].push_back(sb_id);
+}
+
+void BlockManager::set_write_streams(int n)
+{
+    n = max(n, 1);
+    // 缩减时关掉多出来的流的 open 条带
+    for (int s = n; s < (int)stripe_.size(); ++s)
+        if (stripe_[s].sb != -1)
+            close_superblock(stripe_[s].sb);
+    stripe_.resize(n);
+    closed_by_stream_.resize(max(n, (int)closed_by_stream_.size()));
+}
+
+// 不再开新条带之外还能写的页数（open 条带剩余 + 各空闲条带按可用 lane 数计，坏块退出的 lane 不算）
+int BlockManager::stripe_room(bool slc, int stream) const
+{
+    int ppb = slc ? drv_.slc_pages_per_block() : drv_.pages_per_block();
+    return open_stripe_room(slc, stream) + free_lanes_[slc ? 1 : 0] * ppb;
+}
+
+// reserved_write 池里空闲条带的页数（按可用 lane 数计）
+int BlockManager::reserved_room() const
+{
+    return reserved_lanes_ * drv_.pages_per_block();
+}
+
+int BlockManager::open_stripe_room(bool slc, int stream) const
+{
+    const auto &cur = cursor(slc, stream);
+    int ppb = slc ? drv_.slc_pages_per_block() : drv_.pages_per_block();
+    if (cur.sb == -1 || cur.page >= ppb)
+        return 0;
+    return (ppb - cur.page) * (int)sbs_[cur.sb].members.size() - (int)cur.lane;
+}
+
+// 条带所有成员擦除完成后归还（坏掉且无 spare 的 lane 退出）
+void BlockManager::release_superblock(int sb_id)
+{
+    MemScope scope(MemComponent::BM_POOLS);
+    auto &sb = sbs_[sb_id];
+    auto it = find(slc_fold_queue_.begin(), slc_fold_queue_.end(), sb_id);
+    if (it != slc_fold_queue_.end())
+        slc_fold_queue_.erase(it);
+    it = find(closed_queue_.begin(), closed_queue_.end(), sb_id);
+    if (it != closed_queue_.end())
+    {
+        closed_queue_.erase(it);
+        auto &q = closed_by_stream_[sb.stream];
+        q.erase(find(q.begin(), q.end(), sb_id));
+    }
+    for (auto &cur : stripe_)
+        if (cur.sb == sb_id)
+            cur = StripeCursor{};
+    if (slc_stripe_.sb == sb_id)
+        slc_stripe_ = StripeCursor{};
+    for (auto [d, p] : sb.members)
+    {
+        int pbn = resolve_pbn(d, p, sb_id);
+        if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, pbn)])
+        {
+            if (sb.lane_ok[lane_of(d, p)])
+            {
+                sb.lane_ok[lane_of(d, p)] = 0;
+                sb.lane_cnt--;
+            }
+            continue;
+        }
+        pool_push(d, p, sb_id, pool_kind(sb_id));
+    }
+    sb.members.clear();
+    sb.state = sb.lane_cnt > 0 ? SbState::FREE : SbState::DEAD;
+    link_free(sb_id);
+    // reserved_write 池不足目标时，回收的条带先补进池里
+    if (sb.state == SbState::FREE && !is_slc_vbn(sb_id) && reserved_free_ < reserve_target_)
+        set_sb_reserved(sb_id, true);
+}
+
+void BlockManager::set_sb_reserved(int sb_id, bool reserved)
+{
+    MemScope scope(MemComponent::BM_POOLS);
+    auto &sb = sbs_[sb_id];
+    if (sb.state != SbState::FREE || is_slc_vbn(sb_id) || sb.reserved == reserved)
+        return;
+    // 原池里的队列项随池别变化自动失效
+    unlink_free(sb_id);
+    sb.reserved = reserved;
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+            if (sb.lane_ok[lane_of(d, p)])
+                pool_push(d, p, sb_id, pool_kind(sb_id));
+    link_free(sb_id);
+}
+
+// 补足时取满宽、VBN 最大的空闲条带（与初始布局一致，reserved 区在高端）；缩减时先还 VBN 最小的
+void BlockManager::set_reserved_write(int superblocks)
+{
+    reserve_target_ = max(0, superblocks);
+    while (reserved_free_ != reserve_target_)
+    {
+        bool grow = reserved_free_ < reserve_target_;
+        int best = -1;
+        for (int v = 0; v < (int)sbs_.size(); ++v)
+        {
+            const auto &sb = sbs_[v];
+            if (sb.state != SbState::FREE || is_slc_vbn(v) || sb.reserved == grow)
+                continue;
+            if (best == -1 || (grow && sb.lane_cnt >= sbs_[best].lane_cnt))
+                best = v;
+        }
+        if (best == -1)
+            break;
+        set_sb_reserved(best, grow);
+    }
+}
+
+void BlockManager::detach_lane(int d, int p, int vbn)
+{
+    auto &sb = sbs_[vbn];
+    if (!sb.lane_ok[lane_of(d, p)])
+        return;
+    unlink_free(vbn);
+    sb.lane_ok[lane_of(d, p)] = 0;
+    sb.lane_cnt--;
+    if (sb.state == SbState::FREE && sb.lane_cnt == 0)
+    {
+        sb.state = SbState::DEAD;
+        sb.reserved = false;
+    }
+    link_free(vbn);
+}
+
+void BlockManager::attach_lane(int d, int p, int vbn)
+{
+    auto &sb = sbs_[vbn];
+    if (sb.lane_ok[lane_of(d, p)])
+        return;
+    unlink_free(vbn);
+    sb.lane_ok[lane_of(d, p)] = 1;
+    sb.lane_cnt++;
+    if (sb.state == SbState::DEAD)
+        sb.state = SbState::FREE;
+    link_free(vbn);
+}
+
+void BlockManager::drop_member(int d, int p, int vbn)
+{
+    auto &sb = sbs_[vbn];
+    auto it = find(sb.members.begin(), sb.members.end(), make_pair(d, p));
+    if (it != sb.members.end())
+    {
+        size_t pos = it - sb.members.begin();
+        sb.members.erase(it);
+        // 修正正在写该条带的游标
+        vector<StripeCursor *> curs{&slc_stripe_};
+        for (auto &c : stripe_)
+            curs.push_back(&c);
+        for (auto *pc : curs)
+        {
+            auto &cur = *pc;
+            if (cur.sb != vbn)
+                continue;
+            if (sb.members.empty())
+            {
+                cur.page = INT_MAX; // 下次分配换条带
+                continue;
+            }
+            if (pos < cur.lane)
+                cur.lane--;
+            if (cur.lane >= sb.members.size())
+            {
+                cur.lane = 0;
+                cur.page++;
+            }
+        }
+    }
+    if (sb.lane_ok[lane_of(d, p)])
+    {
+        unlink_free(vbn);
+        sb.lane_ok[lane_of(d, p)] = 0;
+        sb.lane_cnt--;
+        if (sb.state == SbState::FREE && sb.lane_cnt == 0)
+        {
+            sb.state = SbState::DEAD;
+            sb.reserved = false;
+        }
+        link_free(vbn);
+    }
+}
+
 // 分配一个块（返回VBN），用于GC等操作
 int BlockManager::alloc_block(int die, int plane)
 {
@@ -145,27 +833,83 @@ int BlockManager::alloc_block(int die, int plane)
 // GC/擦除完成后把该 **PBN** 所属的 VBN 送回 free（按身份或 remap 逆向）
 void BlockManager::on_erase_complete(int die, int plane, int pbn)
 {
+    MemScope scope(MemComponent::BM_POOLS);
     int vbn = reverse_resolve_vbn(die, plane, pbn);
     if (vbn < 0)
         return;
-    plane_manager[die][plane].free_vbns.push_back(vbn);
+    attach_lane(die, plane, vbn);
+    pool_push(die, plane, vbn, pool_kind(vbn));
+    // 擦除次数变了：已在索引里的空闲条带按新值重排
+    relink_free(vbn);
 }
 
 // 如果 open_vbn 被涉及（比如它对应的 PBN 标坏），丢弃 open
 void BlockManager::drop_open_if_matches(int die, int plane, int pbn_or_vbn, bool input_is_pbn)
 {
     auto &pl = plane_manager[die][plane];
-    if (pl.open_vbn == -1)
-        return;
-    int cur_pbn = resolve_pbn(die, plane, pl.open_vbn);
     int x = input_is_pbn ? pbn_or_vbn : resolve_pbn(die, plane, pbn_or_vbn);
-    if (cur_pbn == x)
+    if (pl.open_vbn != -1 && resolve_pbn(die, plane, pl.open_vbn) == x)
     {
         pl.open_vbn = -1;
         pl.next_page_on_open_pbn = 0;
     }
 }
 
+// 上电重建：该 PBN 上已有数据，从 free/reserved/spare 池中摘除（open 指向它则丢弃）
+void BlockManager::claim_used_pbn(int die, int plane, int pbn)
+{
+    if (!valid_plane(die, plane))
+        return;
+    auto &pl = plane_manager[die][plane];
+    auto drop = [](deque<int> &q, int x)
+    {
+        auto it = find(q.begin(), q.end(), x);
+        if (it != q.end())
+            q.erase(it);
+    };
+    drop(pl.reserved_spare_pbns, pbn);
+    int vbn = reverse_resolve_vbn(die, plane, pbn);
+    if (vbn < 0 || resolve_pbn(die, plane, vbn) != pbn)
+        return;
+    drop_open_if_matches(die, plane, pbn, true);
+
+    // 所属超级块整体视为已写满：成员为所有可用 lane，交给 GC / folding 回收
+    auto &sb = sbs_[vbn];
+    if (sb.state != SbState::FREE)
+        return;
+    vector<pair<int, int>> members;
+    for (int d = 0; d < drv_.dies_per_nand(); ++d)
+        for (int p = 0; p < drv_.planes_per_die(); ++p)
+            if (sb.lane_ok[lane_of(d, p)])
+                members.push_back({d, p});
+    close_free_superblock(vbn, 0, members);
+}
+
+// 检查点恢复：成员与写入流按保存时的记录，条带年龄接着保存时的写满时刻
+bool BlockManager::restore_superblock(int vbn, int stream, uint64_t close_seq, const vector<pair<int, int>> &members)
+{
+    if (vbn < 0 || vbn >= (int)sbs_.size() || sbs_[vbn].state != SbState::FREE || members.empty() || stream < 0 ||
+        stream >= (int)closed_by_stream_.size())
+        return false;
+    for (auto [d, p] : members)
+        if (!valid_plane(d, p) || !sbs_[vbn].lane_ok[lane_of(d, p)])
+            return false;
+    close_ticks_ = max(close_ticks_, close_seq);
+    close_free_superblock(vbn, stream, members);
+    return true;
+}
+
+// 把一个 FREE 超级块直接记为写满（各 lane 池里的队列项随之失效）
+void BlockManager::close_free_superblock(int vbn, int stream, const vector<pair<int, int>> &members)
+{
+    auto &sb = sbs_[vbn];
+    unlink_free(vbn);
+    sb.members = members;
+    sb.reserved = false;
+    sb.stream = stream;
+    close_superblock(vbn);
+}
+
 // 运行时坏块替换：对 "坏的 PBN" 找到其 VBN 并 remap 到一个新的 spare PBN
 bool BlockManager::remap_grown_bad(int die, int plane, int bad_pbn)
 {
@@ -175,24 +919,60 @@ bool BlockManager::remap_grown_bad(int die, int plane, int bad_pbn)
     // 取一个新的 spare PBN
     int spare = take_spare_pbn(die, plane);
     // 如果没有备用块，尝试动态分配备用块
-    if (spare == -1) {
-        if (!dynamic_allocate_spare_block(die, plane)) {
-            return false;
-        }
+    if (spare == -1 && dynamic_allocate_spare_block(die, plane))
         spare = take_spare_pbn(die, plane);
-        if (spare == -1) {
-            return false;
-        }
+    if (spare == -1) {
+        // 无 spare：该 lane 退出所属超级块
+        journal(JournalOp::DROP, die, plane, vbn, bad_pbn, -1);
+        drop_member(die, plane, vbn);
+        trace_remap(die, plane, bad_pbn, -1);
+        return false;
     }
+    journal(JournalOp::REMAP, die, plane, vbn, bad_pbn, spare);
     remap_[die][plane][vbn] = spare;
     reverse_remap_[die][plane][spare] = vbn; // 更新反向映射
     reverse_remap_[die][plane][bad_pbn] = -1; // 清除旧的反向映射
+    relink_free(vbn); // 换了物理块，擦除次数跟着变
+    drv_.set_block_slc(die, plane, spare, is_slc_vbn(vbn));
     // 如果 open 指向该 VBN，丢弃（由上层重新分配）
     drop_open_if_matches(die, plane, vbn, /*input_is_pbn=*/false);
+    trace_remap(die, plane, bad_pbn, spare);
     return true;
 }
 
+// 坏块在触发它的操作完成时被发现：时间戳取该 die 的 busy-until
+void BlockManager::trace_remap(int die, int plane, int bad_pbn, int new_pbn)
+{
+    if (!trace_enabled())
+        return;
+    TraceRecord r;
+    r.kind = TraceKind::REMAP;
+    r.ts_ns = drv_.die_busy_until(die);
+    r.die = die;
+    r.plane = plane;
+    r.block = bad_pbn;
+    r.arg0 = new_pbn;
+    Tracer::instance().record(r);
+}
+
 // 调试
+int BlockManager::spare_blocks_left() const
+{
+    int n = 0;
+    for (auto &die : plane_manager)
+        for (auto &pl : die)
+            n += (int)pl.reserved_spare_pbns.size();
+    return n;
+}
+
+int BlockManager::data_blocks() const
+{
+    int n = 0;
+    for (int v = slc_blocks_; v < (int)sbs_.size(); ++v)
+        n += sbs_[v].lane_cnt;
+    return n;
+}
+
 void BlockManager::dump_alloc_state()
 {
     for (int d = 0; d < drv_.dies_per_nand(); ++d)
@@ -202,39 +982,25 @@ void BlockManager::dump_alloc_state()
             auto &pl = plane_manager[d][p];
             cout << "[ALLOC] die" << d << "/plane" << p
                  << " open_vbn=" << pl.open_vbn << " nextp=" << pl.next_page_on_open_pbn
-                 << " freeV=" << pl.free_vbns.size()
-                 << " resW=" << pl.reserved_write_vbns.size()
-                 << " resS=" << pl.reserved_spare_pbns.size()
-                 << "\n";
+                 << " freeV=" << pool_size(d, p, POOL_FREE)
+                 << " resW=" << pool_size(d, p, POOL_RESERVED)
+                 << " resS=" << pl.reserved_spare_pbns.size();
+            if (slc_blocks_ > 0)
+                cout << " slcF=" << pool_size(d, p, POOL_SLC);
+            cout << "\n";
         }
     }
+    cout << "[ALLOC] superblocks open=" << stripe_[0].sb << " stripe_page=" << stripe_[0].page
+         << " freeSB=" << free_sbs_[0];
+    for (int s = 1; s < (int)stripe_.size(); ++s)
+        cout << " open[" << s << "]=" << stripe_[s].sb;
+    if (slc_blocks_ > 0)
+        cout << " slc_open=" << slc_stripe_.sb << " slcFreeSB=" << free_sbs_[1]
+             << " fold_q=" << slc_fold_queue_.size();
+    cout << "\n";
 }
 
 // —— 提供给上层的工具 —— //
-int BlockManager::resolve_pbn(int d, int p, int vbn) const
-{
-    int r = remap_[d][p][vbn];
-    return (r >= 0 ? r : vbn);
-}
-
-int BlockManager::pba_from_indices(int d, int p, int b, int g) const
-{
-    int pages_per_plane = drv_.pages_per_block() * drv_.blocks_per_plane();
-    int pages_per_die = pages_per_plane * drv_.planes_per_die();
-    return d * pages_per_die + p * pages_per_plane + b * drv_.pages_per_block() + g;
-}
-
-tuple<int, int, int, int> BlockManager::idx_from_pba(int pba) const
-{
-    int ppb = drv_.pages_per_block(), bpp = drv_.blocks_per_plane(), ppd = drv_.planes_per_die();
-    int pplane = ppb * bpp, pdie = pplane * ppd;
-    int d = pba / pdie;
-    int p = (pba % pdie) / pplane;
-    int b = (pba % pplane) / ppb;
-    int g = pba % ppb;
-    return {d, p, b, g};
-}
-
 bool BlockManager::valid_plane(int d, int p) const { return d >= 0 && d < drv_.dies_per_nand() && p >= 0 && p < drv_.planes_per_die(); }
 
 // 使用页状态判断块是否空
@@ -274,6 +1040,21 @@ int BlockManager::reverse_resolve_vbn(int d, int p, int pbn) const
 // wear-aware：在 VBN 列表里挑 erase_count 最小者（按当前 PBN）
 int BlockManager::pick_vbn_wear_aware(deque<int> &vbns, int d, int p)
 {
+    // lane 池：先清掉已失效的队列项（条带分配 / 转池时没有出队）
+    auto &pl = plane_manager[d][p];
+    int kind = &vbns == &pl.free_vbns ? POOL_FREE
+               : &vbns == &pl.reserved_write_vbns ? POOL_RESERVED
+               : &vbns == &pl.slc_free_vbns ? POOL_SLC : -1;
+    if (kind != -1)
+        vbns.erase(remove_if(vbns.begin(), vbns.end(),
+                             [&](int v)
+                             {
+                                 if (in_pool(d, p, v, kind))
+                                     return false;
+                                 pl.queued[v] &= (uint8_t)~(1 << kind);
+                                 return true;
+                             }),
+                   vbns.end());
     if (vbns.empty())
         return -1;
     int best_pos = -1, best_v = -1;
@@ -295,6 +1076,10 @@ int BlockManager::pick_vbn_wear_aware(deque<int> &vbns, int d, int p)
     if (best_pos == -1)
         return -1;
     vbns.erase(vbns.begin() + best_pos);
+    if (kind != -1)
+        pl.queued[best_v] &= (uint8_t)~(1 << kind);
+    // 该 VBN 在此 lane 上不再归超级块池所有
+    detach_lane(d, p, best_v);
     return best_v;
 }
 
@@ -306,26 +1091,42 @@ bool BlockManager::dynamic_allocate_spare_block(int die, int plane)
     
     auto& pl = plane_manager[die][plane];
     
-    // 如果没有空闲块，无法分配备用块
-    if (pl.free_vbns.empty() && pl.reserved_write_vbns.empty())
-        return false;
-    
-    // 优先从free_vbns中分配
-    int vbn = -1;
-    if (!pl.free_vbns.empty()) {
-        // 选择擦除次数最少的块
-        vbn = pick_vbn_wear_aware(pl.free_vbns, die, plane);
-    } else if (!pl.reserved_write_vbns.empty()) {
-        // 如果free_vbns为空，则从reserved_write_vbns中分配
+    // 优先从free_vbns中分配（选择擦除次数最少的块）；free 池没有可用块时从reserved_write_vbns中分配
+    int vbn = pick_vbn_wear_aware(pl.free_vbns, die, plane);
+    if (vbn == -1)
         vbn = pick_vbn_wear_aware(pl.reserved_write_vbns, die, plane);
-    }
     
     if (vbn == -1)
         return false;
     
     // 将选中的VBN对应的物理块添加到备用池
     int pbn = resolve_pbn(die, plane, vbn);
+    journal(JournalOp::SPARE, die, plane, vbn, pbn, -1);
     pl.reserved_spare_pbns.push_back(pbn);
     
     return true;
+}
+
+bool BlockManager::release_spare_block(int die, int plane)
+{
+    if (!valid_plane(die, plane))
+        return false;
+    auto &pl = plane_manager[die][plane];
+    int lane = lane_of(die, plane);
+    // 只还由数据池转入的块：VBN 仍指向它、该 lane 上 VBN 空着、条带没在用
+    for (auto it = pl.reserved_spare_pbns.begin(); it != pl.reserved_spare_pbns.end(); ++it)
+    {
+        int pbn = *it;
+        int vbn = reverse_resolve_vbn(die, plane, pbn);
+        if (vbn < 0 || vbn >= spare_region_start() || is_slc_vbn(vbn) || resolve_pbn(die, plane, vbn) != pbn ||
+            nand_runtime.bad_block_table[nand_runtime.idx(die, plane, pbn)] || sbs_[vbn].lane_ok[lane] ||
+            (sbs_[vbn].state != SbState::FREE && sbs_[vbn].state != SbState::DEAD))
+            continue;
+        pl.reserved_spare_pbns.erase(it);
+        journal(JournalOp::UNSPARE, die, plane, vbn, pbn, -1);
+        attach_lane(die, plane, vbn);
+        pool_push(die, plane, vbn, pool_kind(vbn));
+        return true;
+    }
+    return false;
 }
\ No newline at end of file
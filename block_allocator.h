@@ -5,6 +5,7 @@
 #include "nand_model.h"
 #include "nand_runtime.h"
 #include "nand_driver.h"
+#include "trace.h"
 using namespace std;
 
 /* ---------------- BlockManager with BAD BLOCK TABLE ----------------
@@ -12,6 +13,10 @@ using namespace std;
    - reserved_write: normal reserved for writes
    - reserved_spare: only for BAD BLOCK TABLE
    - free list holds VBNs; open_block is VBN; pba组装时用 resolve_pbn()
+   - slc: 可选 SLC 缓存区（每 plane 最前面的 slc_blocks 个 VBN），独立的 free 列表
+   - superblock: 同一 VBN 号跨所有 (die, plane) lane 组成一个条带，按条带分配/擦除；
+     某 lane 的成员坏掉时按 lane 从 spare 池 remap（VBN 不变），无 spare 则该 lane 退出条带
+   - write stream: 原生条带可按流（如每个 namespace 一个）各开一个 open 条带，条带记住所属流
    VBN:Virtual Block Number (0..blocks-1)
    PBN:Physical Block Number
 */
@@ -28,16 +33,89 @@ public:
 
         int open_vbn = -1;
         int next_page_on_open_pbn = 0;
+
+        // SLC 缓存区（VBN 列表）
+        deque<int> slc_free_vbns;
+
+        // [vbn] 位 k：该 VBN 在第 k 个队列里有一项（0 free / 1 reserved_write / 2 slc）。
+        // 条带分配、转池不逐个出队：队列项只在条带空闲、该 lane 可用且池别相符时有效，挑选时顺带清掉陈旧项
+        vector<uint8_t> queued;
+    };
+
+    enum class SbState
+    {
+        FREE,     // 各成员 VBN 在 lane 的 free/reserved/slc 列表里
+        OPEN,     // 条带正在写
+        CLOSED,   // 写满，GC 候选
+        SLC_FULL, // SLC 条带写满，等待 folding
+        DEAD      // 没有可用 lane
+    };
+
+    struct Superblock
+    {
+        SbState state = SbState::DEAD;
+        bool reserved = false;         // 来自 reserved_write 区：最后才分配
+        uint64_t close_seq = 0;        // 写满（CLOSED）时的 close_ticks，用于计算条带年龄
+        int stream = 0;                // 分配给哪个写入流
+        int lane_cnt = 0;              // lane_ok 中为 true 的个数
+        vector<uint8_t> lane_ok;       // [lane] 该 lane 上此 VBN 可用
+        vector<pair<int, int>> members; // 分配时确定的 (die, plane)，条带按此顺序写
     };
+    // 空闲条带的分配顺序：(reserved, -可用 lane 数, 平均擦除次数, vbn)
+    using FreeKey = tuple<bool, int, double, int>;
 
-    BlockManager(NandDriver &drv, NandRuntime &rt, int reserved_write_per_plane, int reserved_spare_per_plane);
+    BlockManager(NandDriver &drv, NandRuntime &rt, int reserved_write_per_plane, int reserved_spare_per_plane,
+                 int slc_blocks_per_plane = 0);
 
-    // 初始化：构建 BAD BLOCK TABLE 前的列表，随后对 FACTORY BAD BLOCK 做 remap
+    // 初始化：构建 BAD BLOCK TABLE 前的列表，随后对 FACTORY BAD BLOCK 做 remap（每块只探测一次）
     void init_from_bbt(function<bool(int, int, int)> is_bad_block);
+    // 已由 init_from_bbt 或 load_system_area 初始化（FTL 据此跳过逐块探测）
+    bool initialized() const { return initialized_; }
+
+    // —— 系统区：BBT + remap 表 + spare 池的快照，外加运行时坏块的追加日志（<path>.jnl） —— //
+    // 载入快照并重放日志，一遍建好各池与超级块表；不存在或不匹配返回 false（调用方走 init_from_bbt）
+    bool load_system_area(const string &path);
+    // 写快照（先写临时文件再 rename）并清空日志；之后的 remap 事件追加到日志
+    bool save_system_area(const string &path);
 
     // 分配一个页（返回 PBA），VBN 由 allocator 维护
     int alloc_page(int die, int plane);
     
+    // —— 超级块 —— //
+    // 按 page-stripe 顺序分配：同一页号依次跨所有成员 lane，写满后再到下一页号
+    // stream：原生条带的写入流（各流独立 open 条带）；SLC 缓存只有一个流
+    int alloc_stripe_page(bool slc = false, int stream = 0);
+    // 原生写入流个数（默认 1）；应在分配前设置
+    void set_write_streams(int n);
+    int write_streams() const { return (int)stripe_.size(); }
+    int superblock_stream(int sb) const { return sbs_[sb].stream; }
+    int superblock_count() const { return (int)sbs_.size(); }
+    SbState superblock_state(int sb) const { return sbs_[sb].state; }
+    const vector<pair<int, int>> &superblock_members(int sb) const { return sbs_[sb].members; }
+    int free_superblocks(bool slc = false) const { return free_sbs_[slc ? 1 : 0]; }
+    // 不再开新条带之外还能写的页数（该流 open 条带剩余 + 空闲条带按可用 lane 数计）
+    int stripe_room(bool slc = false, int stream = 0) const;
+    // 其中 reserved_write 池空闲条带的页数
+    int reserved_room() const;
+    // 该流 open 条带里还能分配的页数（再分配不会开新条带）
+    int open_stripe_room(bool slc = false, int stream = 0) const;
+    // 已写满的原生条带（GC 候选），按写满先后排列（队首最老）；带 stream 时只含该流的条带
+    const deque<int> &closed_superblocks() const { return closed_queue_; }
+    const deque<int> &closed_superblocks(int stream) const { return closed_by_stream_[stream]; }
+    uint64_t superblock_close_seq(int sb) const { return sbs_[sb].close_seq; }
+    // 原生条带写满次数，作为条带年龄的时钟
+    uint64_t close_ticks() const { return close_ticks_; }
+    // 已写满、等待 folding 的 SLC 条带，按写满先后排列（队首最老；release 后出队）
+    const deque<int> &slc_full_superblocks() const { return slc_fold_queue_; }
+    // 条带所有成员擦除完成后归还（坏掉且无 spare 的 lane 退出）
+    void release_superblock(int sb);
+    // ZNS：直接取一个 FREE 原生超级块（OPEN，不挂在任何写入流上），调用方按成员顺序自行写页；
+    // 用完擦除后 release_superblock 归还。无空闲返回 -1
+    int take_superblock();
+
+    int slc_blocks_per_plane() const { return slc_blocks_; }
+    bool is_slc_vbn(int vbn) const { return vbn >= 0 && vbn < slc_blocks_; }
+
     // 分配一个块（返回VBN），用于GC等操作
     int alloc_block(int die, int plane);
 
@@ -47,29 +125,135 @@ public:
     // 如果 open_vbn 被涉及（比如它对应的 PBN 标坏），丢弃 open
     void drop_open_if_matches(int die, int plane, int pbn_or_vbn, bool input_is_pbn = true);
 
+    // 上电重建：该 PBN 上已有数据，从 free/reserved/spare 池中摘除（open 指向它则丢弃）
+    void claim_used_pbn(int die, int plane, int pbn);
+    // 检查点恢复：把 FREE 超级块 vbn 按保存时的成员 / 写入流记为写满，写满时刻取 close_seq
+    // （原生条带须按 close_seq 升序调用）；超级块不空闲或成员 lane 已不可用返回 false，不做任何改动
+    bool restore_superblock(int vbn, int stream, uint64_t close_seq, const vector<pair<int, int>> &members);
+    // 检查点恢复完毕：条带年龄时钟接着保存时的值走
+    void restore_close_ticks(uint64_t t) { close_ticks_ = max(close_ticks_, t); }
+
     // 运行时坏块替换：对 "坏的 PBN" 找到其 VBN 并 remap 到一个新的 spare PBN
     bool remap_grown_bad(int die, int plane, int bad_pbn);
+    // 各 plane spare 池剩余块数之和（坏块替换的余量）
+    int spare_blocks_left() const;
+    int spare_blocks(int die, int plane) const { return (int)plane_manager[die][plane].reserved_spare_pbns.size(); }
+    // 原生条带可用的块数（各条带可用 lane 之和），即原生数据区的物理容量
+    int data_blocks() const;
+    // 从该 plane 的 free / reserved_write 池取一个块转入 spare 池（擦除次数最少者）
+    bool dynamic_allocate_spare_block(int die, int plane);
+    // 反向：把一个由数据池转入的 spare 块还给 free 池（其 VBN 须仍指向它且条带空闲）
+    bool release_spare_block(int die, int plane);
+
+    // —— 运行时 reserved_write 池 —— //
+    // 保持 n 个空闲原生条带为 reserved（最后分配；条带回收时优先补回池里）；0 = 不再补充。
+    // 初始目标为构造时的 reserved_write_per_plane（每 plane 一块即一个条带）
+    void set_reserved_write(int superblocks);
+    int reserved_write() const { return reserve_target_; }
+    // 空闲且 reserved 的原生条带数；reserved_allocs：不得不从 reserved 条带分配的次数
+    int reserved_free() const { return reserved_free_; }
+    uint64_t reserved_allocs() const { return reserved_allocs_; }
+
+    // 擦除次数被外部改写（如 precondition）后，按新的擦除次数重排空闲条带
+    void refresh_free_order();
 
     // 调试
     void dump_alloc_state();
 
 
     // —— 提供给上层的工具 —— //
-    int resolve_pbn(int d, int p, int vbn) const;
-    int pba_from_indices(int d, int p, int b, int g) const;
-    tuple<int, int, int, int> idx_from_pba(int pba) const;
+    int resolve_pbn(int d, int p, int vbn) const
+    {
+        int r = remap_[d][p][vbn];
+        return (r >= 0 ? r : vbn);
+    }
+    int pba_from_indices(int d, int p, int b, int g) const { return geo_.pba(d, p, b, g); }
+    tuple<int, int, int, int> idx_from_pba(int pba) const { return geo_.unpack(pba); }
+    // PBN -> 所属 VBN（即超级块号）；不属于任何 VBN 返回 -1
+    int vbn_of(int d, int p, int pbn) const { return reverse_resolve_vbn(d, p, pbn); }
 
 private:
+    friend struct MicrobenchAccess; // ftl_microbench 直接测量私有热点函数
     NandDriver &drv_;
+    const NandGeometry geo_; // 几何在构造时拷贝，地址换算不再经由 driver
     NandRuntime &nand_runtime;
     int reserved_write_; // per plane
     int reserved_spare_; // per plane (BAD BLOCK TABLE pool)
+    int slc_blocks_;     // per plane (SLC cache region)
     vector<vector<PlaneManager>> plane_manager;
     // remap: [die][plane][vbn] -> pbn (or -1)
     vector<vector<vector<int>>> remap_;
     // 反向映射: [die][plane][pbn] -> vbn (用于O(1)查找)
     vector<vector<vector<int>>> reverse_remap_;
 
+    // 超级块表：[vbn]；条带游标：原生按写入流 stripe_[stream]，SLC 一个
+    struct StripeCursor
+    {
+        int sb = -1;
+        int page = 0;
+        size_t lane = 0;
+    };
+    vector<Superblock> sbs_;
+    vector<StripeCursor> stripe_ = vector<StripeCursor>(1);
+    StripeCursor slc_stripe_;
+    int free_sbs_[2] = {0, 0};
+    int reserve_target_ = 0;
+    int reserved_free_ = 0;
+    // 空闲条带按分配顺序排好（FreeKey），原生 / SLC 各一份；free_key_[vbn] 为其当前键
+    // （vbn 为 -1 表示不在索引里）。空闲条带的 lane 数随进出索引累计
+    set<FreeKey> free_order_[2];
+    vector<FreeKey> free_key_;
+    int free_lanes_[2] = {0, 0};
+    int reserved_lanes_ = 0;
+    uint64_t reserved_allocs_ = 0;
+    deque<int> slc_fold_queue_;
+    deque<int> closed_queue_;
+    vector<deque<int>> closed_by_stream_ = vector<deque<int>>(1);
+    uint64_t close_ticks_ = 0;
+    bool initialized_ = false;
+
+    // 系统区日志：每条定长记录带校验，重放到第一条坏记录为止
+    enum class JournalOp : uint8_t
+    {
+        REMAP = 1, // vbn 的坏 PBN a 换成 spare PBN b
+        DROP = 2,  // vbn 的 PBN a 坏且无 spare：该 lane 退出
+        SPARE = 3, // vbn 的 PBN a 转入 spare 池
+        UNSPARE = 4 // PBN a 离开 spare 池，回到 vbn 名下
+    };
+    ofstream journal_;
+    void journal(JournalOp op, int d, int p, int vbn, int a, int b);
+
+    int lane_of(int d, int p) const { return d * drv_.planes_per_die() + p; }
+    int alloc_superblock(bool slc);
+    // 空闲条带进出有序索引（同时维护空闲条带数、reserved 数与各池 lane 数）；状态 / lane / 池别变化前后成对调用
+    void link_free(int vbn);
+    void unlink_free(int vbn);
+    void relink_free(int vbn);
+    // lane 池：VBN 应在的队列、队列项是否有效、入队（已有项则不重复）
+    enum PoolKind { POOL_FREE = 0, POOL_RESERVED = 1, POOL_SLC = 2 };
+    deque<int> &pool(int d, int p, int kind);
+    const deque<int> &pool(int d, int p, int kind) const { return const_cast<BlockManager *>(this)->pool(d, p, kind); }
+    int pool_kind(int vbn) const { return is_slc_vbn(vbn) ? POOL_SLC : sbs_[vbn].reserved ? POOL_RESERVED : POOL_FREE; }
+    bool in_pool(int d, int p, int vbn, int kind) const;
+    void pool_push(int d, int p, int vbn, int kind);
+    int pool_size(int d, int p, int kind) const;
+    // 各 lane 池建好后：按池成员重建超级块表与游标
+    void build_superblocks();
+    // 某 lane 上该 VBN 是否可作为数据块：PBN 未坏、反向映射指回它、不在 spare 池
+    bool vbn_usable(int d, int p, int vbn) const;
+    int spare_region_start() const;
+    StripeCursor &cursor(bool slc, int stream) { return slc ? slc_stripe_ : stripe_[stream]; }
+    const StripeCursor &cursor(bool slc, int stream) const { return slc ? slc_stripe_ : stripe_[stream]; }
+    void close_superblock(int sb);
+    void close_free_superblock(int vbn, int stream, const vector<pair<int, int>> &members);
+    // 空闲原生条带在 free / reserved_write 池之间移动
+    void set_sb_reserved(int sb, bool reserved);
+    // VBN 离开/回到某 lane 的池（非条带路径，如 per-plane 分配、动态 spare）
+    void detach_lane(int d, int p, int vbn);
+    void attach_lane(int d, int p, int vbn);
+    // 条带成员坏掉且无法 remap：该 lane 退出条带
+    void drop_member(int d, int p, int vbn);
+
     bool valid_plane(int d, int p) const;
 
     // 使用页状态判断块是否空
@@ -85,8 +269,7 @@ private:
     // wear-aware：在 VBN 列表里挑 erase_count 最小者（按当前 PBN）
     int pick_vbn_wear_aware(deque<int> &vbns, int d, int p);
     
-    // 动态分配备用块
-    bool dynamic_allocate_spare_block(int die, int plane);
+    void trace_remap(int die, int plane, int bad_pbn, int new_pbn);
 };
 
 #endif // BLOCK_ALLOCATOR_H
\ No newline at end of file
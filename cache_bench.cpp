@@ -0,0 +1,171 @@
+#include "ftl.h"
+#include "logger.h"
+
+/* ---------------- 读缓存 benchmark ----------------
+   同一串负载在不同读缓存容量下各跑一遍（每次一套新的 NAND/FTL，顺序预写满，不计入统计）：
+   读写混合，读大多落在小热集上，每隔一段插入一次顺序扫描（检验扫描不会冲掉热集），写为均匀随机覆盖写。
+   输出命中率、实际下发的 NAND 读、平均 / p99 读延迟（仿真时钟）与缓存 DRAM 占用，可直接画 缓存容量-读延迟 曲线。
+   用法：cache_bench [--sizes PCT,PCT,...] [--ops N] [--read-pct PCT] [--hot-pct PCT] [--scan-every N]
+                    [--scan-len N] [--write-buffer PAGES] [--hit-ns NS] [--seed S] [--csv]
+   --sizes：缓存容量占 LBA 数的百分比（默认 0,1,2,5,10,20）；--hot-pct：热集占 LBA 数的百分比（80% 的读落在热集）
+   --scan-every 0 关闭扫描；--write-buffer：写在 program 剩余不超过这么多页时长时返回，读会撞上忙碌的 die
+*/
+
+struct CacheConfig
+{
+    int dies = 2, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85;
+    vector<double> sizes{0, 1, 2, 5, 10, 20};
+    int ops = 100000;
+    int read_pct = 70;
+    double hot_pct = 5;
+    int scan_every = 10000; // 每多少个操作插入一次扫描
+    int scan_len = 0;       // 0 = LBA 数 / 4
+    int write_buffer = 16;
+    uint64_t hit_ns = 1000;
+    uint32_t seed = 1;
+    bool csv = false;
+};
+
+struct CacheResult
+{
+    double hit_ratio = 0;
+    uint64_t nand_reads = 0, saved = 0;
+    double avg_us = 0, p99_us = 0, hot_p99_us = 0;
+    size_t dram_bytes = 0;
+};
+
+static double pct(vector<uint64_t> &v, double p)
+{
+    if (v.empty())
+        return 0;
+    size_t k = min(v.size() - 1, (size_t)(p * (v.size() - 1)));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1000.0;
+}
+
+static CacheResult run(const CacheConfig &c, double size_pct)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    int lbas = (int)(writable * c.user_ratio);
+    FTL ftl(driver, runtime, bm, lbas);
+    for (int l = 0; l < lbas; ++l)
+        ftl.write(l, "D" + to_string(l));
+    ftl.set_write_buffer(c.write_buffer);
+    ftl.set_read_cache((size_t)(lbas * size_pct / 100), c.hit_ns);
+
+    mt19937 rng(c.seed);
+    int hot = max(1, (int)(lbas * c.hot_pct / 100));
+    int scan_len = c.scan_len ? c.scan_len : lbas / 4;
+    uint64_t reads0 = driver.get_stats().read_ops;
+    vector<uint64_t> lat, hot_lat;
+    string out;
+    auto do_read = [&](int lba, bool is_hot)
+    {
+        uint64_t t0 = ftl.now_ns();
+        ftl.read_lba(lba, out);
+        uint64_t l = ftl.host_complete_ns() - t0;
+        lat.push_back(l);
+        if (is_hot)
+            hot_lat.push_back(l);
+    };
+    int scan_pos = 0;
+    for (int i = 0; i < c.ops; ++i)
+    {
+        if (c.scan_every && i % c.scan_every == c.scan_every - 1)
+            for (int k = 0; k < scan_len; ++k)
+                do_read(scan_pos++ % lbas, false);
+        if ((int)(rng() % 100) < c.read_pct)
+        {
+            bool is_hot = rng() % 100 < 80;
+            do_read(is_hot ? rng() % hot : rng() % lbas, is_hot);
+        }
+        else
+        {
+            int lba = rng() % lbas;
+            ftl.write(lba, "W" + to_string(i));
+        }
+    }
+
+    CacheResult r;
+    const auto &st = ftl.read_cache().stats();
+    r.hit_ratio = st.lookups ? (double)st.hits / st.lookups : 0.0;
+    r.nand_reads = driver.get_stats().read_ops - reads0;
+    r.saved = st.hits;
+    double sum = 0;
+    for (uint64_t v : lat)
+        sum += v;
+    r.avg_us = lat.empty() ? 0 : sum / lat.size() / 1000.0;
+    r.p99_us = pct(lat, 0.99);
+    r.hot_p99_us = pct(hot_lat, 0.99);
+    r.dram_bytes = ftl.read_cache().memory_bytes();
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    CacheConfig cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc)
+        {
+            cfg.sizes.clear();
+            stringstream ss(argv[++i]);
+            string tok;
+            while (getline(ss, tok, ','))
+                cfg.sizes.push_back(max(0.0, stod(tok)));
+        }
+        else if (arg == "--ops" && i + 1 < argc)
+            cfg.ops = max(1, stoi(argv[++i]));
+        else if (arg == "--read-pct" && i + 1 < argc)
+            cfg.read_pct = min(100, max(0, stoi(argv[++i])));
+        else if (arg == "--hot-pct" && i + 1 < argc)
+            cfg.hot_pct = min(100.0, max(0.0, stod(argv[++i])));
+        else if (arg == "--scan-every" && i + 1 < argc)
+            cfg.scan_every = max(0, stoi(argv[++i]));
+        else if (arg == "--scan-len" && i + 1 < argc)
+            cfg.scan_len = max(0, stoi(argv[++i]));
+        else if (arg == "--write-buffer" && i + 1 < argc)
+            cfg.write_buffer = max(0, stoi(argv[++i]));
+        else if (arg == "--hit-ns" && i + 1 < argc)
+            cfg.hit_ns = stoull(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--csv")
+            cfg.csv = true;
+        else
+        {
+            cerr << "usage: cache_bench [--sizes PCT,PCT,...] [--ops N] [--read-pct PCT] [--hot-pct PCT]"
+                    " [--scan-every N] [--scan-len N] [--write-buffer PAGES] [--hit-ns NS] [--seed S] [--csv]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    if (cfg.csv)
+        cout << "cache_pct,hit_ratio,nand_reads,saved,avg_us,p99_us,hot_p99_us,dram_bytes\n";
+    else
+        cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+             << " ops=" << cfg.ops << " read_pct=" << cfg.read_pct << " hot_pct=" << cfg.hot_pct
+             << " scan_every=" << cfg.scan_every << " write_buffer=" << cfg.write_buffer << "\n";
+    for (double size : cfg.sizes)
+    {
+        CacheResult r = run(cfg, size);
+        if (cfg.csv)
+            cout << size << "," << fixed << setprecision(4) << r.hit_ratio << "," << r.nand_reads << "," << r.saved
+                 << "," << setprecision(1) << r.avg_us << "," << r.p99_us << "," << r.hot_p99_us << ","
+                 << r.dram_bytes << defaultfloat << setprecision(6) << "\n";
+        else
+            cout << "cache=" << setw(5) << size << "%" << fixed << setprecision(3) << "  hit=" << r.hit_ratio
+                 << setprecision(1) << "  nand_reads=" << setw(7) << r.nand_reads << "  saved=" << setw(7)
+                 << r.saved << "  avg=" << setw(7) << r.avg_us << "us  p99=" << setw(7) << r.p99_us
+                 << "us  hot_p99=" << setw(7) << r.hot_p99_us << "us  dram=" << r.dram_bytes / 1024 << "KiB"
+                 << defaultfloat << setprecision(6) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "ftl.h"
+#include "logger.h"
+
+/* ---------------- FTL 检查点回归测试 ----------------
+   2x1x16x8 镜像、page_bytes=4096、每页 4 个扇区、两个 namespace、开去重：
+   - 保存检查点后重新打开：load_checkpoint 成功，各写入流的写满条带及其先后不变，读回一致；
+     去重后的共享引用与指纹索引都在（再写同样的负载仍命中，不下发 program）
+   - 检查点之后又写了几页（未再保存）：载入检查点并扫描 delta 补上，读回一致
+   - 之后大量覆盖写使 GC 擦掉了检查点记录的条带：load_checkpoint 判为过期、不做改动，rebuild_from_oob 读回一致
+     （全盘扫描丢掉去重共享的引用，只比对独占负载的 LBA）
+   用法：checkpoint_test [image_path]（默认在当前目录建 checkpoint_test.img，结束时删除）
+   失败时输出原因并返回 1
+*/
+
+static int failures = 0;
+#define CHECK(cond, what)                                  \
+    do                                                     \
+    {                                                      \
+        if (!(cond))                                       \
+        {                                                  \
+            cerr << "FAIL: " << what << "\n";              \
+            failures++;                                    \
+        }                                                  \
+    } while (0)
+
+static const int kDies = 2, kPlanes = 1, kBlocks = 16, kPages = 8;
+static const int kPageBytes = 4096, kSpp = 4;
+static const int kReservedWrite = 1, kReservedSpare = 2;
+static const int kNsLbas = (kBlocks - kReservedWrite - kReservedSpare) * kPages * kPlanes * kDies * kSpp / 4;
+
+struct Device
+{
+    NandModel model;
+    NandRuntime runtime;
+    NandDriver driver;
+    BlockManager bm;
+    unique_ptr<FTL> ftl;
+    string path;
+
+    explicit Device(const string &p)
+        : model(kDies, kPlanes, kBlocks, kPages, p, kPageBytes), runtime(kDies, kPlanes, kBlocks),
+          driver(model, runtime), bm(driver, runtime, kReservedWrite, kReservedSpare), path(p)
+    {
+        if (model.reopened())
+        {
+            CHECK(runtime.load(path + ".rt"), "load runtime");
+            CHECK(bm.load_system_area(path + ".sys"), "load system area");
+        }
+        ftl = make_unique<FTL>(driver, runtime, bm, 2 * kNsLbas, kSpp);
+        ftl->set_namespaces({kNsLbas, kNsLbas});
+        ftl->set_dedup(true);
+    }
+    // 掉电前的落盘：镜像、运行时计数、系统区（检查点由调用方决定是否保存）
+    void sync()
+    {
+        ftl->flush_pack();
+        model.sync();
+        runtime.save(path + ".rt");
+        bm.save_system_area(path + ".sys");
+    }
+};
+
+static string payload(int ns, int lba, int gen)
+{
+    // ns 0 后半与前半负载相同（去重共享一个物理扇区）
+    int key = ns == 0 ? lba % (kNsLbas / 2) : lba;
+    string s = "N" + to_string(ns) + ".L" + to_string(key) + "." + to_string(gen) + ".";
+    s.resize(64, (char)('a' + (key + gen) % 26));
+    return s;
+}
+
+static void remove_image(const string &path)
+{
+    for (const char *ext : {"", ".rt", ".sys", ".sys.jnl", ".ftl"})
+        remove((path + ext).c_str());
+}
+
+using Expect = map<pair<int, int>, string>;
+
+static void check_reads(FTL &ftl, const Expect &expect, const string &phase)
+{
+    string out;
+    int bad = 0;
+    for (auto &[key, data] : expect)
+        bad += ftl.read_ns(key.first, key.second, out) && out == data ? 0 : 1;
+    CHECK(bad == 0, phase << ": " << bad << " LBAs read back wrong");
+}
+
+// 各写入流写满条带及其写满时刻
+static vector<vector<pair<int, uint64_t>>> closed_by_stream(const BlockManager &bm)
+{
+    vector<vector<pair<int, uint64_t>>> out(bm.write_streams());
+    for (int s = 0; s < bm.write_streams(); ++s)
+        for (int sb : bm.closed_superblocks(s))
+            out[s].push_back({sb, bm.superblock_close_seq(sb)});
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    string path = argc > 1 ? argv[1] : "checkpoint_test.img";
+    Logger::set_level(LogLevel::OFF);
+    remove_image(path);
+    Expect expect;
+    vector<vector<pair<int, uint64_t>>> streams;
+
+    // 全新镜像：两个 namespace 各覆盖写两轮，保存检查点
+    {
+        Device dev(path);
+        CHECK(dev.model.ok(), "create image");
+        if (!dev.model.ok())
+            return 1;
+        for (int gen = 0; gen < 2; ++gen)
+            for (int ns = 0; ns < 2; ++ns)
+                for (int l = 0; l < kNsLbas; ++l)
+                {
+                    expect[{ns, l}] = payload(ns, l, gen);
+                    dev.ftl->write_ns(ns, l, expect[{ns, l}]);
+                }
+        dev.ftl->flush_pack();
+        CHECK(dev.ftl->dedup_stats().hits > 0, "no dedup hits");
+        streams = closed_by_stream(dev.bm);
+        CHECK(!streams[0].empty() && !streams[1].empty(), "both streams should own closed stripes");
+        CHECK(dev.ftl->save_checkpoint(path + ".ftl"), "save checkpoint");
+        dev.sync();
+    }
+
+    // 从检查点恢复；再写一页重复负载（去重命中），保存检查点后再写几页不保存（delta）
+    {
+        Device dev(path);
+        CHECK(dev.model.reopened(), "reopen image");
+        CHECK(dev.ftl->load_checkpoint(path + ".ftl"), "load checkpoint");
+        // 保存时打开的条带接在各流队尾
+        auto now = closed_by_stream(dev.bm);
+        for (int s = 0; s < 2; ++s)
+            CHECK(now[s].size() >= streams[s].size() && equal(streams[s].begin(), streams[s].end(), now[s].begin()),
+                  "stream " << s << ": closed stripes / ages changed");
+        check_reads(*dev.ftl, expect, "checkpoint");
+
+        uint64_t programs = dev.driver.get_stats().program_ops, hits = dev.ftl->dedup_stats().hits;
+        expect[{0, 1}] = expect[{1, 3}];
+        dev.ftl->write_ns(0, 1, expect[{0, 1}]);
+        dev.ftl->flush_pack();
+        CHECK(dev.ftl->dedup_stats().hits == hits + 1, "fingerprint index not restored");
+        CHECK(dev.driver.get_stats().program_ops == programs, "duplicate payload was programmed");
+        CHECK(dev.ftl->save_checkpoint(path + ".ftl"), "save checkpoint again");
+
+        for (int l = 0; l < 2 * kSpp; ++l)
+        {
+            expect[{1, l}] = payload(1, l, 2);
+            dev.ftl->write_ns(1, l, expect[{1, l}]);
+        }
+        dev.sync();
+    }
+
+    // 检查点 + delta；随后大量覆盖写让 GC 擦掉检查点记录过的条带，不保存检查点
+    {
+        Device dev(path);
+        CHECK(dev.ftl->load_checkpoint(path + ".ftl"), "load checkpoint with delta");
+        check_reads(*dev.ftl, expect, "checkpoint + delta");
+
+        uint64_t erases = dev.driver.get_stats().erase_ops;
+        for (int gen = 3; gen < 6; ++gen)
+            for (int ns = 0; ns < 2; ++ns)
+                for (int l = 0; l < kNsLbas; ++l)
+                {
+                    expect[{ns, l}] = payload(ns, l, gen);
+                    dev.ftl->write_ns(ns, l, expect[{ns, l}]);
+                }
+        CHECK(dev.driver.get_stats().erase_ops > erases, "overwrites should have run GC");
+        dev.sync();
+    }
+
+    // 过期检查点：拒绝且不改动，退回全盘 OOB 扫描（OOB 只记一个 LBA，去重共享的引用丢失，只比对独占负载的 LBA）
+    {
+        Device dev(path);
+        CHECK(!dev.ftl->load_checkpoint(path + ".ftl"), "stale checkpoint accepted");
+        CHECK(dev.bm.closed_superblocks().empty(), "rejected checkpoint left stripes behind");
+        dev.ftl->rebuild_from_oob();
+        for (int l = kNsLbas / 2; l < kNsLbas; ++l)
+            expect.erase({0, l});
+        check_reads(*dev.ftl, expect, "rebuild");
+    }
+
+    if (argc <= 1)
+        remove_image(path);
+    cout << (failures ? "checkpoint_test: FAILED\n" : "checkpoint_test: ok\n");
+    return failures ? 1 : 0;
+}
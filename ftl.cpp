@@ -1,346 +1,2171 @@
 #include "ftl.h"
+#include "mem_account.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fstream>
 
+// 负载指纹：64 位 FNV-1a。仿真规模下碰撞概率可忽略，命中不再回读比对
+static uint64_t payload_fingerprint(const string &data)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : data)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// 打包页负载：按槽位顺序 [lba int32][len uint32][bytes]，LBA 随数据存放（OOB 只容得下一个 LBA）。
+// 头为定长二进制，每槽位的开销与 LBA / 长度的位数无关，file-backed 页按 page_bytes / S 给每个扇区留预算
+static string encode_sectors(const vector<pair<int, const string *>> &secs)
+{
+    size_t total = 0;
+    for (auto &sec : secs)
+        total += FTL::kPackSlotHeaderBytes + sec.second->size();
+    string out;
+    out.reserve(total);
+    for (auto &[lba, data] : secs)
+    {
+        int32_t l = lba;
+        uint32_t len = (uint32_t)data->size();
+        out.append(reinterpret_cast<const char *>(&l), sizeof(l));
+        out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        out += *data;
+    }
+    return out;
+}
+
+static vector<pair<int, string>> decode_sectors(const string &payload)
+{
+    vector<pair<int, string>> secs;
+    size_t pos = 0;
+    while (pos + FTL::kPackSlotHeaderBytes <= payload.size())
+    {
+        int32_t lba;
+        uint32_t len;
+        memcpy(&lba, payload.data() + pos, sizeof(lba));
+        memcpy(&len, payload.data() + pos + sizeof(lba), sizeof(len));
+        pos += FTL::kPackSlotHeaderBytes;
+        if (len > payload.size() - pos)
+            break;
+        secs.push_back({lba, payload.substr(pos, len)});
+        pos += len;
+    }
+    return secs;
+}
+
 /* ---------------- FTL ---------------- */
-FTL::FTL(NandDriver &drv, NandRuntime &rt, BlockManager &alloc, int total_lbas)
-    : nand_drive(drv), nand_runtime(rt), block_manager(alloc)
+FTL::FTL(NandDriver &drv, NandRuntime &rt, BlockManager &alloc, int total_lbas, int sectors_per_page)
+    : nand_drive(drv), nand_runtime(rt), block_manager(alloc), geo_(drv.geometry())
 {
     seq_ = 1;
-    total_pages_ = drv.pages_per_block() * drv.blocks_per_plane() * drv.planes_per_die() * drv.dies_per_nand();
-    L2P.assign(total_lbas, -1);
-    P2L.assign(total_pages_, -1);
-    pstate.assign(total_pages_, PageState::EMPTY);
+    total_pages_ = geo_.total_pages();
+    if (sectors_per_page < 1 || (sectors_per_page & (sectors_per_page - 1)))
+    {
+        LOG_ERROR("sectors_per_page must be a power of two: " << sectors_per_page);
+        sectors_per_page = 1;
+    }
+    sectors_per_page_ = sectors_per_page;
+    while ((1 << sector_shift_) < sectors_per_page_)
+        sector_shift_++;
+    total_sectors_ = total_pages_ << sector_shift_;
+    ns_size_ = {total_lbas};
+    pack_.resize(1);
+    export_lbas_ = total_lbas;
+    {
+        MemScope scope(MemComponent::FTL_MAP);
+        L2P.assign(total_lbas, -1);
+        P2L.assign(total_sectors_, -1);
+        lba_next_.assign(total_lbas, -1);
+        lba_prev_.assign(total_lbas, -1);
+        page_ref_.assign(total_sectors_, 0);
+        pstate.assign(total_sectors_, PageState::EMPTY);
+        blk_valid_.assign(geo_.total_blocks(), 0);
+    }
+    set_gc_policy<FTL_GC_POLICY>();
 
-    // BBT from OOB
-    for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
-        for (int p = 0; p < nand_drive.planes_per_die(); ++p)
-            for (int b = 0; b < nand_drive.blocks_per_plane(); ++b)
-                nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = nand_drive.is_block_bad(d, p, b);
+    // 已从系统区载入（BBT / remap / spare 池）时不再逐块探测
+    if (!block_manager.initialized())
+    {
+        // BBT from OOB
+        for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
+            for (int p = 0; p < nand_drive.planes_per_die(); ++p)
+                for (int b = 0; b < nand_drive.blocks_per_plane(); ++b)
+                    nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = nand_drive.is_block_bad(d, p, b);
 
-    // Allocator init (含 FACTORY BAD BLOCK remap)
-    block_manager.init_from_bbt([this](int d, int p, int b)
-                                { return nand_drive.is_block_bad(d, p, b); });
+        // Allocator init (含 FACTORY BAD BLOCK remap)，直接读刚建好的 BBT
+        block_manager.init_from_bbt([this](int d, int p, int b)
+                                    { return (bool)nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)]; });
+    }
+    refresh_pending_.assign(block_manager.superblock_count(), 0);
 }
 
 void FTL::write(int lba, const string &data)
 {
-    if (lba < 0 || lba >= (int)L2P.size())
+    if (aop_.epoch_sectors && write_stats_.host_sectors - aop_base_.host_sectors >= aop_.epoch_sectors)
+        adapt_op();
+    int ns = lba < export_lbas_ ? ns_of(lba) : -1;
+    if (ns < 0)
     {
-        cerr << "bad LBA\n";
+        LOG_WARN("bad LBA");
         return;
     }
-    if (L2P[lba] != -1)
+    int budget = max_sector_bytes();
+    if (budget && (int)data.size() > budget)
     {
-        int old = L2P[lba];
-        pstate[old] = PageState::INVALID;
-        P2L[old] = -1;
-        L2P[lba] = -1;
+        // 写下去也放不进镜像页，driver 会拒绝 program；在这里拒绝，不能当成介质失败去判坏
+        LOG_WARN("sector payload " << data.size() << "B exceeds " << budget << "B, LBA " << lba);
+        return;
     }
-    int pba = -1;
-    // 简单：遍历全 plane 分配一页
-    for (int d = 0; d < nand_drive.dies_per_nand() && pba == -1; ++d)
-        for (int p = 0; p < nand_drive.planes_per_die() && pba == -1; ++p)
-            pba = block_manager.alloc_page(d, p);
-    if (pba == -1)
+    ns_stats_[ns].host_writes++;
+    host_complete_ns_ = now_ns_;
+    read_cache_.invalidate(lba);
+    if (L2P[lba] == kInPackBuffer)
+        drop_from_pack(lba);
+    uint64_t fp = 0;
+    if (dedup_)
     {
-        run_gc();
-        for (int d = 0; d < nand_drive.dies_per_nand() && pba == -1; ++d)
-            for (int p = 0; p < nand_drive.planes_per_die() && pba == -1; ++p)
-                pba = block_manager.alloc_page(d, p);
-        if (pba == -1)
+        auto c0 = chrono::steady_clock::now();
+        fp = payload_fingerprint(data);
+        auto it = fp_index_.find(fp);
+        int dup = it == fp_index_.end() ? -1 : it->second;
+        dedup_stats_.lookups++;
+        dedup_stats_.fp_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - c0).count();
+        if (dup != -1)
         {
-            cerr << "no space after GC\n";
+            // 相同负载已在盘上：只增加引用，不下发 program
+            dedup_stats_.hits++;
+            count_host_sector(ns);
+            if (L2P[lba] != dup)
+            {
+                if (L2P[lba] != -1)
+                    unmap_lba(lba);
+                mark_valid(dup, lba);
+            }
             return;
         }
     }
-    if (!program_pba_with_handling(pba, data, lba))
+    if (L2P[lba] != -1)
+        unmap_lba(lba);
+    if (sectors_per_page_ == 1)
     {
-        cerr << "program fail\n";
+        PackEntry e{lba, string(), fp};
+        program_host_page(&e, 1, data, ns);
         return;
     }
-    L2P[lba] = pba;
-    P2L[pba] = lba;
-    pstate[pba] = PageState::VALID;
+    // 子页映射：扇区先进该 namespace 的打包缓冲，凑满一页再 program
+    auto &pk = pack_[ns];
+    pk.push_back({lba, data, fp});
+    L2P[lba] = kInPackBuffer;
+    if ((int)pk.size() >= sectors_per_page_)
+        flush_pack(ns);
 }
 
-void FTL::read(int lba)
+int FTL::max_sector_bytes() const
 {
-    if (lba < 0 || lba >= (int)L2P.size())
-    {
-        cerr << "bad LBA\n";
-        return;
-    }
-    int pba = L2P[lba];
-    if (pba == -1 || pstate[pba] != PageState::VALID)
-    {
-        cerr << "unmapped\n";
+    int page = nand_drive.fixed_page_bytes();
+    if (page == 0 || sectors_per_page_ == 1)
+        return page;
+    return max(0, page / sectors_per_page_ - kPackSlotHeaderBytes);
+}
+
+void FTL::flush_pack()
+{
+    for (int ns = 0; ns < (int)pack_.size(); ++ns)
+        flush_pack(ns);
+}
+
+void FTL::flush_pack(int ns)
+{
+    auto &pk = pack_[ns];
+    if (pk.empty())
         return;
-    }
-    auto [d, p, b, g] = idx_from_pba(pba);
-    NandOp op;
-    op.cmd = NandCmd::READ_PAGE;
-    op.targets.push_back({d, p, b, g});
-    auto r = nand_drive.submit(op);
-    if (r.first == NandStatus::SUCCESS && !op.data.empty())
-        cout << setw(6) << op.data[0] << " ";
-    else
-        cerr << "read failed\n";
+    // 一次至多一页；program 成功后 mark_valid 才改写这些 LBA 的映射，之前一直是 kInPackBuffer（仍可从缓冲读）
+    size_t n = min(pk.size(), (size_t)sectors_per_page_);
+    vector<PackEntry> batch(make_move_iterator(pk.begin()), make_move_iterator(pk.begin() + n));
+    pk.erase(pk.begin(), pk.begin() + n);
+    vector<pair<int, const string *>> secs;
+    for (const auto &e : batch)
+        secs.push_back({e.lba, &e.data});
+    // 没写下去（无空间 / 重写也失败）：放回缓冲队首，留待下次 flush
+    if (!program_host_page(batch.data(), (int)batch.size(), encode_sectors(secs), ns))
+        pk.insert(pk.begin(), make_move_iterator(batch.begin()), make_move_iterator(batch.end()));
 }
 
-void FTL::dump_page_stats()
+// 覆盖写 / 去重命中时，旧版本还在缓冲里：直接丢掉
+void FTL::drop_from_pack(int lba)
 {
-    for (int i = 0; i < total_pages_; i++)
-    {
-        auto [d, p, b, g] = idx_from_pba(i);
-        if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+    auto &pk = pack_[ns_of(lba)];
+    for (size_t i = 0; i < pk.size(); ++i)
+        if (pk[i].lba == lba)
         {
-            // 如果是坏块，输出 B
-            cout << "B" << " ";
-            if (i % nand_drive.pages_per_block() == (nand_drive.pages_per_block()-1))
-            {
-                cout << "\n";
-            }
-            continue;
+            pk.erase(pk.begin() + i);
+            break;
         }
-        if (pstate[i] == PageState::VALID)
+    L2P[lba] = -1;
+}
+
+// 主机页写：secs[i] 落在该页第 i 个槽位
+bool FTL::program_host_page(const PackEntry *secs, int n, const string &payload, int stream)
+{
+    uint64_t t0 = now_ns_;
+    bool slc = block_manager.slc_blocks_per_plane() > 0;
+    // 有 SLC 缓存时优先写缓存；缓存满则直接写原生模式块
+    int pba = slc ? block_manager.alloc_stripe_page(true) : -1;
+    if (pba == -1)
+        pba = alloc_native_page(stream);
+    if (pba == -1)
+    {
+        run_gc(false, stream);
+        pba = block_manager.alloc_stripe_page(false, stream);
+        if (pba == -1)
         {
-            cout << "V" << " ";
+            LOG_ERROR("no space after GC");
+            return false;
         }
-        else if (pstate[i] == PageState::INVALID)
+    }
+    if (!program_pba_with_handling(pba, payload, secs[0].lba))
+    {
+        LOG_ERROR("program fail");
+        return false;
+    }
+    for (WriteStats *ws : {&write_stats_, &ns_write_stats_[stream]})
+    {
+        ws->host_pages++;
+        ws->nand_sectors += n;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        int psa = psa_of(pba, i);
+        mark_valid(psa, secs[i].lba);
+        if (dedup_)
         {
-            cout << "I" << " ";
+            MemScope scope(MemComponent::FTL_MAP);
+            fp_index_[secs[i].fp] = psa;
+            page_fp_[psa] = secs[i].fp;
         }
+        count_host_sector(stream);
+    }
+
+    host_complete_ns_ = last_complete_ns_;
+    // 闭环主机：本次写（最后一个 submit）完成后才推进时钟；有写缓冲时剩余时长落进缓冲窗口即返回
+    if (!host_async_)
+        now_ns_ = max(now_ns_, last_complete_ns_ - min(last_complete_ns_, write_buffer_ns_));
+    if (refresh_enabled())
+        refresh_tick(false);
+    if (slc)
+    {
+        auto [d, p, b, g] = idx_from_pba(pba);
+        slc_stats_.host_writes++;
+        if (nand_drive.is_block_slc(d, p, b))
+            slc_stats_.slc_writes++;
         else
-        {
-            cout << "E" << " ";
-        }
-        if (i % nand_drive.pages_per_block() == (nand_drive.pages_per_block()-1))
-        {
-            cout << "\n";
-        }
+            slc_stats_.direct_writes++;
+        record_write_latency(now_ns_ - t0);
+        if (block_manager.free_superblocks(true) < slc_fold_watermark_)
+            fold_slc_block();
     }
+    return true;
 }
 
-void FTL::dump_stats()
+// 清空映射表与打包缓冲 / 读缓存 / 去重索引（上电重建之前）
+void FTL::reset_mapping()
 {
-    int V = 0, I = 0, E = 0;
-    for (auto s : pstate)
+    for (auto &pk : pack_)
+        pk.clear();
+    fill(L2P.begin(), L2P.end(), -1);
+    fill(P2L.begin(), P2L.end(), -1);
+    fill(lba_next_.begin(), lba_next_.end(), -1);
+    fill(lba_prev_.begin(), lba_prev_.end(), -1);
+    fill(page_ref_.begin(), page_ref_.end(), 0);
+    fp_index_.clear();
+    read_cache_.clear();
+    fill(pstate.begin(), pstate.end(), PageState::EMPTY);
+    fill(blk_valid_.begin(), blk_valid_.end(), 0);
+}
+
+// 已写页各槽位的 LBA：整页映射即 OOB 里的那个；子页映射时 LBA 存在页负载里，需要读出整页（读失败返回 false）
+bool FTL::page_sector_lbas(int d, int p, int b, int g, int oob_lba, vector<int> &lbas)
+{
+    lbas.clear();
+    if (sectors_per_page_ == 1)
     {
-        if (s == PageState::VALID)
-            V++;
-        else if (s == PageState::INVALID)
-            I++;
-        else
-            E++;
+        lbas.push_back(oob_lba);
+        return true;
     }
-    uint32_t min_ec = UINT32_MAX, max_ec = 0;
-    int bad = 0;
+    NandOp op;
+    op.cmd = NandCmd::READ_PAGE;
+    op.targets.push_back({d, p, b, g});
+    if (submit(op).first != NandStatus::SUCCESS || op.data.empty())
+        return false;
+    auto secs = decode_sectors(op.data[0]);
+    for (int s = 0; s < (int)secs.size() && s < sectors_per_page_; ++s)
+        lbas.push_back(secs[s].first);
+    return true;
+}
+
+// 上电重建：扫描 OOB，同一 LBA 取 seq 最大者为有效副本；已写过的块从分配池摘除。
+// 全盘逐页扫描，仅在没有可用检查点（load_checkpoint 失败）时使用
+void FTL::rebuild_from_oob()
+{
+    reset_mapping();
+    // 指纹不在 OOB 里：重建后索引为空，之后的新写入重新建立
+    vector<uint64_t> best_seq(L2P.size(), 0);
+    uint64_t max_seq = 0;
+    vector<int> lbas;
     for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
         for (int p = 0; p < nand_drive.planes_per_die(); ++p)
             for (int b = 0; b < nand_drive.blocks_per_plane(); ++b)
             {
                 if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
-                    {
-                        bad++;
+                    continue;
+                bool used = false;
+                for (int g = 0; g < nand_drive.pages_per_block(); ++g)
+                {
+                    auto [lba, seq] = nand_drive.read_oob(d, p, b, g);
+                    if (seq == 0)
+                        continue;
+                    used = true;
+                    max_seq = max(max_seq, seq);
+                    int pba = pba_from_indices(d, p, b, g);
+                    for (int s = 0; s < sectors_per_page_; ++s)
+                        pstate[psa_of(pba, s)] = PageState::INVALID;
+                    if (!page_sector_lbas(d, p, b, g, lba, lbas))
                         continue;
+                    for (int s = 0; s < (int)lbas.size(); ++s)
+                    {
+                        int l = lbas[s];
+                        if (l < 0 || l >= (int)L2P.size() || seq <= best_seq[l])
+                            continue;
+                        L2P[l] = psa_of(pba, s);
+                        best_seq[l] = seq;
                     }
-                auto ec = nand_runtime.erase_count[nand_runtime.idx(d, p, b)];
-                min_ec = min(min_ec, ec);
-                max_ec = max(max_ec, ec);
+                }
+                if (used)
+                    block_manager.claim_used_pbn(d, p, b);
             }
-    cout << "[STATS] V=" << V << " I=" << I << " E=" << E
-         << " bad_blocks=" << bad << " erase_gap=" << (int)(max_ec - min_ec) << " min_ec=" << min_ec << " max_ec=" << max_ec << "\n";
-
-    // 输出NAND驱动统计信息
-    const auto &nand_stats = nand_drive.get_stats();
-    cout << "[NAND STATS] READ=" << nand_stats.read_ops
-         << " PROGRAM=" << nand_stats.program_ops
-         << " ERASE=" << nand_stats.erase_ops
-         << " FAILED=" << nand_stats.failed_ops
-         << " BAD_BLOCKS=" << nand_stats.bad_blocks_detected << "\n";
+    for (int lba = 0; lba < (int)L2P.size(); ++lba)
+        if (L2P[lba] != -1)
+            mark_valid(L2P[lba], lba);
+    seq_ = max_seq + 1;
 }
 
-bool FTL::program_pba_with_handling(int &pba, const string &data, int lba)
-{
-    auto [d, p, b, g] = idx_from_pba(pba);
-    if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
-        return false;
-    NandOp op;
-    op.cmd = NandCmd::PROGRAM_PAGE;
-    op.targets.push_back({d, p, b, g});
-    op.data.push_back(data);
-    op.oob_lba.push_back(lba);
-    op.oob_seq.push_back(seq_++);
-    auto r = nand_drive.submit(op);
-    if (r.first == NandStatus::SUCCESS)
-        return true;
+/* FTL 检查点（<镜像>.ftl，小端）：
+     magic "FTLCKPT1" | dies planes blocks pages spp lbas export_lbas n_ns dedup (uint32) | n_ns × ns_size (uint32)
+     | seq close_ticks (uint64)
+     | L2P：lbas × int32（-1 = 未映射；去重时多个 LBA 指向同一 PSA，引用链由此重建）
+     | n_fp (uint32) + n × (psa int32, fp uint64)：有效扇区的去重指纹
+     | n_sb (uint32) + n × 条带：vbn state stream (int32) close_seq (uint64) n_member (uint32) + n × (die plane pbn) (int32)
+       state：0 = 原生写满（按写满先后）1 = SLC 写满 2 = 打开
+     | FNV-1a 校验 (uint64，覆盖之前全部字节)
+   载入只读写满条带各成员块第 0 页的 OOB，确认块还是保存时那一代；保存时打开 / 空闲的条带才逐页扫描，
+   补上之后写下的页（delta）。对不上即判为过期 */
+static const char kCkptMagic[8] = {'F', 'T', 'L', 'C', 'K', 'P', 'T', '1'};
 
-    // 写失败 => 块判坏：标 OOB, BBT 置位，Allocator 做 BAD BLOCK TABLE remap
-    nand_drive.mark_block_bad_oob(d, p, b);
-    nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = true;
-    // 失效该块所有页（保守处理）
-    int start = pba_from_indices(d, p, b, 0);
-    for (int gg = 0; gg < nand_drive.pages_per_block(); ++gg)
+bool FTL::save_checkpoint(const string &path)
+{
+    flush_pack();
+    string buf(kCkptMagic, sizeof(kCkptMagic));
+    auto put = [&](uint32_t v) { buf.append(reinterpret_cast<const char *>(&v), sizeof(v)); };
+    auto put64 = [&](uint64_t v) { buf.append(reinterpret_cast<const char *>(&v), sizeof(v)); };
+    for (int v : {geo_.dies, geo_.planes, geo_.blocks, geo_.pages, sectors_per_page_, (int)L2P.size(), export_lbas_,
+                  namespace_count(), dedup_ ? 1 : 0})
+        put((uint32_t)v);
+    for (int n : ns_size_)
+        put((uint32_t)n);
+    put64(seq_);
+    put64(block_manager.close_ticks());
+    buf.append(reinterpret_cast<const char *>(L2P.data()), L2P.size() * sizeof(int));
+    vector<int> fps;
+    if (dedup_)
+        for (int psa = 0; psa < total_sectors_; ++psa)
+            if (pstate[psa] == PageState::VALID)
+                fps.push_back(psa);
+    put((uint32_t)fps.size());
+    for (int psa : fps)
+    {
+        put((uint32_t)psa);
+        put64(page_fp_[psa]);
+    }
+    vector<pair<int, int>> sbs;
+    for (int sb : block_manager.closed_superblocks())
+        sbs.push_back({sb, 0});
+    for (int sb : block_manager.slc_full_superblocks())
+        sbs.push_back({sb, 1});
+    for (int sb = 0; sb < block_manager.superblock_count(); ++sb)
+        if (block_manager.superblock_state(sb) == BlockManager::SbState::OPEN)
+            sbs.push_back({sb, 2});
+    put((uint32_t)sbs.size());
+    for (auto [sb, st] : sbs)
     {
-        int x = start + gg;
-        if (pstate[x] == PageState::VALID)
+        put((uint32_t)sb);
+        put((uint32_t)st);
+        put((uint32_t)block_manager.superblock_stream(sb));
+        put64(block_manager.superblock_close_seq(sb));
+        const auto &members = block_manager.superblock_members(sb);
+        put((uint32_t)members.size());
+        for (auto [d, p] : members)
         {
-            int l = P2L[x];
-            if (l >= 0)
-                L2P[l] = -1;
+            put((uint32_t)d);
+            put((uint32_t)p);
+            put((uint32_t)block_manager.resolve_pbn(d, p, sb));
         }
-        pstate[x] = PageState::INVALID;
-        P2L[x] = -1;
     }
-    // 通知分配器：坏 PBN -> remap 到一个 spare
-    bool ok = block_manager.remap_grown_bad(d, p, b);
-    if (ok)
+    uint64_t h = payload_fingerprint(buf);
+    put64(h);
+
+    string tmp = path + ".tmp";
     {
-        std::cout << "remap bad block\n";
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out || !out.write(buf.data(), buf.size()))
+        {
+            LOG_ERROR("[CKPT] cannot write " << tmp);
+            return false;
+        }
     }
-    // 丢弃 open（如果正好写这个块）
-    block_manager.drop_open_if_matches(d, p, b, true);
-
-    // 重新申请一个页再写一次
-    int np = -1;
-    for (int dd = 0; dd < nand_drive.dies_per_nand() && np == -1; ++dd)
-        for (int pp = 0; pp < nand_drive.planes_per_die() && np == -1; ++pp)
-            np = block_manager.alloc_page(dd, pp);
-    if (np == -1)
+    if (rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        LOG_ERROR("[CKPT] cannot rename " << tmp);
         return false;
-
-    auto [d2, p2, b2, g2] = idx_from_pba(np);
-    pba = pba_from_indices(d2, p2, b2, g2);
-    NandOp op2;
-    op2.cmd = NandCmd::PROGRAM_PAGE;
-    op2.targets.push_back({d2, p2, b2, g2});
-    op2.data.push_back(data);
-    op2.oob_lba.push_back(lba);
-    op2.oob_seq.push_back(seq_++);
-    return nand_drive.submit(op2).first == NandStatus::SUCCESS;
+    }
+    return true;
 }
 
-void FTL::erase_block_txn(int d, int p, int b /*PBN*/)
+bool FTL::load_checkpoint(const string &path)
 {
-    if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
-        return;
-    NandOp op;
-    op.cmd = NandCmd::ERASE_BLOCK;
-    op.targets.push_back({d, p, b, -1});
-    auto r = nand_drive.submit(op);
-    if (r.first != NandStatus::SUCCESS)
+    bool fresh = seq_ == 1 && block_manager.closed_superblocks().empty();
+    for (const auto &pk : pack_)
+        fresh = fresh && pk.empty();
+    if (!fresh)
     {
-        // 擦除失败 => 块坏
-        nand_drive.mark_block_bad_oob(d, p, b);
-        nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = true;
-        block_manager.remap_grown_bad(d, p, b);
+        LOG_ERROR("[CKPT] checkpoint needs a fresh FTL");
+        return false;
     }
-    int start = pba_from_indices(d, p, b, 0);
-    for (int g = 0; g < nand_drive.pages_per_block(); ++g)
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    uint64_t h = 0;
+    if (buf.size() < sizeof(kCkptMagic) + sizeof(h) || memcmp(buf.data(), kCkptMagic, sizeof(kCkptMagic)) != 0)
     {
-        pstate[start + g] = PageState::EMPTY;
-        P2L[start + g] = -1;
+        LOG_WARN("[CKPT] bad checkpoint: " << path);
+        return false;
     }
-    block_manager.on_erase_complete(d, p, b);
-}
-
-void FTL::run_gc()
-{
-    // cout << "[GC] start\n";
-    int vd = -1, vp = -1, vb = -1, min_valid = INT_MAX;
-    for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
+    memcpy(&h, buf.data() + buf.size() - sizeof(h), sizeof(h));
+    if (payload_fingerprint(buf.substr(0, buf.size() - sizeof(h))) != h)
     {
-        for (int p = 0; p < nand_drive.planes_per_die(); ++p)
+        LOG_WARN("[CKPT] checksum mismatch: " << path);
+        return false;
+    }
+    size_t pos = sizeof(kCkptMagic), end = buf.size() - sizeof(h);
+    bool ok = true;
+    auto get_raw = [&](void *v, size_t n)
+    {
+        if (pos + n > end)
+            ok = false;
+        else
+            memcpy(v, buf.data() + pos, n);
+        pos += n;
+    };
+    auto get = [&]() -> uint32_t
+    {
+        uint32_t v = 0;
+        get_raw(&v, sizeof(v));
+        return v;
+    };
+    auto get64 = [&]() -> uint64_t
+    {
+        uint64_t v = 0;
+        get_raw(&v, sizeof(v));
+        return v;
+    };
+    uint32_t hdr[9];
+    for (auto &v : hdr)
+        v = get();
+    bool match = ok && (int)hdr[0] == geo_.dies && (int)hdr[1] == geo_.planes && (int)hdr[2] == geo_.blocks &&
+                 (int)hdr[3] == geo_.pages && (int)hdr[4] == sectors_per_page_ && hdr[5] == L2P.size() &&
+                 (int)hdr[7] == namespace_count();
+    for (int ns = 0; match && ns < namespace_count(); ++ns)
+        match = (int)get() == ns_size_[ns];
+    if (!match || !ok)
+    {
+        LOG_WARN("[CKPT] geometry / namespace layout mismatch: " << path);
+        return false;
+    }
+    int export_lbas = (int)hdr[6];
+    uint64_t ckpt_seq = get64(), ckpt_ticks = get64();
+    vector<int> l2p(L2P.size());
+    get_raw(l2p.data(), l2p.size() * sizeof(int));
+    vector<pair<int, uint64_t>> fps(ok ? get() : 0);
+    for (auto &[psa, fp] : fps)
+    {
+        psa = (int)get();
+        fp = get64();
+    }
+    struct StripeRecord
+    {
+        int sb, state, stream;
+        uint64_t close_seq;
+        vector<pair<int, int>> members;
+        vector<int> pbns;
+        bool used = false;
+    };
+    vector<StripeRecord> stripes(ok ? get() : 0);
+    for (auto &r : stripes)
+    {
+        r.sb = (int)get();
+        r.state = (int)get();
+        r.stream = (int)get();
+        r.close_seq = get64();
+        uint32_t n = get();
+        for (uint32_t i = 0; i < n && ok; ++i)
         {
-            // 选 victim：按 **PBN** 统计有效页数量（VBN->PBN 后统计）
-            for (int v = 0; v < nand_drive.blocks_per_plane(); ++v)
-            {
-                int b = drv_vbn_to_pbn(d, p, v);
-                if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
-                    continue;
-                // 避免选中当前 open
-                // （allocator 内部有 open_vbn，我们简单通过 pba 比较规避）
-                int start = pba_from_indices(d, p, b, 0);
-                int valid = 0;
-                for (int g = 0; g < nand_drive.pages_per_block(); ++g)
-                    if (pstate[start + g] == PageState::VALID)
-                        valid++;
-                if (valid < min_valid)
-                {
-                    min_valid = valid;
-                    vd = d;
-                    vp = p;
-                    vb = b;
-                }
-            }
+            int d = (int)get(), p = (int)get();
+            r.members.push_back({d, p});
+            r.pbns.push_back((int)get());
         }
+        if (!ok)
+            break;
     }
-    if (vb == -1)
+    if (!ok || pos != end)
     {
-        cerr << "[GC] no victim\n";
-        return;
+        LOG_WARN("[CKPT] truncated checkpoint: " << path);
+        return false;
+    }
+
+    // 过期检查：写满条带的成员块仍是保存时的 PBN，第 0 页写于检查点之前（之后被擦过、重写过即对不上）；
+    // 映射指向的块都在检查点记录的条带里
+    auto stale = [&](const char *why)
+    {
+        LOG_WARN("[CKPT] stale checkpoint (" << why << "): " << path);
+        return false;
+    };
+    int ppb = nand_drive.pages_per_block();
+    vector<uint8_t> recorded(nand_runtime.bad_block_table.size(), 0);
+    vector<uint8_t> sb_recorded(block_manager.superblock_count(), 0);
+    for (const auto &r : stripes)
+    {
+        if (r.sb < 0 || r.sb >= block_manager.superblock_count() || sb_recorded[r.sb] ||
+            block_manager.superblock_state(r.sb) != BlockManager::SbState::FREE || r.state < 0 || r.state > 2)
+            return stale("stripe table");
+        sb_recorded[r.sb] = 1;
+        for (size_t i = 0; i < r.members.size(); ++i)
+        {
+            auto [d, p] = r.members[i];
+            if (d < 0 || d >= geo_.dies || p < 0 || p >= geo_.planes || block_manager.resolve_pbn(d, p, r.sb) != r.pbns[i])
+                return stale("remapped member");
+            int bi = nand_runtime.idx(d, p, r.pbns[i]);
+            if (nand_runtime.bad_block_table[bi])
+                return stale("bad member");
+            recorded[bi] = 1;
+            uint64_t seq0 = nand_drive.read_oob(d, p, r.pbns[i], 0).second;
+            if (r.state != 2 && (seq0 == 0 || seq0 >= ckpt_seq))
+                return stale("rewritten member");
+        }
     }
+    for (int psa : l2p)
+        if (psa != -1 && (psa < 0 || psa >= total_sectors_ || !recorded[blk_of_psa(psa)]))
+            return stale("unrecorded mapping");
 
-    int start = pba_from_indices(vd, vp, vb, 0);
-    for (int g = 0; g < nand_drive.pages_per_block(); ++g)
+    // delta：保存时打开的条带逐页扫，保存时空闲的条带看第 0 页，写过才逐页扫；seq >= ckpt_seq 的页按先后补进映射
+    struct DeltaPage
+    {
+        uint64_t seq;
+        int pba;
+        vector<int> lbas;
+    };
+    vector<DeltaPage> delta;
+    vector<int> programmed; // 这些块上已写的页（PBA）：pstate 置 INVALID
+    vector<tuple<int, int, int>> claimed;
+    bool readable = true;
+    auto scan_block = [&](int d, int p, int b)
     {
-        int oldp = start + g;
-        if (pstate[oldp] == PageState::VALID)
+        bool used = false;
+        for (int g = 0; g < ppb; ++g)
         {
-            int l = P2L[oldp];
-            if (l < 0)
+            auto [lba, seq] = nand_drive.read_oob(d, p, b, g);
+            if (seq == 0)
                 continue;
-            int np = -1;
-            for (int dd = 0; dd < nand_drive.dies_per_nand() && np == -1; ++dd)
-                for (int pp = 0; pp < nand_drive.planes_per_die() && np == -1; ++pp)
-                    np = block_manager.alloc_page(dd, pp);
-            if (np == -1)
+            used = true;
+            int pba = pba_from_indices(d, p, b, g);
+            programmed.push_back(pba);
+            if (seq < ckpt_seq)
+                continue;
+            delta.push_back({seq, pba, {}});
+            readable = readable && page_sector_lbas(d, p, b, g, lba, delta.back().lbas);
+        }
+        return used;
+    };
+    for (auto &r : stripes)
+        if (r.state == 2)
+            for (size_t i = 0; i < r.members.size(); ++i)
+                r.used = scan_block(r.members[i].first, r.members[i].second, r.pbns[i]) || r.used;
+    for (int sb = 0; sb < block_manager.superblock_count(); ++sb)
+    {
+        if (sb_recorded[sb])
+            continue;
+        for (int d = 0; d < geo_.dies; ++d)
+            for (int p = 0; p < geo_.planes; ++p)
             {
-                cerr << "[GC] alloc fail\n";
-                return;
+                int b = block_manager.resolve_pbn(d, p, sb);
+                if (block_manager.vbn_of(d, p, b) != sb || nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+                    continue;
+                uint64_t seq0 = nand_drive.read_oob(d, p, b, 0).second;
+                if (seq0 == 0)
+                    continue;
+                if (seq0 < ckpt_seq)
+                    return stale("unrecorded block");
+                scan_block(d, p, b);
+                claimed.push_back({d, p, b});
             }
-            // auto [d2, p2, b2, g2] = idx_from_pba(np);
-            NandOp op;
-            op.cmd = NandCmd::READ_PAGE;
-            op.targets.push_back({vd, vp, vb, g});
-            auto r = nand_drive.submit(op);
-            if (!program_pba_with_handling(np, op.data[0], l))
+    }
+    if (!readable)
+        return stale("unreadable delta page");
+    sort(delta.begin(), delta.end(), [](const DeltaPage &x, const DeltaPage &y) { return x.seq < y.seq; });
+
+    // 验证通过：换上检查点的映射，再按 delta 覆盖
+    reset_mapping();
+    L2P = l2p;
+    for (const auto &r : stripes)
+        if (r.state != 2)
+            for (size_t i = 0; i < r.members.size(); ++i)
             {
-                cerr << "[GC] prog fail\n";
-                continue;
+                auto [d, p] = r.members[i];
+                for (int g = 0; g < nand_drive.pages_in_block(d, p, r.pbns[i]); ++g)
+                    programmed.push_back(pba_from_indices(d, p, r.pbns[i], g));
             }
-            pstate[np] = PageState::VALID;
-            P2L[np] = l;
-            L2P[l] = np;
-            pstate[oldp] = PageState::INVALID;
-            P2L[oldp] = -1;
-        }
+    for (int pba : programmed)
+        for (int s = 0; s < sectors_per_page_; ++s)
+            pstate[psa_of(pba, s)] = PageState::INVALID;
+    uint64_t max_seq = ckpt_seq - 1;
+    for (const auto &dp : delta)
+    {
+        max_seq = max(max_seq, dp.seq);
+        for (int s = 0; s < (int)dp.lbas.size(); ++s)
+            if (dp.lbas[s] >= 0 && dp.lbas[s] < (int)L2P.size())
+                L2P[dp.lbas[s]] = psa_of(dp.pba, s);
     }
-    erase_block_txn(vd, vp, vb);
-    // cout << "[GC] done\n";
-}
-
-// helpers
-int FTL::drv_vbn_to_pbn(int d, int p, int vbn)
-{
-    // 通过 allocator 的公开接口解析
-    return block_manager.resolve_pbn(d, p, vbn);
-}
 
-int FTL::pages_per_plane() const { return nand_drive.pages_per_block() * nand_drive.blocks_per_plane(); }
-int FTL::pages_per_die() const { return pages_per_plane() * nand_drive.planes_per_die(); }
+    // 条带：写满的按保存时的先后与写入流恢复；打开的（写过页）接着记为写满；之后新开的条带按 claim_used_pbn 归流 0
+    for (const auto &r : stripes)
+    {
+        if (r.state == 2 && !r.used)
+            continue;
+        uint64_t close_seq = r.state == 2 ? ckpt_ticks : r.close_seq;
+        if (block_manager.restore_superblock(r.sb, r.stream, close_seq, r.members))
+            continue;
+        LOG_WARN("[CKPT] cannot restore superblock " << r.sb << ", claiming its blocks");
+        for (size_t i = 0; i < r.members.size(); ++i)
+            block_manager.claim_used_pbn(r.members[i].first, r.members[i].second, r.pbns[i]);
+    }
+    block_manager.restore_close_ticks(ckpt_ticks);
+    for (auto [d, p, b] : claimed)
+        block_manager.claim_used_pbn(d, p, b);
 
-int FTL::pba_from_indices(int d, int p, int b, int g) const
-{
-    return d * pages_per_die() + p * pages_per_plane() + b * nand_drive.pages_per_block() + g;
+    for (int lba = 0; lba < (int)L2P.size(); ++lba)
+        if (L2P[lba] != -1)
+            mark_valid(L2P[lba], lba);
+    if (dedup_ && hdr[8])
+        for (auto [psa, fp] : fps)
+            if (psa >= 0 && psa < total_sectors_ && pstate[psa] == PageState::VALID)
+            {
+                fp_index_[fp] = psa;
+                page_fp_[psa] = fp;
+            }
+    export_lbas_ = min(export_lbas, (int)L2P.size());
+    seq_ = max_seq + 1;
+    LOG_INFO("[CKPT] restored " << stripes.size() << " stripes, " << delta.size() << " delta pages from " << path);
+    return true;
 }
 
-tuple<int, int, int, int> FTL::idx_from_pba(int pba) const
+// 合成稳态：按写满先后逐条带分配、定每条带的有效扇区数，一遍写页与映射。
+// 序号按 program 顺序递增；失效扇区的 OOB 记一个之后才写下有效副本的 LBA，rebuild_from_oob 得到同一张映射
+bool FTL::precondition(const PreconditionParams &pp)
 {
-    int ppb = nand_drive.pages_per_block(), bpp = nand_drive.blocks_per_plane(), ppd = nand_drive.planes_per_die();
-    int pplane = ppb * bpp, pdie = pplane * ppd;
-    int d = pba / pdie, p = (pba % pdie) / pplane, b = (pba % pplane) / ppb, g = pba % ppb;
-    return {d, p, b, g};
-}
\ No newline at end of file
+    bool fresh = seq_ == 1 && block_manager.closed_superblocks().empty();
+    for (const auto &pk : pack_)
+        fresh = fresh && pk.empty();
+    if (!fresh)
+    {
+        LOG_ERROR("[PRECOND] precondition needs a fresh FTL");
+        return false;
+    }
+    mt19937 rng(pp.seed);
+    int ppb = nand_drive.pages_per_block();
+
+    // 擦除次数：截断正态，不超过 P/E 上限；prog_count 按每次擦除前写满一块累计
+    normal_distribution<double> ec_dist(pp.erase_mean, pp.erase_stddev);
+    uint32_t pe_limit = nand_drive.cell_params().pe_limit;
+    for (int d = 0; d < geo_.dies; ++d)
+        for (int p = 0; p < geo_.planes; ++p)
+            for (int b = 0; b < geo_.blocks; ++b)
+            {
+                int bi = nand_runtime.idx(d, p, b);
+                if (nand_runtime.bad_block_table[bi])
+                    continue;
+                double ec = pp.erase_stddev > 0 ? ec_dist(rng) : pp.erase_mean;
+                uint32_t n = (uint32_t)max(0.0, round(ec));
+                if (pe_limit)
+                    n = min(n, pe_limit - 1);
+                nand_runtime.erase_count[bi] = n;
+                nand_runtime.prog_count[bi] = n * (uint32_t)nand_drive.pages_in_block(d, p, b);
+            }
+    // 空闲条带的分配顺序按改写后的擦除次数重排
+    block_manager.refresh_free_order();
+
+    int keep_free = pp.free_superblocks >= 0 ? pp.free_superblocks : gc_free_watermark_ + block_manager.reserved_write();
+    int fill_sbs = max(0, block_manager.free_superblocks() - keep_free);
+    long lbas_total = accumulate(ns_size_.begin(), ns_size_.end(), 0L);
+    uint64_t pages_written = 0;
+    long mapped = 0;
+    int filled = 0;
+    for (int ns = 0; ns < namespace_count(); ++ns)
+    {
+        // 条带按 namespace 的 LBA 份额分给各写入流
+        int want = ns + 1 == namespace_count() ? fill_sbs - filled : (int)((long)fill_sbs * ns_size_[ns] / lbas_total);
+        vector<int> pages;
+        vector<int> stripe_at{0};
+        for (int k = 0; k < want; ++k)
+        {
+            int pba = block_manager.alloc_stripe_page(false, ns);
+            if (pba == -1)
+                break;
+            pages.push_back(pba);
+            auto [d, p, b, g] = idx_from_pba(pba);
+            int n = (int)block_manager.superblock_members(block_manager.vbn_of(d, p, b)).size() * ppb;
+            for (int i = 1; i < n && pba != -1; ++i)
+            {
+                pba = block_manager.alloc_stripe_page(false, ns);
+                if (pba != -1)
+                    pages.push_back(pba);
+            }
+            if (pba == -1)
+            {
+                // 条带中途分配失败：丢掉这个不完整的条带（已取的页留空），只预置到上一个完整条带为止
+                LOG_WARN("[PRECOND] ns " << ns << ": stripe " << k << " incomplete, stopping at " << k << " stripes");
+                pages.resize(stripe_at.back());
+                break;
+            }
+            stripe_at.push_back((int)pages.size());
+            filled++;
+        }
+        int stripes = (int)stripe_at.size() - 1;
+        long cap = (long)pages.size() << sector_shift_;
+        int size = namespace_count() == 1 ? min(ns_size_[ns], export_lbas_) : ns_size_[ns];
+        long target = (long)llround(clamp(pp.utilization, 0.0, 1.0) * size);
+        if (target > cap)
+        {
+            LOG_WARN("[PRECOND] ns " << ns << ": " << target << " LBAs exceed " << cap << " sectors, capped");
+            target = cap;
+        }
+
+        // 各条带有效率 = clamp(base_i + shift)，二分 shift 使总数等于 target，取整余数从最新的条带补
+        vector<double> base(stripes);
+        for (int i = 0; i < stripes; ++i)
+            base[i] = pp.valid_spread * (2.0 * (i + 0.5) / stripes - 1.0);
+        auto stripe_cap = [&](int i) { return (long)(stripe_at[i + 1] - stripe_at[i]) << sector_shift_; };
+        auto total_at = [&](double shift)
+        {
+            double t = 0;
+            for (int i = 0; i < stripes; ++i)
+                t += clamp(base[i] + shift, 0.0, 1.0) * stripe_cap(i);
+            return t;
+        };
+        double lo = -2, hi = 2;
+        for (int it = 0; it < 60; ++it)
+            (total_at((lo + hi) / 2) < target ? lo : hi) = (lo + hi) / 2;
+        vector<long> valid(stripes);
+        long assigned = 0;
+        for (int i = 0; i < stripes; ++i)
+            assigned += valid[i] = (long)(clamp(base[i] + hi, 0.0, 1.0) * stripe_cap(i));
+        for (int i = stripes - 1; i >= 0 && assigned != target; --i)
+        {
+            long d = assigned < target ? min(target - assigned, stripe_cap(i) - valid[i]) : -min(assigned - target, valid[i]);
+            valid[i] += d;
+            assigned += d;
+        }
+
+        // 扇区槽位：条带内随机挑有效位置，LBA 随机排列后依次放入
+        vector<int> slot_lba(cap, -1);
+        vector<uint8_t> slot_valid(cap, 0);
+        for (int i = 0; i < stripes; ++i)
+        {
+            long s0 = (long)stripe_at[i] << sector_shift_;
+            fill_n(slot_valid.begin() + s0, valid[i], 1);
+            shuffle(slot_valid.begin() + s0, slot_valid.begin() + s0 + stripe_cap(i), rng);
+        }
+        vector<int> order(size);
+        iota(order.begin(), order.end(), ns_base_[ns]);
+        shuffle(order.begin(), order.end(), rng);
+        long next = 0;
+        for (long k = 0; k < cap; ++k)
+            if (slot_valid[k])
+                slot_lba[k] = order[next++];
+        // 失效槽位：从之后才写的有效 LBA 里挑一个作为旧版本（之后没有有效 LBA 的留 -1）
+        vector<int> later;
+        for (long k = cap - 1; k >= 0; --k)
+        {
+            if (slot_valid[k])
+                later.push_back(slot_lba[k]);
+            else if (!later.empty())
+                slot_lba[k] = later[rng() % later.size()];
+        }
+
+        vector<pair<int, const string *>> secs;
+        for (size_t j = 0; j < pages.size(); ++j)
+        {
+            auto [d, p, b, g] = idx_from_pba(pages[j]);
+            long s0 = (long)j << sector_shift_;
+            string data = pp.payload;
+            if (sectors_per_page_ > 1)
+            {
+                secs.clear();
+                for (int s = 0; s < sectors_per_page_; ++s)
+                    secs.push_back({slot_lba[s0 + s], &pp.payload});
+                data = encode_sectors(secs);
+            }
+            if (!nand_drive.preload_page({d, p, b, g}, data, slot_lba[s0], seq_++, now_ns_))
+            {
+                LOG_ERROR("[PRECOND] preload failed at pba " << pages[j]);
+                return false;
+            }
+            pages_written++;
+            for (int s = 0; s < sectors_per_page_; ++s)
+            {
+                int psa = psa_of(pages[j], s);
+                if (!slot_valid[s0 + s])
+                {
+                    pstate[psa] = PageState::INVALID;
+                    continue;
+                }
+                mark_valid(psa, slot_lba[s0 + s]);
+                if (dedup_)
+                {
+                    uint64_t fp = payload_fingerprint(pp.payload);
+                    MemScope scope(MemComponent::FTL_MAP);
+                    fp_index_[fp] = psa;
+                    page_fp_[psa] = fp;
+                }
+            }
+        }
+        mapped += target;
+    }
+    LOG_INFO("[PRECOND] " << filled << " stripes, " << pages_written << " pages, " << mapped << " LBAs mapped");
+    return true;
+}
+
+void FTL::read(int lba)
+{
+    string data;
+    if (read_lba(lba, data))
+        cout << setw(6) << data << " ";
+}
+
+bool FTL::read_lba(int lba, string &out)
+{
+    if (lba < 0 || lba >= export_lbas_ || ns_of(lba) < 0)
+    {
+        LOG_WARN("bad LBA");
+        return false;
+    }
+    int psa = L2P[lba];
+    host_complete_ns_ = now_ns_;
+    if (psa == kInPackBuffer)
+    {
+        // 还在打包缓冲里：直接从 DRAM 返回
+        for (const auto &e : pack_[ns_of(lba)])
+            if (e.lba == lba)
+                out = e.data;
+        return true;
+    }
+    if (psa == -1 || pstate[psa] != PageState::VALID)
+    {
+        LOG_WARN("unmapped");
+        return false;
+    }
+    if (const string *hit = read_cache_.get(lba))
+    {
+        out = *hit;
+        host_complete_ns_ = now_ns_ + cache_hit_ns_;
+        if (!host_async_)
+            now_ns_ = host_complete_ns_;
+        return true;
+    }
+    auto [d, p, b, g] = idx_from_pba(psa >> sector_shift_);
+    NandOp op;
+    op.cmd = NandCmd::READ_PAGE;
+    op.targets.push_back({d, p, b, g});
+    auto r = submit(op);
+    bool ok = r.first == NandStatus::SUCCESS && !op.data.empty();
+    if (ok)
+    {
+        if (sectors_per_page_ == 1)
+            out = move(op.data[0]);
+        else
+        {
+            auto secs = decode_sectors(op.data[0]);
+            int slot = psa & (sectors_per_page_ - 1);
+            out = slot < (int)secs.size() ? secs[slot].second : string();
+        }
+        read_cache_.put(lba, out);
+    }
+    else
+        LOG_ERROR("read failed");
+    host_complete_ns_ = last_complete_ns_;
+    // 闭环主机：读完成后才发下一个请求
+    if (!host_async_)
+        now_ns_ = max(now_ns_, last_complete_ns_);
+    if (refresh_enabled())
+    {
+        check_read_disturb(d, p, b);
+        refresh_tick(false);
+    }
+    return ok;
+}
+
+// namespace 只在写入前划分：已有映射的 LBA 不迁移
+bool FTL::set_namespaces(const vector<int> &lbas)
+{
+    long total = 0;
+    for (int n : lbas)
+    {
+        if (n <= 0)
+        {
+            LOG_ERROR("[NS] bad namespace size " << n);
+            return false;
+        }
+        total += n;
+    }
+    if (lbas.empty() || total > (long)L2P.size())
+    {
+        LOG_ERROR("[NS] namespaces exceed " << L2P.size() << " LBAs");
+        return false;
+    }
+    if (write_stats_.host_sectors > 0)
+    {
+        LOG_ERROR("[NS] namespaces must be set before the first write");
+        return false;
+    }
+    ns_base_.clear();
+    ns_size_ = lbas;
+    int base = 0;
+    for (int n : lbas)
+    {
+        ns_base_.push_back(base);
+        base += n;
+    }
+    ns_stats_.assign(lbas.size(), NamespaceStats{});
+    ns_write_stats_.assign(lbas.size(), WriteStats{});
+    pack_.assign(lbas.size(), {});
+    block_manager.set_write_streams((int)lbas.size());
+    return true;
+}
+
+void FTL::write_ns(int ns, int lba, const string &data)
+{
+    if (ns < 0 || ns >= namespace_count() || lba < 0 || lba >= ns_size_[ns])
+    {
+        LOG_WARN("bad namespace LBA " << ns << ":" << lba);
+        return;
+    }
+    write(ns_base_[ns] + lba, data);
+}
+
+bool FTL::read_ns(int ns, int lba, string &out)
+{
+    if (ns < 0 || ns >= namespace_count() || lba < 0 || lba >= ns_size_[ns])
+    {
+        LOG_WARN("bad namespace LBA " << ns << ":" << lba);
+        return false;
+    }
+    ns_stats_[ns].host_reads++;
+    return read_lba(ns_base_[ns] + lba, out);
+}
+
+void FTL::dump_namespace_stats()
+{
+    for (int ns = 0; ns < namespace_count(); ++ns)
+    {
+        const auto &st = ns_stats_[ns];
+        const auto &ws = ns_write_stats_[ns];
+        cout << "[NS" << ns << "] lbas=" << ns_size_[ns] << " host_writes=" << st.host_writes
+             << " host_reads=" << st.host_reads << " gc_runs=" << st.gc_runs << " gc_inline=" << st.gc_inline
+             << " gc_pages=" << ws.gc_pages << " fold_pages=" << ws.fold_pages << " refresh_pages=" << ws.refresh_pages
+             << " closed_sb=" << block_manager.closed_superblocks(ns).size()
+             << " waf=" << fixed << setprecision(3) << ws.waf(sectors_per_page_) << defaultfloat << "\n";
+    }
+}
+
+void FTL::dump_page_stats()
+{
+    for (int i = 0; i < total_pages_; i++)
+    {
+        auto [d, p, b, g] = idx_from_pba(i);
+        if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+        {
+            // 如果是坏块，输出 B
+            cout << "B" << " ";
+            if (i % nand_drive.pages_per_block() == (nand_drive.pages_per_block()-1))
+            {
+                cout << "\n";
+            }
+            continue;
+        }
+        // 子页映射：任一扇区有效即 V
+        PageState st = PageState::EMPTY;
+        for (int s = 0; s < sectors_per_page_; ++s)
+        {
+            PageState x = pstate[psa_of(i, s)];
+            if (x == PageState::VALID || (x == PageState::INVALID && st == PageState::EMPTY))
+                st = x;
+        }
+        if (st == PageState::VALID)
+        {
+            cout << "V" << " ";
+        }
+        else if (st == PageState::INVALID)
+        {
+            cout << "I" << " ";
+        }
+        else
+        {
+            cout << "E" << " ";
+        }
+        if (i % nand_drive.pages_per_block() == (nand_drive.pages_per_block()-1))
+        {
+            cout << "\n";
+        }
+    }
+}
+
+void FTL::dump_stats()
+{
+    int V = 0, I = 0, E = 0;
+    for (auto s : pstate)
+    {
+        if (s == PageState::VALID)
+            V++;
+        else if (s == PageState::INVALID)
+            I++;
+        else
+            E++;
+    }
+    uint32_t min_ec = UINT32_MAX, max_ec = 0;
+    int bad = 0;
+    for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
+        for (int p = 0; p < nand_drive.planes_per_die(); ++p)
+            for (int b = 0; b < nand_drive.blocks_per_plane(); ++b)
+            {
+                if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+                    {
+                        bad++;
+                        continue;
+                    }
+                auto ec = nand_runtime.erase_count[nand_runtime.idx(d, p, b)];
+                min_ec = min(min_ec, ec);
+                max_ec = max(max_ec, ec);
+            }
+    cout << "[STATS] V=" << V << " I=" << I << " E=" << E
+         << " bad_blocks=" << bad << " erase_gap=" << (int)(max_ec - min_ec) << " min_ec=" << min_ec << " max_ec=" << max_ec << "\n";
+
+    // 输出NAND驱动统计信息
+    const auto &nand_stats = nand_drive.get_stats();
+    cout << "[NAND STATS] READ=" << nand_stats.read_ops
+         << " PROGRAM=" << nand_stats.program_ops
+         << " ERASE=" << nand_stats.erase_ops
+         << " FAILED=" << nand_stats.failed_ops
+         << " BAD_BLOCKS=" << nand_stats.bad_blocks_detected << "\n";
+    dump_write_stats();
+}
+
+size_t FTL::mapping_dram_bytes() const
+{
+    size_t bytes = (L2P.capacity() + P2L.capacity() + lba_next_.capacity() + lba_prev_.capacity()) * sizeof(int);
+    bytes += page_ref_.capacity() * sizeof(uint32_t) + pstate.capacity() * sizeof(PageState);
+    bytes += blk_valid_.capacity() * sizeof(int) + page_fp_.capacity() * sizeof(uint64_t);
+    bytes += fp_index_.size() * (sizeof(pair<const uint64_t, int>) + 2 * sizeof(void *));
+    return bytes;
+}
+
+void FTL::capture_snapshot(BlockSnapshot &s) const
+{
+    s.dies = nand_drive.dies_per_nand();
+    s.planes = nand_drive.planes_per_die();
+    s.blocks = nand_drive.blocks_per_plane();
+    s.pages_per_block = nand_drive.pages_per_block();
+    s.sectors_per_page = sectors_per_page_;
+    s.now_ns = now_ns_;
+    // column_for_write 可能往 columns 里追加而使旧引用失效：先把各列都建好，再取引用
+    static const char *kCols[] = {"erase_count", "prog_count", "read_count", "valid", "bad", "slc", "vbn"};
+    for (const char *name : kCols)
+        s.column_for_write(name);
+    auto &ec = s.column_for_write("erase_count");
+    auto &pc = s.column_for_write("prog_count");
+    auto &rc = s.column_for_write("read_count");
+    auto &valid = s.column_for_write("valid");
+    auto &bad = s.column_for_write("bad");
+    auto &slc = s.column_for_write("slc");
+    auto &vbn = s.column_for_write("vbn");
+    const auto &rt = nand_runtime;
+    copy(rt.erase_count.begin(), rt.erase_count.end(), ec.begin());
+    copy(rt.prog_count.begin(), rt.prog_count.end(), pc.begin());
+    copy(rt.read_count.begin(), rt.read_count.end(), rc.begin());
+    copy(blk_valid_.begin(), blk_valid_.end(), valid.begin());
+    copy(rt.bad_block_table.begin(), rt.bad_block_table.end(), bad.begin());
+    copy(rt.slc_mode.begin(), rt.slc_mode.end(), slc.begin());
+    for (int d = 0; d < s.dies; ++d)
+        for (int p = 0; p < s.planes; ++p)
+            for (int b = 0; b < s.blocks; ++b)
+                vbn[rt.idx(d, p, b)] = block_manager.vbn_of(d, p, b);
+}
+
+void FTL::mark_valid(int psa, int lba)
+{
+    if (pstate[psa] != PageState::VALID)
+    {
+        blk_valid_[blk_of_psa(psa)]++;
+        P2L[psa] = -1;
+        page_ref_[psa] = 0;
+    }
+    pstate[psa] = PageState::VALID;
+    // 头插进该扇区的引用链表
+    lba_prev_[lba] = -1;
+    lba_next_[lba] = P2L[psa];
+    if (P2L[psa] != -1)
+        lba_prev_[P2L[psa]] = lba;
+    P2L[psa] = lba;
+    page_ref_[psa]++;
+    L2P[lba] = psa;
+}
+
+// 扇区失效：所有引用它的 LBA 一并解除映射
+void FTL::mark_invalid(int psa)
+{
+    if (pstate[psa] == PageState::VALID)
+        blk_valid_[blk_of_psa(psa)]--;
+    pstate[psa] = PageState::INVALID;
+    for (int l = P2L[psa]; l != -1;)
+    {
+        int nx = lba_next_[l];
+        L2P[l] = -1;
+        read_cache_.invalidate(l);
+        lba_next_[l] = lba_prev_[l] = -1;
+        l = nx;
+    }
+    P2L[psa] = -1;
+    page_ref_[psa] = 0;
+    drop_fingerprint(psa);
+}
+
+// 解除一个 LBA 的映射；最后一个引用离开时扇区失效
+void FTL::unmap_lba(int lba)
+{
+    int psa = L2P[lba];
+    int nx = lba_next_[lba], pv = lba_prev_[lba];
+    if (pv != -1)
+        lba_next_[pv] = nx;
+    else
+        P2L[psa] = nx;
+    if (nx != -1)
+        lba_prev_[nx] = pv;
+    lba_next_[lba] = lba_prev_[lba] = -1;
+    L2P[lba] = -1;
+    read_cache_.invalidate(lba);
+    if (--page_ref_[psa] == 0)
+        mark_invalid(psa);
+}
+
+// 搬移：引用链表整体转到新扇区，所有引用它的 LBA 一起改指向；随后由调用方失效旧扇区
+void FTL::move_refs(int from, int to)
+{
+    if (pstate[to] != PageState::VALID)
+        blk_valid_[blk_of_psa(to)]++;
+    pstate[to] = PageState::VALID;
+    P2L[to] = P2L[from];
+    page_ref_[to] = page_ref_[from];
+    for (int l = P2L[to]; l != -1; l = lba_next_[l])
+        L2P[l] = to;
+    P2L[from] = -1;
+    page_ref_[from] = 0;
+    if (dedup_)
+    {
+        page_fp_[to] = page_fp_[from];
+        auto it = fp_index_.find(page_fp_[from]);
+        if (it != fp_index_.end() && it->second == from)
+            it->second = to;
+    }
+}
+
+void FTL::drop_fingerprint(int psa)
+{
+    if (!dedup_)
+        return;
+    auto it = fp_index_.find(page_fp_[psa]);
+    if (it != fp_index_.end() && it->second == psa)
+        fp_index_.erase(it);
+}
+
+bool FTL::program_pba_with_handling(int &pba, const string &data, int lba)
+{
+    auto [d, p, b, g] = idx_from_pba(pba);
+    if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+        return false;
+    NandOp op;
+    op.cmd = NandCmd::PROGRAM_PAGE;
+    op.targets.push_back({d, p, b, g});
+    op.data.push_back(data);
+    op.oob_lba.push_back(lba);
+    op.oob_seq.push_back(seq_++);
+    auto r = submit(op);
+    if (r.first == NandStatus::SUCCESS)
+        return true;
+    // 参数错误（如负载超出镜像页）不是介质失败：不判坏
+    if (r.first == NandStatus::INVALID_PARAM)
+        return false;
+    return recover_program_fail(pba, data, lba);
+}
+
+// pba 上的 program 已失败：判坏、remap，换一页重写（pba 改为新页）
+bool FTL::recover_program_fail(int &pba, const string &data, int lba)
+{
+    auto [d, p, b, g] = idx_from_pba(pba);
+    // 写失败 => 块判坏：标 OOB, BBT 置位，Allocator 做 BAD BLOCK TABLE remap
+    int bad_vbn = block_manager.vbn_of(d, p, b);
+    int stream = bad_vbn >= 0 ? block_manager.superblock_stream(bad_vbn) : 0;
+    nand_drive.mark_block_bad_oob(d, p, b);
+    nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = true;
+    // 失效该块所有扇区（保守处理）
+    int start = psa_of(pba_from_indices(d, p, b, 0), 0);
+    for (int x = 0; x < nand_drive.pages_per_block() << sector_shift_; ++x)
+        mark_invalid(start + x);
+    blk_valid_[nand_runtime.idx(d, p, b)] = 0;
+    // 通知分配器：坏 PBN -> remap 到一个 spare
+    bool ok = block_manager.remap_grown_bad(d, p, b);
+    if (ok)
+        LOG_INFO("remap bad block");
+    for (WriteStats *ws : {&write_stats_, &ns_write_stats_[stream]})
+    {
+        ws->bad_blocks++;
+        ws->remap_pages++;
+        ws->remaps += ok ? 1 : 0;
+    }
+    // 丢弃 open（如果正好写这个块）
+    block_manager.drop_open_if_matches(d, p, b, true);
+
+    // 重新申请一个页再写一次（同一单元模式的条带优先）
+    int np = block_manager.alloc_stripe_page(nand_drive.is_block_slc(d, p, b), stream);
+    if (np == -1)
+        np = alloc_native_page(stream);
+    if (np == -1)
+        return false;
+
+    auto [d2, p2, b2, g2] = idx_from_pba(np);
+    pba = pba_from_indices(d2, p2, b2, g2);
+    NandOp op2;
+    op2.cmd = NandCmd::PROGRAM_PAGE;
+    op2.targets.push_back({d2, p2, b2, g2});
+    op2.data.push_back(data);
+    op2.oob_lba.push_back(lba);
+    op2.oob_seq.push_back(seq_++);
+    return submit(op2).first == NandStatus::SUCCESS;
+}
+
+// 多目标读（每个 (die, plane) 至多一个目标，同 die 多 plane 并行）：driver 在失败的目标处停下，
+// 之前的结果保留，其后的目标另起一个 op 接着读
+void FTL::read_pages(const vector<NandAddr> &targets, vector<string> &data, vector<uint8_t> &ok)
+{
+    data.assign(targets.size(), string());
+    ok.assign(targets.size(), 0);
+    for (size_t k = 0; k < targets.size();)
+    {
+        NandOp op;
+        op.cmd = NandCmd::READ_PAGE;
+        op.targets.assign(targets.begin() + k, targets.end());
+        bool good = submit(op).first == NandStatus::SUCCESS;
+        for (size_t j = 0; j < op.done && j < op.data.size(); ++j)
+        {
+            data[k + j] = move(op.data[j]);
+            ok[k + j] = 1;
+        }
+        k += op.done + !good;
+    }
+}
+
+// 多目标写：dst[i] 写 payload[i]（OOB 记 lba[i]），一个 op 下发。失败的目标走单页路径判坏、换页重写，
+// 其后的目标逐页补写（落在刚判坏的块上的先换一页）；dst[i] 为实际写入的页
+void FTL::program_pages(vector<int> &dst, const vector<string> &payload, const vector<int> &lba, vector<uint8_t> &ok)
+{
+    ok.assign(dst.size(), 0);
+    NandOp op;
+    op.cmd = NandCmd::PROGRAM_PAGE;
+    op.targets.reserve(dst.size());
+    op.data.reserve(dst.size());
+    op.oob_lba.reserve(dst.size());
+    op.oob_seq.reserve(dst.size());
+    for (size_t j = 0; j < dst.size(); ++j)
+    {
+        auto [d, p, b, g] = idx_from_pba(dst[j]);
+        op.targets.push_back({d, p, b, g});
+        op.data.push_back(payload[j]);
+        op.oob_lba.push_back(lba[j]);
+        op.oob_seq.push_back(seq_++);
+    }
+    NandStatus st = submit(op).first;
+    if (st == NandStatus::INVALID_PARAM)
+        return;
+    size_t k = min(op.done, dst.size());
+    fill(ok.begin(), ok.begin() + k, 1);
+    if (st == NandStatus::SUCCESS || k == dst.size())
+        return;
+    auto [fd, fp, fb, fg] = idx_from_pba(dst[k]);
+    int vbn = block_manager.vbn_of(fd, fp, fb);
+    int stream = vbn >= 0 ? block_manager.superblock_stream(vbn) : 0;
+    ok[k] = recover_program_fail(dst[k], payload[k], lba[k]);
+    for (size_t j = k + 1; j < dst.size(); ++j)
+    {
+        auto [d, p, b, g] = idx_from_pba(dst[j]);
+        if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+        {
+            int np = block_manager.alloc_stripe_page(nand_drive.is_block_slc(d, p, b), stream);
+            if (np == -1)
+                np = alloc_native_page(stream);
+            if (np == -1)
+                continue;
+            dst[j] = np;
+        }
+        ok[j] = program_pba_with_handling(dst[j], payload[j], lba[j]);
+    }
+}
+
+void FTL::erase_block_txn(int d, int p, int b /*PBN*/)
+{
+    if (nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)])
+        return;
+    NandOp op;
+    op.cmd = NandCmd::ERASE_BLOCK;
+    op.targets.push_back({d, p, b, -1});
+    auto r = submit(op);
+    if (r.first != NandStatus::SUCCESS)
+    {
+        // 擦除失败 => 块坏
+        int vbn = block_manager.vbn_of(d, p, b);
+        int stream = vbn >= 0 ? block_manager.superblock_stream(vbn) : 0;
+        nand_drive.mark_block_bad_oob(d, p, b);
+        nand_runtime.bad_block_table[nand_runtime.idx(d, p, b)] = true;
+        bool remapped = block_manager.remap_grown_bad(d, p, b);
+        for (WriteStats *ws : {&write_stats_, &ns_write_stats_[stream]})
+        {
+            ws->bad_blocks++;
+            ws->remaps += remapped ? 1 : 0;
+        }
+    }
+    int start = psa_of(pba_from_indices(d, p, b, 0), 0);
+    for (int x = 0; x < nand_drive.pages_per_block() << sector_shift_; ++x)
+    {
+        pstate[start + x] = PageState::EMPTY;
+        P2L[start + x] = -1;
+        page_ref_[start + x] = 0;
+    }
+    blk_valid_[nand_runtime.idx(d, p, b)] = 0;
+}
+
+// 条带擦除：各成员同一时刻发出，不同 die 上并行执行
+void FTL::erase_superblock_txn(int sb)
+{
+    // 拷贝成员列表：擦除失败且无 spare 时该 lane 退出条带（members 随之变化）
+    auto members = block_manager.superblock_members(sb);
+    for (auto [d, p] : members)
+        erase_block_txn(d, p, block_manager.resolve_pbn(d, p, sb));
+    block_manager.release_superblock(sb);
+}
+
+// 把条带内所有有效扇区搬到原生模式条带（子页映射时重新打包成满页）；分配失败返回 false。
+// 源页按页号跨成员收集，每批每个 (die, plane) 至多一页：一个多 plane READ 读进来，凑满的目标页在 open 条带内
+// 连续分配后一个多目标 PROGRAM 写出，映射随后整批更新
+bool FTL::relocate_superblock(int sb, Reloc why)
+{
+    static const char *const kTag[] = {"[GC]", "[FOLD]", "[REFRESH]"};
+    bool is_fold = why == Reloc::FOLD;
+    int pages = is_fold ? nand_drive.slc_pages_per_block() : nand_drive.pages_per_block();
+    int S = sectors_per_page_;
+    int lanes = geo_.dies * geo_.planes;
+    // 搬到条带所属 namespace 的写入流，保持条带单租户；SLC 缓存各 namespace 共用，fold 写入流 0
+    int stream = is_fold ? 0 : block_manager.superblock_stream(sb);
+    auto progs = [why](WriteStats &ws) -> uint64_t &
+    {
+        return why == Reloc::FOLD ? ws.fold_pages : why == Reloc::GC ? ws.gc_pages : ws.refresh_pages;
+    };
+    auto live = [&](int psa) { return pstate[psa] == PageState::VALID && P2L[psa] >= 0; };
+
+    // 拷贝成员列表：搬移中的写失败可能让某 lane 退出条带
+    auto members = block_manager.superblock_members(sb);
+    vector<NandAddr> src;
+    for (int g = 0; g < pages; ++g)
+        for (auto [vd, vp] : members)
+        {
+            int vb = block_manager.resolve_pbn(vd, vp, sb);
+            int base = psa_of(pba_from_indices(vd, vp, vb, g), 0);
+            for (int s = 0; s < S; ++s)
+                if (live(base + s))
+                {
+                    src.push_back({vd, vp, vb, g});
+                    break;
+                }
+        }
+
+    // 待写入目标页的扇区：源 PSA + 负载
+    vector<pair<int, string>> moving;
+    vector<int> dst, heads;
+    vector<string> payload;
+    vector<uint8_t> ok;
+    // 目标页写失败（换块重写也没成功）的扇区源页仍有效：放回 moving 队首重写。重试超过 lanes 批仍失败则返回 false，
+    // 调用方不擦除源条带（已搬走的扇区源页已失效，其余仍在源条带上可读）
+    vector<pair<int, string>> retry;
+    int retries_left = lanes;
+    // 写出 moving 中凑满的页（final 时连同最后不满的一页，空槽不再使用）
+    auto flush = [&](bool final) -> bool
+    {
+        while ((int)moving.size() >= S || (final && !moving.empty()))
+        {
+            int n = min(lanes, ((int)moving.size() + (final ? S - 1 : 0)) / S);
+            dst.clear();
+            for (int k = 0; k < n; ++k)
+            {
+                // 第一页照常分配（可能开新条带；fold 与主机写一样走 just-in-time 检查，并按整批 n 页留余量，
+                // GC / refresh 自身不再触发 GC），其余只取 open 条带剩下的页：批内不跨条带，未写的目标页不会被 GC 选中
+                int np;
+                if (k == 0)
+                    np = is_fold ? alloc_native_page(stream, n) : block_manager.alloc_stripe_page(false, stream);
+                else if (block_manager.open_stripe_room(false, stream) > 0)
+                    np = block_manager.alloc_stripe_page(false, stream);
+                else
+                    break;
+                if (np == -1)
+                {
+                    LOG_ERROR(kTag[(int)why] << " alloc fail");
+                    return false;
+                }
+                dst.push_back(np);
+            }
+            n = (int)dst.size();
+            size_t used = min(moving.size(), (size_t)n * S);
+            payload.assign(n, string());
+            heads.assign(n, -1);
+            vector<pair<int, const string *>> secs;
+            for (int k = 0; k < n; ++k)
+            {
+                size_t a = (size_t)k * S, e = min(used, a + S);
+                heads[k] = P2L[moving[a].first];
+                if (S == 1)
+                {
+                    payload[k] = move(moving[a].second);
+                    continue;
+                }
+                secs.clear();
+                for (size_t i = a; i < e; ++i)
+                    secs.push_back({P2L[moving[i].first], &moving[i].second});
+                payload[k] = encode_sectors(secs);
+            }
+            program_pages(dst, payload, heads, ok);
+            for (int k = 0; k < n; ++k)
+            {
+                size_t a = (size_t)k * S, e = min(used, a + S);
+                if (!ok[k])
+                {
+                    LOG_ERROR(kTag[(int)why] << " prog fail");
+                    if (S == 1)
+                        moving[a].second = move(payload[k]);
+                    for (size_t i = a; i < e; ++i)
+                        retry.push_back(move(moving[i]));
+                    continue;
+                }
+                // 按页记到页首扇区所属 namespace（fold 的页可能混有多个 namespace 的扇区）
+                int owner = max(0, ns_of(heads[k]));
+                for (WriteStats *ws : {&write_stats_, &ns_write_stats_[owner]})
+                {
+                    progs(*ws)++;
+                    ws->nand_sectors += e - a;
+                }
+                for (size_t i = a; i < e; ++i)
+                {
+                    move_refs(moving[i].first, psa_of(dst[k], (int)(i - a)));
+                    mark_invalid(moving[i].first);
+                    if (why == Reloc::FOLD)
+                        slc_stats_.fold_pages++;
+                    else if (why == Reloc::GC)
+                    {
+                        gc_stats_.relocated_pages++;
+                        ns_stats_[stream].gc_pages++;
+                    }
+                    else
+                        refresh_stats_.pages++;
+                }
+            }
+            moving.erase(moving.begin(), moving.begin() + used);
+            if (retry.empty())
+                continue;
+            if (retries_left-- == 0)
+            {
+                LOG_ERROR(kTag[(int)why] << " giving up on " << retry.size() << " sectors, superblock " << sb << " kept");
+                return false;
+            }
+            moving.insert(moving.begin(), make_move_iterator(retry.begin()), make_move_iterator(retry.end()));
+            retry.clear();
+        }
+        return true;
+    };
+
+    vector<NandAddr> rd;
+    vector<string> data;
+    vector<uint8_t> lane_used(lanes);
+    for (size_t i = 0; i < src.size();)
+    {
+        rd.clear();
+        fill(lane_used.begin(), lane_used.end(), 0);
+        for (; i < src.size() && !lane_used[src[i].die * geo_.planes + src[i].plane]; ++i)
+        {
+            lane_used[src[i].die * geo_.planes + src[i].plane] = 1;
+            rd.push_back(src[i]);
+        }
+        read_pages(rd, data, ok);
+        for (size_t k = 0; k < rd.size(); ++k)
+        {
+            int base = psa_of(pba_from_indices(rd[k].die, rd[k].plane, rd[k].block, rd[k].page), 0);
+            if (!ok[k])
+            {
+                // 源页已读不出（如 ECC 纠不回来）：丢弃映射，避免擦除后 L2P 指向空页
+                LOG_ERROR(kTag[(int)why] << " read fail lba " << P2L[base]);
+                for (int s = 0; s < S; ++s)
+                    mark_invalid(base + s);
+                continue;
+            }
+            vector<pair<int, string>> secs;
+            if (S > 1)
+                secs = decode_sectors(data[k]);
+            for (int s = 0; s < S; ++s)
+            {
+                if (!live(base + s))
+                    continue;
+                moving.push_back({base + s, S == 1 ? move(data[k]) : s < (int)secs.size() ? move(secs[s].second) : string()});
+            }
+        }
+        if (!flush(false))
+            return false;
+    }
+    return flush(true);
+}
+
+int FTL::superblock_valid_sectors(int sb) const
+{
+    int valid = 0;
+    for (auto [d, p] : block_manager.superblock_members(sb))
+        valid += blk_valid_[nand_runtime.idx(d, p, block_manager.resolve_pbn(d, p, sb))];
+    return valid;
+}
+
+bool FTL::run_gc(bool just_in_time, int stream, int batch)
+{
+    // cout << "[GC] start\n";
+    // 选 victim：交给编译期特化的策略（候选为已写满的原生条带）
+    auto t0 = chrono::steady_clock::now();
+    // 多 namespace 时先在占用超出份额的 namespace 自己的条带里选，回收代价记在它名下
+    bool shared = block_manager.write_streams() > 1;
+    int requester = stream;
+    if (shared)
+        stream = gc_owner(stream);
+    int victim = (this->*gc_select_)(stream);
+    // 该 namespace 没有可回收的无效页：退回全局贪心
+    if (shared && (victim == -1 || superblock_valid_sectors(victim) >= GcView(*this, stream).capacity(victim)))
+        victim = select_victim<GreedyPolicy>(-1);
+    auto t1 = chrono::steady_clock::now();
+    gc_stats_.select_calls++;
+    gc_stats_.select_ns += chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+    if (victim == -1)
+    {
+        if (!just_in_time)
+            LOG_WARN("[GC] no victim");
+        return false;
+    }
+    // 按搬移后占用的页数比较（子页映射时有效扇区重新打包）；victim 搬到它所属的写入流
+    int min_valid = 0, room = 0;
+    auto pick = [&](int v)
+    {
+        if (v == -1)
+            return;
+        victim = v;
+        min_valid = pages_for(superblock_valid_sectors(v));
+        room = block_manager.stripe_room(false, block_manager.superblock_stream(v));
+    };
+    pick(victim);
+    // 搬不下就不动：避免搬了一半、victim 又擦不掉；非贪心策略选中的放不下时退回贪心（最后在全部条带里找）
+    if (min_valid > room)
+        pick(select_victim<GreedyPolicy>(stream));
+    if (min_valid > room && shared)
+        pick(select_victim<GreedyPolicy>(-1));
+    if (min_valid > room)
+        return false;
+    // just-in-time：再分配 batch 页后剩余空间（不算 reserved_write 池）就可能装不下 victim 时回收，
+    // 让 victim 有尽可能多的时间变无效；按区间判断而不是恰好相等，一次分配多页也不会越过触发点。
+    // 多写入流时空闲条带可能被别的流先开走，不推迟
+    int held = block_manager.reserved_room();
+    if (just_in_time && !shared && min_valid + batch <= room - held)
+        return false;
+    int owner = block_manager.superblock_stream(victim);
+    uint64_t moved0 = gc_stats_.relocated_pages, prog0 = write_stats_.gc_pages;
+    uint64_t cap = block_manager.superblock_members(victim).size() * nand_drive.pages_per_block();
+    bool ok = relocate_superblock(victim, Reloc::GC);
+    if (ok)
+    {
+        erase_superblock_txn(victim);
+        uint64_t freed = cap - min(cap, write_stats_.gc_pages - prog0);
+        write_stats_.gc_freed_pages += freed;
+        ns_write_stats_[owner].gc_freed_pages += freed;
+    }
+    if (trace_enabled())
+        trace_span(TraceKind::GC, victim, (int)(gc_stats_.relocated_pages - moved0));
+    gc_stats_.runs++;
+    write_stats_.gc_runs++;
+    ns_write_stats_[owner].gc_runs++;
+    ns_stats_[owner].gc_runs++;
+    ns_stats_[requester].gc_inline++;
+    gc_stats_.gc_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    if (!ok)
+        return false;
+    // cout << "[GC] done\n";
+    return true;
+}
+
+// 已写满条带数超出按 LBA 比例份额的写入流；请求者在份额一个条带以内时回收自己
+int FTL::gc_owner(int stream) const
+{
+    long closed = block_manager.closed_superblocks().size();
+    long lbas = accumulate(ns_size_.begin(), ns_size_.end(), 0L);
+    auto over = [&](int s)
+    { return (double)block_manager.closed_superblocks(s).size() - (double)closed * ns_size_[s] / lbas; };
+    if (over(stream) > -1)
+        return stream;
+    int best = stream;
+    for (int s = 0; s < block_manager.write_streams(); ++s)
+        if (over(s) > over(best) && over(s) > 1)
+            best = s;
+    return best;
+}
+
+// 原生模式条带分配：空闲条带低于水位时先做 just-in-time GC
+int FTL::alloc_native_page(int stream, int batch)
+{
+    // reserved_write 池里的条带不算可用空闲：GC 额外保持它们空着
+    if (block_manager.free_superblocks() < gc_free_watermark_ + block_manager.reserved_write())
+        run_gc(gc_just_in_time_, stream, batch);
+    return block_manager.alloc_stripe_page(false, stream);
+}
+
+// folding：把一个已写满的 SLC 条带的有效页搬到原生模式条带，然后擦除归还 SLC 池
+bool FTL::fold_slc_block()
+{
+    // 热数据在缓存里很快被覆盖，条带里留下的有效页就是冷的：取有效比例最低的条带（全失效的只擦不搬），
+    // 同比例取最老的；刚写满的条带还没来得及失效，留在缓存里
+    int sb = -1, cap = nand_drive.slc_pages_per_block() * sectors_per_page_;
+    double best = 2;
+    for (int v : block_manager.slc_full_superblocks())
+    {
+        double ratio = (double)superblock_valid_sectors(v) / (cap * block_manager.superblock_members(v).size());
+        if (ratio < best)
+        {
+            sb = v;
+            best = ratio;
+        }
+    }
+    if (sb == -1)
+        return false;
+    // 原生区放不下：先 GC；仍放不下则保持缓存满（主机写直接落原生块，即延迟悬崖）
+    if (pages_for(superblock_valid_sectors(sb)) > block_manager.stripe_room())
+        run_gc();
+    if (pages_for(superblock_valid_sectors(sb)) > block_manager.stripe_room())
+        return false;
+    uint64_t moved0 = slc_stats_.fold_pages;
+    if (!relocate_superblock(sb, Reloc::FOLD))
+        return false;
+    erase_superblock_txn(sb);
+    if (trace_enabled())
+        trace_span(TraceKind::FOLD, sb, (int)(slc_stats_.fold_pages - moved0));
+    slc_stats_.fold_blocks++;
+    if (slc_stats_.fold_pages == moved0)
+        slc_stats_.fold_empty++;
+    return true;
+}
+
+void FTL::idle(uint64_t ns)
+{
+    // 主机停下来：打包缓冲里不足一页的扇区先写下去
+    flush_pack();
+    uint64_t until = now_ns_ + ns;
+    // 只在所有 die 都已空闲时发起后台 fold，避免占用主机时间
+    while (true)
+    {
+        uint64_t busy = 0;
+        for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
+            busy = max(busy, nand_drive.die_busy_until(d));
+        now_ns_ = max(now_ns_, busy);
+        if (now_ns_ >= until)
+            break;
+        // 先 fold（释放 SLC 缓存），再做不受额度限制的后台刷新
+        if (!fold_slc_block() && !(refresh_enabled() && refresh_tick(true)))
+            break;
+    }
+    now_ns_ = max(now_ns_, until);
+}
+
+void FTL::dump_gc_stats()
+{
+    const auto &st = gc_stats_;
+    cout << "[GC] policy=" << gc_policy_name_ << " runs=" << st.runs
+         << " relocated_pages=" << st.relocated_pages
+         << " select_us=" << st.select_ns / 1000 << " gc_us=" << st.gc_ns / 1000 << "\n";
+}
+
+/* ---------------- 写放大记账 ----------------
+   program 在各来源（主机 / GC / fold / refresh / 坏块重写）成功后按页计数，与 NandStats::program_ops 对得上；
+   时间序列存累计快照，导出时相邻两点相减得到区间值
+*/
+FTL::WriteStats FTL::WriteStats::operator-(const WriteStats &o) const
+{
+    WriteStats d;
+    d.host_sectors = host_sectors - o.host_sectors;
+    d.host_pages = host_pages - o.host_pages;
+    d.gc_pages = gc_pages - o.gc_pages;
+    d.fold_pages = fold_pages - o.fold_pages;
+    d.refresh_pages = refresh_pages - o.refresh_pages;
+    d.remap_pages = remap_pages - o.remap_pages;
+    d.bad_blocks = bad_blocks - o.bad_blocks;
+    d.remaps = remaps - o.remaps;
+    d.gc_runs = gc_runs - o.gc_runs;
+    d.gc_freed_pages = gc_freed_pages - o.gc_freed_pages;
+    d.nand_sectors = nand_sectors - o.nand_sectors;
+    return d;
+}
+
+void FTL::count_host_sector(int ns)
+{
+    write_stats_.host_sectors++;
+    ns_write_stats_[ns].host_sectors++;
+    if (write_sample_interval_ && write_stats_.host_sectors - write_samples_.back().total.host_sectors >= write_sample_interval_)
+        sample_write_stats();
+}
+
+void FTL::set_write_sample_interval(uint64_t host_sectors)
+{
+    write_sample_interval_ = host_sectors;
+    write_samples_.clear();
+    sample_write_stats();
+}
+
+void FTL::sample_write_stats()
+{
+    write_samples_.push_back({now_ns_, write_stats_});
+}
+
+bool FTL::save_write_samples_csv(const string &path) const
+{
+    ofstream out(path);
+    if (!out)
+    {
+        LOG_ERROR("[WRITE] cannot open " << path);
+        return false;
+    }
+    out << "sample,now_ns,host_sectors,host_pages,gc_pages,fold_pages,refresh_pages,remap_pages,bad_blocks,"
+           "gc_runs,pages_per_gc,gc_efficiency,waf,cum_waf\n";
+    out << fixed << setprecision(4);
+    for (size_t i = 1; i < write_samples_.size(); ++i)
+    {
+        const auto &cur = write_samples_[i].total;
+        WriteStats d = cur - write_samples_[i - 1].total;
+        // GC 效率：每次擦除回收的页中有多少是真正腾出来的（1 = victim 全无效）
+        uint64_t reclaimed = d.gc_freed_pages + d.gc_pages;
+        out << i << "," << write_samples_[i].now_ns << "," << d.host_sectors << "," << d.host_pages << ","
+            << d.gc_pages << "," << d.fold_pages << "," << d.refresh_pages << "," << d.remap_pages << ","
+            << d.bad_blocks << "," << d.gc_runs << "," << (d.gc_runs ? (double)d.gc_pages / d.gc_runs : 0.0) << ","
+            << (reclaimed ? (double)d.gc_freed_pages / reclaimed : 0.0) << "," << d.waf(sectors_per_page_) << ","
+            << (cur - write_samples_[0].total).waf(sectors_per_page_) << "\n";
+    }
+    return (bool)out;
+}
+
+void FTL::dump_write_stats()
+{
+    const auto &st = write_stats_;
+    uint64_t reclaimed = st.gc_freed_pages + st.gc_pages;
+    cout << "[WRITE] host_sectors=" << st.host_sectors << " host_pages=" << st.host_pages << " gc_pages=" << st.gc_pages
+         << " fold_pages=" << st.fold_pages << " refresh_pages=" << st.refresh_pages << " remap_pages=" << st.remap_pages
+         << " bad_blocks=" << st.bad_blocks << " remaps=" << st.remaps << " waf=" << fixed << setprecision(3)
+         << st.waf(sectors_per_page_) << "\n";
+    cout << "[WRITE] gc_runs=" << st.gc_runs << " pages_per_gc=" << setprecision(1)
+         << (st.gc_runs ? (double)st.gc_pages / st.gc_runs : 0.0) << " gc_efficiency=" << setprecision(3)
+         << (reclaimed ? (double)st.gc_freed_pages / reclaimed : 0.0) << " samples=" << write_samples_.size()
+         << defaultfloat << "\n";
+}
+
+/* ---------------- 自适应 OP ----------------
+   每个 epoch 结束时（下一个主机写到来时）按本 epoch 的计数调整，顺序：
+   - spare 池：目标 = 平滑判坏速率 × spare_horizon + min_spare（每 plane）；不足从空闲块补，
+     超出目标一块以上时把由数据池转入的 spare 还回去
+   - reserved_write 池：本 epoch 不得不从 reserved 条带分配（GC 没跟上）则加一个；
+     没有动用且 GC 效率低于目标则减一个，让 GC 推迟得更久
+   - 导出容量：reserve 已到下限而效率仍低于目标时缩小一步（裁掉的 LBA 被 trim，变成 OP）；
+     效率高于目标时放回一步，不超过初始容量；本 epoch 没有 GC 时不放回
+   - reserve 与导出容量的反向调整之间至少隔 cooldown_epochs 个 epoch
+*/
+void FTL::set_adaptive_op(const AdaptiveOpParams &p)
+{
+    aop_ = p;
+    aop_base_ = write_stats_;
+    aop_reserve_allocs_ = block_manager.reserved_allocs();
+    aop_bad_rate_ = 0;
+    aop_epoch_ = 0;
+    aop_dir_[0] = aop_dir_[1] = 0;
+    if (p.epoch_sectors)
+        block_manager.set_reserved_write(clamp(block_manager.reserved_write(), p.min_reserve, p.max_reserve));
+}
+
+void FTL::log_op(const char *knob, long from, long to, double eff, uint64_t bad)
+{
+    op_log_.push_back({now_ns_, write_stats_.host_sectors, knob, from, to, eff, bad});
+    LOG_INFO("[AOP] " << knob << " " << from << " -> " << to << " gc_eff=" << eff << " bad=" << bad);
+}
+
+void FTL::adapt_op()
+{
+    const auto &ap = aop_;
+    WriteStats d = write_stats_ - aop_base_;
+    aop_base_ = write_stats_;
+    uint64_t reclaimed = d.gc_freed_pages + d.gc_pages;
+    double eff = reclaimed ? (double)d.gc_freed_pages / reclaimed : 1.0;
+    uint64_t dips = block_manager.reserved_allocs() - aop_reserve_allocs_;
+    aop_reserve_allocs_ = block_manager.reserved_allocs();
+    aop_epoch_++;
+    // knob 0 = reserve，1 = export：与上一次调整反向时须隔 cooldown_epochs 个 epoch
+    auto may_move = [&](int knob, int dir)
+    { return aop_dir_[knob] != -dir || aop_epoch_ - aop_moved_[knob] >= (uint64_t)ap.cooldown_epochs; };
+    auto moved = [&](int knob, int dir)
+    {
+        aop_dir_[knob] = dir;
+        aop_moved_[knob] = aop_epoch_;
+    };
+
+    int planes = geo_.dies * geo_.planes;
+    aop_bad_rate_ = 0.7 * aop_bad_rate_ + 0.3 * d.bad_blocks / planes;
+    int spare_target = clamp((int)ceil(aop_bad_rate_ * ap.spare_horizon) + ap.min_spare, ap.min_spare, ap.max_spare);
+    int spare0 = block_manager.spare_blocks_left();
+    // 从数据池取块会吃掉 OP：取走后数据区仍须装下全部有效页外加 GC 水位与 reserve 的条带
+    long valid = accumulate(blk_valid_.begin(), blk_valid_.end(), 0L) >> sector_shift_;
+    long stripe = (long)geo_.pages * planes;
+    long floor_pages = valid + (gc_free_watermark_ + block_manager.reserved_write() + 2) * stripe;
+    // spare 只能从空闲块里取：稳态下空闲条带常被 GC 用到水位，取不到时记为欠缺，靠写预留多留一个条带来补
+    bool spare_short = false;
+    for (int dd = 0; dd < geo_.dies; ++dd)
+        for (int pp = 0; pp < geo_.planes; ++pp)
+        {
+            bool room = true;
+            while (block_manager.spare_blocks(dd, pp) < spare_target &&
+                   (room = (long)(block_manager.data_blocks() - 1) * geo_.pages > floor_pages) &&
+                   block_manager.dynamic_allocate_spare_block(dd, pp))
+                ;
+            spare_short |= room && block_manager.spare_blocks(dd, pp) < spare_target;
+            while (block_manager.spare_blocks(dd, pp) > spare_target + 1 && block_manager.release_spare_block(dd, pp))
+                ;
+        }
+    if (block_manager.spare_blocks_left() != spare0)
+        log_op("spare", spare0, block_manager.spare_blocks_left(), eff, d.bad_blocks);
+
+    int res = block_manager.reserved_write(), nres = res;
+    if ((dips || spare_short) && res < ap.max_reserve && may_move(0, 1))
+        nres++;
+    else if (!dips && !spare_short && eff < ap.eff_low && res > ap.min_reserve && may_move(0, -1))
+        nres--;
+    if (nres != res)
+    {
+        block_manager.set_reserved_write(nres);
+        moved(0, nres > res ? 1 : -1);
+        log_op("reserve", res, nres, eff, d.bad_blocks);
+    }
+
+    if (ap.resize_export && namespace_count() == 1)
+    {
+        int full = (int)L2P.size();
+        int step = max(1, (int)(full * ap.export_step));
+        int n = export_lbas_;
+        // 本 epoch 没有 GC（例如刚 trim 完）时效率没有意义，不据此放回容量
+        if (eff < ap.eff_low && nres <= ap.min_reserve && may_move(1, -1))
+            n = max((int)(full * ap.min_export), n - step);
+        else if (reclaimed && eff > ap.eff_high && may_move(1, 1))
+            n = min(full, n + step);
+        if (n != export_lbas_)
+        {
+            moved(1, n > export_lbas_ ? 1 : -1);
+            log_op("export", export_lbas_, n, eff, d.bad_blocks);
+            set_exported_lbas(n);
+        }
+    }
+}
+
+// 缩小时超出部分的 LBA 一律 trim
+void FTL::set_exported_lbas(int n)
+{
+    n = clamp(n, 1, (int)L2P.size());
+    for (int lba = n; lba < export_lbas_; ++lba)
+    {
+        if (L2P[lba] == kInPackBuffer)
+            drop_from_pack(lba);
+        else if (L2P[lba] != -1)
+            unmap_lba(lba);
+    }
+    export_lbas_ = n;
+}
+
+void FTL::dump_op_log()
+{
+    cout << "[AOP] adjustments=" << op_log_.size() << " reserve=" << block_manager.reserved_write()
+         << " spare=" << block_manager.spare_blocks_left() << " export=" << export_lbas_ << "/" << L2P.size() << "\n";
+    for (const auto &a : op_log_)
+        cout << "[AOP]   t_us=" << a.now_ns / 1000 << " host_sectors=" << a.host_sectors << " " << a.knob << " "
+             << a.from << " -> " << a.to << " gc_eff=" << fixed << setprecision(3) << a.gc_efficiency
+             << defaultfloat << " bad=" << a.bad_blocks << "\n";
+}
+
+/* ---------------- 后台刷新 ----------------
+   - read disturb：主机读后检查该块读次数，达到 read_limit 即把所在条带入队
+   - retention：每次 tick 只看最早写满的几个条带（写满顺序近似数据年龄顺序）
+   - 限速：前台每个主机 I/O 攒 pages_per_host_op 页额度，够搬下整条带的有效页才做；
+     主机空闲（idle）时不受额度限制
+*/
+bool FTL::refresh_due(int sb) const
+{
+    if (block_manager.superblock_state(sb) != BlockManager::SbState::CLOSED)
+        return false;
+    const auto &rp = refresh_params_;
+    for (auto [d, p] : block_manager.superblock_members(sb))
+    {
+        int bi = nand_runtime.idx(d, p, block_manager.resolve_pbn(d, p, sb));
+        if (rp.read_limit && nand_runtime.read_count[bi] >= rp.read_limit)
+            return true;
+        uint64_t t = nand_runtime.prog_time_ns[bi];
+        if (rp.retention_ns && t != NandRuntime::kNoProgTime && now_ns_ >= t && now_ns_ - t >= rp.retention_ns)
+            return true;
+    }
+    return false;
+}
+
+void FTL::queue_refresh(int sb, bool by_read)
+{
+    if (refresh_pending_[sb])
+        return;
+    refresh_pending_[sb] = 1;
+    refresh_queue_.push_back(sb);
+    if (by_read)
+        refresh_stats_.read_triggers++;
+    else
+        refresh_stats_.retention_triggers++;
+}
+
+void FTL::check_read_disturb(int d, int p, int b)
+{
+    if (!refresh_params_.read_limit || nand_runtime.read_count[nand_runtime.idx(d, p, b)] < refresh_params_.read_limit)
+        return;
+    // 只刷新已写满的原生条带；SLC 条带随后会被 fold，open 条带写满后再读会重新触发
+    int sb = block_manager.vbn_of(d, p, b);
+    if (sb >= 0 && block_manager.superblock_state(sb) == BlockManager::SbState::CLOSED)
+        queue_refresh(sb, true);
+}
+
+void FTL::scan_retention()
+{
+    if (!refresh_params_.retention_ns)
+        return;
+    const auto &closed = block_manager.closed_superblocks();
+    for (size_t i = 0; i < closed.size() && i < 4; ++i)
+        if (!refresh_pending_[closed[i]] && refresh_due(closed[i]))
+            queue_refresh(closed[i], false);
+}
+
+// 每次最多刷新一个条带；返回是否做了工作（搬移或为腾空间做了 GC）
+bool FTL::refresh_tick(bool background)
+{
+    if (!background)
+    {
+        double cap = (double)geo_.dies * geo_.planes * geo_.pages;
+        refresh_credit_ = min(cap, refresh_credit_ + refresh_params_.pages_per_host_op);
+    }
+    scan_retention();
+    // 入队后可能已被 GC 回收或不再到期
+    while (!refresh_queue_.empty() && !refresh_due(refresh_queue_.front()))
+    {
+        refresh_pending_[refresh_queue_.front()] = 0;
+        refresh_queue_.pop_front();
+    }
+    if (refresh_queue_.empty())
+        return false;
+    int sb = refresh_queue_.front();
+    int valid = pages_for(superblock_valid_sectors(sb));
+    if (!background && refresh_credit_ < valid)
+        return false;
+    // 搬移直接走条带分配（不触发 just-in-time GC，避免 GC 选中源条带）；放不下先 GC 一次
+    int stream = block_manager.superblock_stream(sb);
+    if (valid > block_manager.stripe_room(false, stream))
+    {
+        bool gc = run_gc(false, stream);
+        if (block_manager.superblock_state(sb) != BlockManager::SbState::CLOSED)
+            return true;
+        if (valid > block_manager.stripe_room(false, stream))
+        {
+            refresh_stats_.deferred++;
+            return gc;
+        }
+    }
+    refresh_queue_.pop_front();
+    refresh_pending_[sb] = 0;
+    uint64_t moved0 = refresh_stats_.pages;
+    bool ok = relocate_superblock(sb, Reloc::REFRESH);
+    if (ok)
+    {
+        erase_superblock_txn(sb);
+        refresh_stats_.stripes++;
+    }
+    int moved = (int)(refresh_stats_.pages - moved0);
+    if (trace_enabled())
+        trace_span(TraceKind::REFRESH, sb, moved);
+    if (!background)
+        refresh_credit_ = max(0.0, refresh_credit_ - pages_for(moved));
+    return true;
+}
+
+void FTL::dump_refresh_stats()
+{
+    const auto &st = refresh_stats_;
+    cout << "[REFRESH] read_triggers=" << st.read_triggers << " retention_triggers=" << st.retention_triggers
+         << " stripes=" << st.stripes << " pages=" << st.pages << " deferred=" << st.deferred
+         << " queued=" << refresh_queue_.size() << " ecc_errors=" << nand_drive.get_stats().ecc_errors << "\n";
+    // 按来源拆分的 NAND program（页）；waf 与 WriteStats::waf 相同（页 × 每页扇区 / 主机扇区，打包页的空槽计入 NAND 侧）
+    const auto &ws = write_stats_;
+    cout << "[WAF] host_sectors=" << ws.host_sectors << " dedup=" << dedup_stats_.hits << " host_pages=" << ws.host_pages
+         << " gc=" << ws.gc_pages << " fold=" << ws.fold_pages << " refresh=" << ws.refresh_pages
+         << " remap=" << ws.remap_pages << " waf=" << fixed << setprecision(3) << ws.waf(sectors_per_page_)
+         << defaultfloat << "\n";
+}
+
+void FTL::set_read_cache(size_t pages, uint64_t hit_ns)
+{
+    read_cache_.set_capacity(pages);
+    read_cache_.reset_stats();
+    cache_hit_ns_ = hit_ns;
+}
+
+void FTL::dump_read_cache_stats()
+{
+    const auto &st = read_cache_.stats();
+    cout << fixed << setprecision(3);
+    cout << "[RCACHE] capacity=" << read_cache_.capacity() << " size=" << read_cache_.size()
+         << " lookups=" << st.lookups << " hits=" << st.hits
+         << " hit_ratio=" << (st.lookups ? (double)st.hits / st.lookups : 0.0)
+         << " nand_reads_saved=" << st.hits << " evictions=" << st.evictions << " promotions=" << st.promotions
+         << " ghost_hits=" << st.ghost_hits << " invalidations=" << st.invalidations
+         << " dram_bytes=" << read_cache_.memory_bytes() << defaultfloat << "\n";
+}
+
+void FTL::set_dedup(bool on)
+{
+    dedup_ = on;
+    MemScope scope(MemComponent::FTL_MAP);
+    fp_index_.clear();
+    if (on)
+        page_fp_.assign(total_sectors_, 0);
+    else
+        vector<uint64_t>().swap(page_fp_);
+}
+
+void FTL::dump_dedup_stats()
+{
+    const auto &st = dedup_stats_;
+    int logical = 0, physical = 0;
+    for (int psa : L2P)
+        logical += psa >= 0;
+    for (auto s : pstate)
+        physical += s == PageState::VALID;
+    // 索引 DRAM：哈希节点（键值 + next 指针 + malloc 头部估算）+ 桶数组 + 每页指纹；引用表：LBA 链表 + 每页引用数
+    size_t node = sizeof(pair<const uint64_t, int>) + 2 * sizeof(void *);
+    size_t index_bytes = fp_index_.size() * node + fp_index_.bucket_count() * sizeof(void *) +
+                         page_fp_.size() * sizeof(uint64_t);
+    size_t ref_bytes = (lba_next_.size() + lba_prev_.size()) * sizeof(int) + page_ref_.size() * sizeof(uint32_t);
+    cout << fixed << setprecision(3);
+    cout << "[DEDUP] lookups=" << st.lookups << " hits=" << st.hits
+         << " hit_ratio=" << (st.lookups ? (double)st.hits / st.lookups : 0.0)
+         << " dedup_ratio=" << (physical ? (double)logical / physical : 0.0)
+         << " logical=" << logical << " physical=" << physical << "\n";
+    // waf 即 WriteStats::waf；省下的 program 只算主机写本身（每次命中少写一个扇区），少写带来的 GC 减少体现在 [WAF] 的 gc 项
+    const auto &ws = write_stats_;
+    double waf = ws.waf(sectors_per_page_);
+    double waf_nodedup =
+        ws.host_sectors ? (double)(ws.nand_pages() * sectors_per_page_ + st.hits) / ws.host_sectors : 0.0;
+    cout << "[DEDUP] saved_programs=" << st.hits << " waf=" << waf << " waf_nodedup_min=" << waf_nodedup
+         << " index_entries=" << fp_index_.size() << " index_bytes=" << index_bytes << " ref_bytes=" << ref_bytes
+         << " ns_per_lookup=" << setprecision(1) << (st.lookups ? (double)st.fp_ns / st.lookups : 0.0)
+         << defaultfloat << "\n";
+}
+
+// GC/folding 的操作都在 now_ns_ 发出：区间到最后一个 die 空闲为止
+void FTL::trace_span(TraceKind kind, int sb, int moved)
+{
+    uint64_t end = now_ns_;
+    for (int d = 0; d < nand_drive.dies_per_nand(); ++d)
+        end = max(end, nand_drive.die_busy_until(d));
+    TraceRecord r;
+    r.kind = kind;
+    r.ts_ns = now_ns_;
+    r.dur_ns = end - now_ns_;
+    r.arg0 = sb;
+    r.arg1 = moved;
+    Tracer::instance().record(r);
+}
+
+void FTL::record_write_latency(uint64_t ns)
+{
+    auto &st = slc_stats_;
+    st.win_n++;
+    st.win_sum_ns += ns;
+    st.win_max_ns = max(st.win_max_ns, ns);
+    if ((int)st.win_n >= st.window)
+    {
+        st.window_lat_ns.push_back({st.win_sum_ns / st.win_n, st.win_max_ns});
+        st.win_n = st.win_sum_ns = st.win_max_ns = 0;
+    }
+}
+
+void FTL::dump_slc_stats()
+{
+    const auto &st = slc_stats_;
+    double hit = st.host_writes ? (double)st.slc_writes / st.host_writes : 0.0;
+    cout << "[SLC] host_writes=" << st.host_writes << " slc_writes=" << st.slc_writes
+         << " direct_writes=" << st.direct_writes << " hit_ratio=" << fixed << setprecision(3) << hit
+         << " fold_pages=" << st.fold_pages << " fold_blocks=" << st.fold_blocks << " fold_empty=" << st.fold_empty
+         << " slc_free=" << block_manager.free_superblocks(true) << "\n";
+    cout << "[SLC] write latency per " << st.window << " writes (avg_us/max_us):";
+    for (const auto &w : st.window_lat_ns)
+        cout << " " << w.first / 1000 << "/" << w.second / 1000;
+    cout << defaultfloat << "\n";
+}
+
+// helpers
+pair<NandStatus, string> FTL::submit(NandOp &op)
+{
+    op.issue_ns = now_ns_;
+    auto r = nand_drive.submit(op);
+    last_complete_ns_ = op.complete_ns;
+    return r;
+}
+
+int FTL::drv_vbn_to_pbn(int d, int p, int vbn)
+{
+    // 通过 allocator 的公开接口解析
+    return block_manager.resolve_pbn(d, p, vbn);
+}
+
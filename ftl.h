@@ -6,42 +6,432 @@
 #include "nand_runtime.h"
 #include "nand_driver.h"
 #include "block_allocator.h"
+#include "gc_policy.h"
+#include "snapshot.h"
+#include "read_cache.h"
 using namespace std;
 
+// 构建期默认 GC 策略（CMake: -DFTL_GC_POLICY=CostBenefitPolicy 等）
+#ifndef FTL_GC_POLICY
+#define FTL_GC_POLICY GreedyPolicy
+#endif
+
 /* ---------------- FTL ---------------- */
 class FTL
 {
 public:
-    FTL(NandDriver &drv, NandRuntime &rt, BlockManager &alloc, int total_lbas);
+    // SLC 缓存统计：命中率、folding 流量，以及按窗口采样的写延迟（观察缓存写满后的延迟悬崖）
+    struct SlcStats
+    {
+        uint64_t host_writes = 0;
+        uint64_t slc_writes = 0;    // 写入 SLC 缓存
+        uint64_t direct_writes = 0; // 缓存满，直接写原生模式块
+        uint64_t fold_pages = 0;
+        uint64_t fold_blocks = 0;
+        uint64_t fold_empty = 0;    // 其中有效页已在缓存里全部失效、只擦不搬的条带
+        int window = 64;
+        uint64_t win_n = 0, win_sum_ns = 0, win_max_ns = 0;
+        vector<pair<uint64_t, uint64_t>> window_lat_ns; // (avg, max)
+    };
+
+    // GC 统计：选择耗时单独计，便于比较各策略的 CPU 开销
+    struct GcStats
+    {
+        uint64_t runs = 0;
+        uint64_t relocated_pages = 0;
+        uint64_t select_calls = 0;
+        uint64_t select_ns = 0; // victim 选择的 CPU 时间
+        uint64_t gc_ns = 0;     // 整个 run_gc（含搬移、擦除）的 CPU 时间
+    };
+
+    // 后台刷新：块读次数 / 数据年龄越过阈值时整条带搬走，赶在 ECC 纠不回来之前
+    struct RefreshParams
+    {
+        uint32_t read_limit = 0;         // 块读次数达到即刷新（0 = 不跟踪 read disturb）
+        uint64_t retention_ns = 0;       // 块首次 program 后超过该时长即刷新（0 = 不跟踪 retention）
+        double pages_per_host_op = 0.5;  // 限速：每个主机 I/O 攒的搬移额度（页）；主机空闲时不限
+    };
+
+    struct RefreshStats
+    {
+        uint64_t read_triggers = 0;      // 因读次数入队的条带
+        uint64_t retention_triggers = 0; // 因数据年龄入队的条带
+        uint64_t stripes = 0;            // 完成刷新的条带
+        uint64_t pages = 0;              // 刷新搬移的页（计入 WAF）
+        uint64_t deferred = 0;           // 额度不足 / 空间不足而推迟的次数
+    };
+
+    // 在线去重：hits 为免去 NAND program 的主机写；fp_ns 为指纹计算 + 索引查找的 CPU 时间
+    struct DedupStats
+    {
+        uint64_t lookups = 0;
+        uint64_t hits = 0;
+        uint64_t fp_ns = 0;
+    };
+
+    // 多租户：每个 namespace 一段独立的 LBA 空间（全局 L2P 中的一段）和一个原生写入流；
+    // GC 开销按条带所属 namespace 记账
+    struct NamespaceStats
+    {
+        uint64_t host_writes = 0;
+        uint64_t host_reads = 0;
+        uint64_t gc_runs = 0;  // victim 属于该 namespace 的 GC 次数（不论由哪个 namespace 的写触发）
+        uint64_t gc_inline = 0; // 在该 namespace 的写路径里同步执行的 GC 次数（耗时落在它的请求上）
+        uint64_t gc_pages = 0; // 从该 namespace 的条带搬走的页
+    };
+
+    // 写放大记账：NAND program 按来源拆分（页），另记主机扇区写、坏块 remap 与 GC 次数 / 回收量
+    struct WriteStats
+    {
+        uint64_t host_sectors = 0;   // 主机写扇区（含去重命中）
+        uint64_t host_pages = 0;     // 主机数据 program 的页（子页映射时为打包后的页）
+        uint64_t gc_pages = 0;       // GC 搬移 program 的页
+        uint64_t fold_pages = 0;     // SLC folding
+        uint64_t refresh_pages = 0;  // 后台刷新
+        uint64_t remap_pages = 0;    // program 失败、换块重写多出来的 program
+        uint64_t bad_blocks = 0;     // 运行中判坏（program / erase 失败）
+        uint64_t remaps = 0;         // 其中换上了 spare 的块（其余为 lane 退出条带）
+        uint64_t gc_runs = 0;
+        uint64_t gc_freed_pages = 0; // GC 擦除回收的页：victim 容量 - 搬移页
+        uint64_t nand_sectors = 0;   // 成功的 program 实际写下的扇区（主机 + 搬移；未凑满的打包页只计写入的扇区）
+        uint64_t nand_pages() const { return host_pages + gc_pages + fold_pages + refresh_pages + remap_pages; }
+        // 按扇区计：NAND 写入量 / 主机写入量（页内未用满的槽位计入 NAND 侧）
+        double waf(int sectors_per_page = 1) const
+        {
+            return host_sectors ? (double)nand_pages() * sectors_per_page / host_sectors : 0.0;
+        }
+        WriteStats operator-(const WriteStats &o) const;
+    };
+    // 时间序列的一个点：采样时刻的仿真时钟与累计计数，相邻两点之差即一个区间
+    struct WriteSample
+    {
+        uint64_t now_ns = 0;
+        WriteStats total;
+    };
+
+    // 自适应 OP：每 epoch_sectors 个主机扇区写评估一次本 epoch 的 GC 效率与运行中判坏数，调整
+    // reserved_write 池（GC 额外保持空闲的条带）、各 plane spare 池，以及（可选）导出的 LBA 容量
+    struct AdaptiveOpParams
+    {
+        uint64_t epoch_sectors = 0;           // 0 = 关闭
+        double eff_low = 0.5, eff_high = 0.8; // GC 效率（回收页中真正腾出的比例）目标区间
+        int min_reserve = 0, max_reserve = 4; // reserved_write 池（条带）
+        int min_spare = 1, max_spare = 8;     // 每 plane spare 块
+        double spare_horizon = 8;             // spare 按判坏速率（每 plane 每 epoch，平滑）预留这么多 epoch
+        bool resize_export = false;           // 允许调整导出 LBA 容量（仅单 namespace）
+        double min_export = 0.7;              // 导出容量下限（占初始 LBA 数）
+        double export_step = 0.02;            // 每次调整的比例
+        int cooldown_epochs = 4;              // reserve / export 反向调整之间至少间隔的 epoch 数（防止来回摆动）
+    };
+    // 一次调整：knob 为 "reserve"（条带）/ "spare"（全部 plane 合计块数）/ "export"（LBA）
+    struct OpAdjustment
+    {
+        uint64_t now_ns = 0;
+        uint64_t host_sectors = 0;
+        const char *knob = "";
+        long from = 0, to = 0;
+        double gc_efficiency = 0; // 触发时本 epoch 的 GC 效率
+        uint64_t bad_blocks = 0;  // 本 epoch 运行中判坏数
+    };
+
+    // 合成稳态预置：不重放主机写，直接构造“写满并碎片化”的盘。除 free_superblocks 个空闲条带外原生条带全部写满，
+    // 条带有效率按写满先后从 mean - valid_spread 线性升到 mean + valid_spread（越老越空，截断在 [0, 1]，mean 由利用率定），
+    // 条带内有效扇区位置随机；各好块擦除次数取截断正态分布
+    struct PreconditionParams
+    {
+        double utilization = 1.0;    // 映射的 LBA 占导出容量的比例
+        double valid_spread = 0.5;   // 0 = 各条带有效率相同
+        int free_superblocks = -1;   // 留空的原生条带数（-1 = GC 水位 + reserved_write）
+        double erase_mean = 0;       // 擦除次数分布
+        double erase_stddev = 0;
+        string payload = "P";        // 各扇区负载
+        uint32_t seed = 1;
+    };
+
+    // sectors_per_page > 1：子页映射，LBA 为扇区（如 16 KiB 页里 4 个 4 KiB 扇区），须为 2 的幂
+    FTL(NandDriver &drv, NandRuntime &rt, BlockManager &alloc, int total_lbas, int sectors_per_page = 1);
 
     void write(int lba, const string &data);
     void read(int lba);
+    // 读出负载而不打印；失败返回 false
+    bool read_lba(int lba, string &out);
+
+    // 按大小把 LBA 空间切成多个 namespace（须在写入前调用；总和不超过 total_lbas）
+    bool set_namespaces(const vector<int> &lbas);
+    int namespace_count() const { return (int)ns_base_.size(); }
+    int namespace_lbas(int ns) const { return ns_size_[ns]; }
+    void write_ns(int ns, int lba, const string &data);
+    bool read_ns(int ns, int lba, string &out);
+    const NamespaceStats &namespace_stats(int ns) const { return ns_stats_[ns]; }
+    // 该 namespace 的写放大记账：主机写按 namespace，搬移按页首扇区所属 namespace，判坏 / 换块重写按条带所属写入流
+    const WriteStats &namespace_write_stats(int ns) const { return ns_write_stats_[ns]; }
+    void dump_namespace_stats();
+    // 子页映射：把打包缓冲里不足一页的扇区立即写下去（空槽不再使用）
+    void flush_pack();
+    int sectors_per_page() const { return sectors_per_page_; }
+    // 打包页每个槽位前的定长二进制头：LBA（int32）+ 负载长度（uint32）
+    static constexpr int kPackSlotHeaderBytes = 8;
+    // 单个 LBA 负载的上限（file-backed 镜像页大小固定：page_bytes / S - 槽位头；内存模式 0 = 不限）
+    int max_sector_bytes() const;
 
+    // 上电重建：全盘逐页扫描 OOB（子页映射时还要读出每页负载），O(设备容量)
     void rebuild_from_oob();
+    // 检查点：L2P（含去重引用）、有效扇区指纹、条带表（写入流 / 写满先后 / 成员 PBN），与 .rt / .sys 一起保存
+    bool save_checkpoint(const string &path);
+    // 在全新的 FTL 上载入检查点，只验证各写满条带成员块的第 0 页，逐页扫描仅限保存时打开 / 空闲的条带（delta）。
+    // 不存在、布局不符或已过期（块被擦写过、remap 变了）返回 false 且不做改动，调用方退回 rebuild_from_oob
+    bool load_checkpoint(const string &path);
+    // 在全新的 FTL 上一遍写入 NAND 页与 OOB、块计数、分配器各池与映射表（不计 WAF / 时序）；非全新返回 false
+    bool precondition(const PreconditionParams &pp);
     void dump_stats();
     void dump_page_stats();
+    // 设备侧映射元数据（L2P / P2L / 引用链 / 页状态 / 块有效计数 / 去重索引）的 DRAM 占用，不含读缓存
+    size_t mapping_dram_bytes() const;
+    // 块级遥测快照（列见 snapshot.h），代替逐块 / 逐页的文本输出；运行中途可调用，复用 s 的列缓冲
+    void capture_snapshot(BlockSnapshot &s) const;
+
+    // 空闲原生超级块低于该值时，每次原生页分配前做 just-in-time GC（0 = 仅在分配失败时）
+    void set_gc_free_watermark(int superblocks) { gc_free_watermark_ = superblocks; }
+    // 关闭 just-in-time 后，低于水位即按策略回收（策略比较时使用，让 victim 选择有余量）
+    void set_gc_just_in_time(bool on) { gc_just_in_time_ = on; }
+    // SLC folding 低水位：free SLC 超级块数低于 watermark 时才在写路径内同步 fold（默认 1：缓存用尽才 fold），
+    // 其余交给 idle() 在后台 fold
+    void set_slc_fold_watermark(int blocks) { slc_fold_watermark_ = blocks; }
+    // 写缓冲：主机写在其 program 距完成不超过 pages 个 program 时长时即返回（0 = 等 program 完成）
+    void set_write_buffer(int pages) { write_buffer_ns_ = (uint64_t)max(0, pages) * nand_drive.cell_params().t_prog_ns; }
+    // 异步主机（多队列接口）：读写在当前时钟下发后即返回，不把时钟推进到完成；完成时刻见 host_complete_ns()
+    void set_host_async(bool on) { host_async_ = on; }
+    uint64_t host_complete_ns() const { return host_complete_ns_; }
+    // 把仿真时钟推进到 t（不后退）
+    void advance_to(uint64_t t) { now_ns_ = max(now_ns_, t); }
+    // 主机空闲：推进仿真时钟，并在 die 空闲时后台 fold
+    void idle(uint64_t ns);
+    // fold 一个已写满的 SLC 条带：取有效比例最低的（剩下的是冷数据；全失效的只擦不搬），同比例取最老的
+    bool fold_slc_block();
+    const SlcStats &slc_stats() const { return slc_stats_; }
+    void dump_slc_stats();
+    uint64_t now_ns() const { return now_ns_; }
+
+    // GC victim 策略：编译期特化，可在构建时（FTL_GC_POLICY）或运行时切换
+    template <class Policy>
+    void set_gc_policy()
+    {
+        gc_select_ = &FTL::select_victim<Policy>;
+        gc_policy_name_ = Policy::name;
+    }
+    const char *gc_policy_name() const { return gc_policy_name_; }
+    const GcStats &gc_stats() const { return gc_stats_; }
+    void dump_gc_stats();
+
+    void set_refresh_params(const RefreshParams &rp) { refresh_params_ = rp; }
+    const RefreshStats &refresh_stats() const { return refresh_stats_; }
+    // 刷新统计 + 按来源拆分的写放大（host / GC / fold / refresh）
+    void dump_refresh_stats();
 
+    const WriteStats &write_stats() const { return write_stats_; }
+    // 每 host_sectors 个主机扇区写自动采一个点（0 = 关闭）；调用时清空序列并以当前计数为起点
+    void set_write_sample_interval(uint64_t host_sectors);
+    // 手动采一个点（如按仿真时间采样的 benchmark）
+    void sample_write_stats();
+    const vector<WriteSample> &write_samples() const { return write_samples_; }
+    // 按区间导出：区间 / 累计 WAF、GC 次数、每次 GC 搬移页、GC 回收效率
+    bool save_write_samples_csv(const string &path) const;
+    void dump_write_stats();
+
+    // 打开 / 关闭自适应 OP（从当前计数起算第一个 epoch）；调整同时记 INFO 日志
+    void set_adaptive_op(const AdaptiveOpParams &p);
+    const vector<OpAdjustment> &op_log() const { return op_log_; }
+    void dump_op_log();
+    // 当前导出的 LBA 数：超出的 LBA 读写按越界处理（自适应 OP 缩小时其数据被 trim）
+    int exported_lbas() const { return export_lbas_; }
+
+    // DRAM 读缓存：按 LBA 缓存读出的负载（S3-FIFO，见 read_cache.h），pages 为条目数（映射单元，0 = 关闭），
+    // 命中不下发 NAND 读、服务时间为 hit_ns；LBA 失去映射（覆盖写 / trim / 读失败丢弃）时失效，GC 搬移不改内容故保留
+    void set_read_cache(size_t pages, uint64_t hit_ns = 1000);
+    const ReadCache &read_cache() const { return read_cache_; }
+    // 命中率、省下的 NAND 读与 DRAM 占用
+    void dump_read_cache_stats();
+
+    // 去重：写路径按负载指纹查索引，命中则只增加物理页引用，不再 program
+    void set_dedup(bool on);
+    const DedupStats &dedup_stats() const { return dedup_stats_; }
+    // 去重率、省下的 program 与索引的 DRAM / CPU 开销
+    void dump_dedup_stats();
 
 private:
+    friend struct MicrobenchAccess; // ftl_microbench 直接测量私有热点函数
     NandDriver &nand_drive;
     NandRuntime &nand_runtime;
     BlockManager &block_manager;
+    const NandGeometry geo_;
     int total_pages_;
     uint64_t seq_;
 
+    // 映射单元为扇区：PSA = (PBA << sector_shift_) | slot；sectors_per_page_ == 1 时 PSA 即 PBA
+    int sectors_per_page_ = 1;
+    int sector_shift_ = 0;
+    int total_sectors_;
+    static constexpr int kInPackBuffer = -2; // L2P 取值：扇区还在打包缓冲里
+    struct PackEntry
+    {
+        int lba;
+        string data;
+        uint64_t fp;
+    };
+    vector<vector<PackEntry>> pack_; // [ns]：各 namespace 各自打包，页内不混租户
+    void flush_pack(int ns);
+
+    // 物理扇区可被多个 LBA 引用：P2L[psa] 为引用链表头，lba_next_/lba_prev_ 串起同一扇区的 LBA，
+    // page_ref_[psa] 为引用数；未开去重时每个扇区至多一个引用。pstate / page_fp_ 也按 PSA 索引
     vector<int> L2P, P2L;
+    vector<int> lba_next_, lba_prev_;
+    vector<uint32_t> page_ref_;
     vector<PageState> pstate;
+    vector<int> blk_valid_; // [runtime idx] 每个物理块的有效扇区数
+
+    // namespace：[ns_base_[i], ns_base_[i] + ns_size_[i]) 为第 i 个 namespace 的全局 LBA 区间，写入流号 = i
+    vector<int> ns_base_{0}, ns_size_;
+    vector<NamespaceStats> ns_stats_{NamespaceStats{}};
+    vector<WriteStats> ns_write_stats_{WriteStats{}}; // [ns] 按 namespace（写入流）拆分的写放大记账，各项之和即 write_stats_
+    // 不属于任何 namespace（各 namespace 之和以外）返回 -1
+    int ns_of(int lba) const
+    {
+        int ns = (int)(upper_bound(ns_base_.begin(), ns_base_.end(), lba) - ns_base_.begin()) - 1;
+        return ns < 0 || lba - ns_base_[ns] >= ns_size_[ns] ? -1 : ns;
+    }
+
+    // 策略看到的候选视图（接口见 gc_policy.h）；stream < 0 时为全部已写满的原生条带
+    class GcView
+    {
+    public:
+        GcView(FTL &f, int stream) : f_(f), stream_(stream) {}
+        const deque<int> &closed() const
+        {
+            return stream_ < 0 ? f_.block_manager.closed_superblocks() : f_.block_manager.closed_superblocks(stream_);
+        }
+        int valid(int sb) const { return f_.superblock_valid_sectors(sb); }
+        int capacity(int sb) const
+        {
+            return (int)f_.block_manager.superblock_members(sb).size() * f_.nand_drive.pages_per_block()
+                   << f_.sector_shift_;
+        }
+        uint64_t age(int sb) const
+        {
+            return f_.block_manager.close_ticks() - f_.block_manager.superblock_close_seq(sb);
+        }
+        uint32_t random() const { return f_.gc_rng_(); }
+
+    private:
+        FTL &f_;
+        int stream_;
+    };
+
+    template <class Policy>
+    int select_victim(int stream)
+    {
+        GcView v(*this, stream);
+        return Policy::select(v);
+    }
+    int (FTL::*gc_select_)(int) = nullptr;
+    const char *gc_policy_name_ = "";
+    mt19937 gc_rng_{12345};
+    GcStats gc_stats_;
+
+    // 仿真时钟：主机 QD1 闭环，写完成（或进入写缓冲）后才发下一个请求
+    uint64_t now_ns_ = 0;
+    uint64_t last_complete_ns_ = 0;
+    uint64_t write_buffer_ns_ = 0;
+    bool host_async_ = false;
+    uint64_t host_complete_ns_ = 0; // 最近一个主机读写的完成时刻（缓冲命中即为下发时刻）
+    int slc_fold_watermark_ = 1;
+    int gc_free_watermark_ = 1;
+    bool gc_just_in_time_ = true;
+    SlcStats slc_stats_;
+    WriteStats write_stats_;
+    uint64_t write_sample_interval_ = 0;
+    vector<WriteSample> write_samples_;
+    void count_host_sector(int ns);
+
+    AdaptiveOpParams aop_;
+    WriteStats aop_base_;             // 本 epoch 起点
+    uint64_t aop_reserve_allocs_ = 0; // 本 epoch 起点的 reserved 条带分配次数
+    double aop_bad_rate_ = 0;         // 每 plane 每 epoch 判坏数（指数平滑）
+    uint64_t aop_epoch_ = 0;
+    int aop_dir_[2] = {0, 0};         // reserve / export 上一次调整的方向（+1 / -1）
+    uint64_t aop_moved_[2] = {0, 0};  // 以及发生在哪个 epoch
+    int export_lbas_ = 0;
+    vector<OpAdjustment> op_log_;
+    void adapt_op();
+    void log_op(const char *knob, long from, long to, double eff, uint64_t bad);
+    void set_exported_lbas(int n);
+
+    // 刷新队列：按触发先后；refresh_pending_[sb] 防止重复入队
+    RefreshParams refresh_params_;
+    RefreshStats refresh_stats_;
+    deque<int> refresh_queue_;
+    vector<uint8_t> refresh_pending_;
+    double refresh_credit_ = 0;
+
+    // 去重索引：指纹 -> 持有该负载的有效页；page_fp_[pba] 供页失效 / 搬移时维护索引
+    bool dedup_ = false;
+    unordered_map<uint64_t, int> fp_index_;
+    vector<uint64_t> page_fp_;
+    DedupStats dedup_stats_;
+
+    ReadCache read_cache_;
+    uint64_t cache_hit_ns_ = 1000;
 
+    void mark_valid(int pba, int lba);
+    void mark_invalid(int pba);
+    void unmap_lba(int lba);
+    void move_refs(int from, int to);
+    void drop_fingerprint(int pba);
     bool program_pba_with_handling(int &pba, const string &data, int lba);
+    bool recover_program_fail(int &pba, const string &data, int lba);
+    // 批量搬移用的多目标读 / 写（ok[i]：第 i 个目标是否成功）
+    void read_pages(const vector<NandAddr> &targets, vector<string> &data, vector<uint8_t> &ok);
+    void program_pages(vector<int> &dst, const vector<string> &payload, const vector<int> &lba, vector<uint8_t> &ok);
     void erase_block_txn(int d, int p, int b /*PBN*/);
-    void run_gc();
+    void erase_superblock_txn(int sb);
+    enum class Reloc
+    {
+        GC,
+        FOLD,
+        REFRESH
+    };
+    bool relocate_superblock(int sb, Reloc why);
+    int superblock_valid_sectors(int sb) const;
+    // 装下 n 个扇区所需的页数
+    int pages_for(int sectors) const { return (sectors + sectors_per_page_ - 1) >> sector_shift_; }
+    bool program_host_page(const PackEntry *secs, int n, const string &payload, int stream);
+    void drop_from_pack(int lba);
+    // stream：请求空间的写入流，先在它自己的条带里选 victim；batch：调用方接下来要连续分配的页数（just-in-time 的余量）
+    bool run_gc(bool just_in_time = false, int stream = 0, int batch = 1);
+    int gc_owner(int stream) const;
+    // batch：本页起要连续分配的页数，just-in-time GC 按它留余量
+    int alloc_native_page(int stream, int batch = 1);
+    bool refresh_enabled() const { return refresh_params_.read_limit || refresh_params_.retention_ns; }
+    bool refresh_due(int sb) const;
+    void queue_refresh(int sb, bool by_read);
+    void check_read_disturb(int d, int p, int b);
+    void scan_retention();
+    bool refresh_tick(bool background);
 
     // helpers
+    pair<NandStatus, string> submit(NandOp &op);
+    void record_write_latency(uint64_t ns);
+    void trace_span(TraceKind kind, int sb, int moved);
     int drv_vbn_to_pbn(int d, int p, int vbn);
-    int pages_per_plane() const;
-    int pages_per_die() const;
-    int pba_from_indices(int d, int p, int b, int g) const;
-    tuple<int, int, int, int> idx_from_pba(int pba) const;
+    int pba_from_indices(int d, int p, int b, int g) const { return geo_.pba(d, p, b, g); }
+    int psa_of(int pba, int slot) const { return (pba << sector_shift_) | slot; }
+    void reset_mapping();
+    bool page_sector_lbas(int d, int p, int b, int g, int oob_lba, vector<int> &lbas);
+    int blk_of_psa(int psa) const
+    {
+        auto [d, p, b, g] = geo_.unpack(psa >> sector_shift_);
+        return nand_runtime.idx(d, p, b);
+    }
+    tuple<int, int, int, int> idx_from_pba(int pba) const { return geo_.unpack(pba); }
 };
 
 #endif // FTL_H
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "ftl.h"
+
+/* ---------------- ftl_microbench：热路径微基准 ----------------
+   隔离测量 BlockManager / NandDriver / FTL 的热点函数，多种几何，结果输出 JSON。
+   用法：ftl_microbench [--out result.json] [--baseline base.json] [--threshold pct]
+                        [--filter substr] [--min-ms N] [--reps N]
+   - 每个用例重复 reps 次，每次至少 min-ms 毫秒，取 ns/op 中位数；准备工作不计时
+   - 给出 --baseline 时逐项对比，ns/op 变慢超过 threshold% 记为回归，进程返回 2
+*/
+
+// 私有接口的访问入口（BlockManager / FTL 声明为 friend）
+struct MicrobenchAccess
+{
+    static int pick_vbn_wear_aware(BlockManager &bm, deque<int> &q, int d, int p) { return bm.pick_vbn_wear_aware(q, d, p); }
+    static void attach_lane(BlockManager &bm, int d, int p, int vbn) { bm.attach_lane(d, p, vbn); }
+    static int reverse_resolve_vbn(const BlockManager &bm, int d, int p, int pbn) { return bm.reverse_resolve_vbn(d, p, pbn); }
+    static bool run_gc(FTL &ftl) { return ftl.run_gc(); }
+};
+
+struct BenchGeometry
+{
+    int dies, planes, blocks, pages;
+    string name() const
+    {
+        return to_string(dies) + "x" + to_string(planes) + "x" + to_string(blocks) + "x" + to_string(pages);
+    }
+};
+
+// 一套完整的仿真对象（模型、运行态、驱动、分配器、FTL）
+struct BenchRig
+{
+    static constexpr int kReservedWrite = 1, kReservedSpare = 2;
+    BenchGeometry g;
+    NandModel model;
+    NandRuntime runtime;
+    NandDriver driver;
+    BlockManager bm;
+    unique_ptr<FTL> ftl;
+    int lbas;
+
+    explicit BenchRig(const BenchGeometry &geo, bool with_ftl = true)
+        : g(geo), model(geo.dies, geo.planes, geo.blocks, geo.pages), runtime(geo.dies, geo.planes, geo.blocks),
+          driver(model, runtime), bm(driver, runtime, kReservedWrite, kReservedSpare)
+    {
+        int writable = (geo.blocks - kReservedWrite - kReservedSpare) * geo.pages * geo.planes * geo.dies;
+        lbas = writable * 85 / 100;
+        if (with_ftl)
+            ftl = make_unique<FTL>(driver, runtime, bm, lbas);
+        else
+            bm.init_from_bbt([this](int d, int p, int b) { return driver.is_block_bad(d, p, b); });
+    }
+};
+
+// 计时器：用例自己决定哪些代码计时
+struct BenchTimer
+{
+    chrono::steady_clock::time_point t0;
+    uint64_t ns = 0;
+    void start() { t0 = chrono::steady_clock::now(); }
+    void stop() { ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count(); }
+};
+
+// 跑一批，返回本批的操作数（计时累计在 timer 中）
+using BenchBody = function<uint64_t(BenchTimer &)>;
+
+struct BenchResult
+{
+    string name, geometry;
+    double ns_per_op = 0;
+    uint64_t ops = 0;
+};
+
+struct BenchOptions
+{
+    int min_ms = 50;
+    int reps = 5;
+    string filter;
+};
+
+static volatile int g_sink; // 防止结果被优化掉
+
+static BenchResult run_bench(const BenchOptions &opt, const string &name, const BenchGeometry &g, BenchBody body)
+{
+    vector<double> samples;
+    uint64_t total_ops = 0;
+    for (int r = 0; r < opt.reps; ++r)
+    {
+        BenchTimer t;
+        uint64_t ops = 0;
+        while (t.ns < (uint64_t)opt.min_ms * 1000000ull)
+        {
+            uint64_t n = body(t);
+            if (n == 0)
+                break;
+            ops += n;
+        }
+        if (ops)
+            samples.push_back((double)t.ns / ops);
+        total_ops += ops;
+    }
+    BenchResult res{name, g.name(), 0, total_ops};
+    if (!samples.empty())
+    {
+        sort(samples.begin(), samples.end());
+        res.ns_per_op = samples[samples.size() / 2];
+    }
+    cerr << left << setw(24) << name << setw(14) << g.name() << right << fixed << setprecision(1)
+         << setw(12) << res.ns_per_op << " ns/op\n";
+    return res;
+}
+
+// 把 FTL 写到稳态：顺序写满后随机覆盖一遍
+static void precondition(BenchRig &rig, mt19937 &rng)
+{
+    for (int l = 0; l < rig.lbas; ++l)
+        rig.ftl->write(l, "D");
+    for (int i = 0; i < rig.lbas; ++i)
+        rig.ftl->write(rng() % rig.lbas, "D");
+}
+
+// PBA 解包：几何是编译期常量时编译器把移位量 / 掩码折叠成立即数，与运行时的 NandGeometry（FTL / BlockManager 持有的）对照
+template <int D, int P, int B, int G>
+static int unpack_const(const vector<int> &pbas)
+{
+    static constexpr NandGeometry kGeo(D, P, B, G);
+    int acc = 0;
+    for (int pba : pbas)
+    {
+        auto [d, p, b, g] = kGeo.unpack(pba);
+        acc += d + p + b + g;
+    }
+    return acc;
+}
+
+using UnpackFn = int (*)(const vector<int> &);
+static UnpackFn const_unpacker(const BenchGeometry &g)
+{
+    if (g.dies == 1 && g.planes == 1 && g.blocks == 64 && g.pages == 64)
+        return unpack_const<1, 1, 64, 64>;
+    if (g.dies == 2 && g.planes == 2 && g.blocks == 128 && g.pages == 64)
+        return unpack_const<2, 2, 128, 64>;
+    if (g.dies == 4 && g.planes == 4 && g.blocks == 128 && g.pages == 128)
+        return unpack_const<4, 4, 128, 128>;
+    return nullptr;
+}
+
+static void bench_geometry(const BenchOptions &opt, const BenchGeometry &g, vector<BenchResult> &out)
+{
+    auto want = [&](const string &name) { return opt.filter.empty() || name.find(opt.filter) != string::npos; };
+    auto add = [&](const string &name, BenchBody body)
+    {
+        if (want(name))
+            out.push_back(run_bench(opt, name, g, move(body)));
+    };
+
+    // BlockManager::alloc_page：单 plane 连续分配直到耗尽，耗尽后重建分配器（不计时）
+    {
+        unique_ptr<BenchRig> rig;
+        add("alloc_page", [&](BenchTimer &t) -> uint64_t
+        {
+            rig = make_unique<BenchRig>(g, false);
+            uint64_t n = 0;
+            t.start();
+            while (true)
+            {
+                int pba = rig->bm.alloc_page((int)(n % g.dies), (int)((n / g.dies) % g.planes));
+                if (pba == -1)
+                    break;
+                g_sink = pba;
+                n++;
+            }
+            t.stop();
+            return n;
+        });
+    }
+
+    // pick_vbn_wear_aware：在完整的 free 列表上挑选直到取空，之后放回（不计时）
+    {
+        BenchRig rig(g, false);
+        add("pick_vbn_wear_aware", [&](BenchTimer &t) -> uint64_t
+        {
+            deque<int> q;
+            for (int v = 0; v < g.blocks - BenchRig::kReservedSpare; ++v)
+                q.push_back(v);
+            vector<int> picked;
+            t.start();
+            while (!q.empty())
+            {
+                int v = MicrobenchAccess::pick_vbn_wear_aware(rig.bm, q, 0, 0);
+                if (v == -1)
+                    break;
+                picked.push_back(v);
+            }
+            t.stop();
+            for (int v : picked)
+                MicrobenchAccess::attach_lane(rig.bm, 0, 0, v);
+            return picked.size();
+        });
+    }
+
+    // resolve_pbn / reverse_resolve_vbn：随机地址查表
+    {
+        BenchRig rig(g, false);
+        vector<array<int, 3>> addrs(4096);
+        mt19937 rng(7);
+        for (auto &a : addrs)
+            a = {(int)(rng() % g.dies), (int)(rng() % g.planes), (int)(rng() % g.blocks)};
+        add("resolve_pbn", [&](BenchTimer &t) -> uint64_t
+        {
+            int acc = 0;
+            t.start();
+            for (const auto &a : addrs)
+                acc += rig.bm.resolve_pbn(a[0], a[1], a[2]);
+            t.stop();
+            g_sink = acc;
+            return addrs.size();
+        });
+        add("reverse_resolve_vbn", [&](BenchTimer &t) -> uint64_t
+        {
+            int acc = 0;
+            t.start();
+            for (const auto &a : addrs)
+                acc += MicrobenchAccess::reverse_resolve_vbn(rig.bm, a[0], a[1], a[2]);
+            t.stop();
+            g_sink = acc;
+            return addrs.size();
+        });
+    }
+
+    // PBA 解包：运行时几何（移位量在成员里）/ 编译期几何（移位折叠成立即数）/ 同形状去掉一页的非 2 的幂几何（乘除法）
+    {
+        vector<int> pbas(4096);
+        mt19937 rng(5);
+        NandGeometry geo(g.dies, g.planes, g.blocks, g.pages);
+        for (auto &x : pbas)
+            x = (int)(rng() % geo.total_pages());
+        auto runtime_unpack = [&pbas](const NandGeometry &gm)
+        {
+            int acc = 0;
+            for (int pba : pbas)
+            {
+                auto [d, p, b, pg] = gm.unpack(pba);
+                acc += d + p + b + pg;
+            }
+            return acc;
+        };
+        add("pba_unpack", [&](BenchTimer &t) -> uint64_t
+        {
+            t.start();
+            g_sink = runtime_unpack(geo);
+            t.stop();
+            return pbas.size();
+        });
+        if (UnpackFn fn = const_unpacker(g))
+            add("pba_unpack_const", [&, fn](BenchTimer &t) -> uint64_t
+            {
+                t.start();
+                g_sink = fn(pbas);
+                t.stop();
+                return pbas.size();
+            });
+        NandGeometry odd(g.dies, g.planes, g.blocks, g.pages - 1);
+        vector<int> odd_pbas(pbas.size());
+        for (size_t i = 0; i < pbas.size(); ++i)
+            odd_pbas[i] = pbas[i] % odd.total_pages();
+        add("pba_unpack_generic", [&](BenchTimer &t) -> uint64_t
+        {
+            swap(pbas, odd_pbas);
+            t.start();
+            g_sink = runtime_unpack(odd);
+            t.stop();
+            swap(pbas, odd_pbas);
+            return pbas.size();
+        });
+    }
+
+    // NandDriver::submit：按命令分别测量；program 顺序写满一个块后擦除（不计时）
+    {
+        BenchRig rig(g, false);
+        int blk = 0;
+        add("submit_program", [&](BenchTimer &t) -> uint64_t
+        {
+            int d = blk % g.dies, p = (blk / g.dies) % g.planes;
+            NandOp op;
+            op.cmd = NandCmd::PROGRAM_PAGE;
+            op.targets.push_back({d, p, 0, 0});
+            op.data.push_back("D");
+            op.oob_lba.push_back(0);
+            op.oob_seq.push_back(1);
+            t.start();
+            for (int pg = 0; pg < g.pages; ++pg)
+            {
+                op.targets[0].page = pg;
+                g_sink = (int)rig.driver.submit(op).first;
+            }
+            t.stop();
+            NandOp er;
+            er.cmd = NandCmd::ERASE_BLOCK;
+            er.targets.push_back({d, p, 0, -1});
+            rig.driver.submit(er);
+            blk++;
+            return g.pages;
+        });
+        add("submit_read", [&](BenchTimer &t) -> uint64_t
+        {
+            NandOp op;
+            op.cmd = NandCmd::READ_PAGE;
+            op.targets.push_back({0, 0, 2, 0});
+            t.start();
+            for (int pg = 0; pg < g.pages; ++pg)
+            {
+                op.targets[0].page = pg;
+                g_sink = (int)rig.driver.submit(op).first;
+            }
+            t.stop();
+            return g.pages;
+        });
+        add("submit_erase", [&](BenchTimer &t) -> uint64_t
+        {
+            NandOp op;
+            op.cmd = NandCmd::ERASE_BLOCK;
+            op.targets.push_back({0, 0, 0, -1});
+            t.start();
+            for (int b = 2; b < g.blocks; ++b)
+            {
+                op.targets[0].block = b;
+                g_sink = (int)rig.driver.submit(op).first;
+            }
+            t.stop();
+            return g.blocks - 2;
+        });
+    }
+
+    // FTL::write 稳态随机覆盖写（含 GC）
+    if (want("ftl_write_steady"))
+    {
+        BenchRig rig(g);
+        mt19937 rng(11);
+        precondition(rig, rng);
+        add("ftl_write_steady", [&](BenchTimer &t) -> uint64_t
+        {
+            const int n = 1024;
+            t.start();
+            for (int i = 0; i < n; ++i)
+                rig.ftl->write(rng() % rig.lbas, "D");
+            t.stop();
+            return n;
+        });
+    }
+
+    // FTL::run_gc：稳态下每批回收若干次，再随机写补充候选（不计时）；
+    // 不能回收到放不下为止：全有效条带会被反复搬移，永远不会失败
+    if (want("ftl_run_gc"))
+    {
+        BenchRig rig(g);
+        mt19937 rng(13);
+        precondition(rig, rng);
+        add("ftl_run_gc", [&](BenchTimer &t) -> uint64_t
+        {
+            const int n = 4;
+            for (int i = 0; i < n; ++i)
+            {
+                t.start();
+                bool ok = MicrobenchAccess::run_gc(*rig.ftl);
+                t.stop();
+                if (!ok)
+                    break;
+            }
+            for (int i = 0; i < n * g.pages * g.dies * g.planes; ++i)
+                rig.ftl->write(rng() % rig.lbas, "D");
+            return n;
+        });
+    }
+}
+
+static void write_json(ostream &os, const vector<BenchResult> &res)
+{
+    os << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < res.size(); ++i)
+    {
+        const auto &r = res[i];
+        os << "    {\"name\": \"" << r.name << "\", \"geometry\": \"" << r.geometry << "\", \"ns_per_op\": "
+           << fixed << setprecision(2) << r.ns_per_op << ", \"ops\": " << r.ops << "}"
+           << (i + 1 < res.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+// 读回 write_json 的输出：只识别本工具写出的扁平格式
+static map<pair<string, string>, double> read_json(const string &path)
+{
+    map<pair<string, string>, double> out;
+    ifstream is(path);
+    if (!is)
+    {
+        cerr << "[BENCH] cannot open baseline " << path << "\n";
+        return out;
+    }
+    auto field = [](const string &line, const string &key) -> string
+    {
+        size_t k = line.find("\"" + key + "\"");
+        if (k == string::npos)
+            return "";
+        size_t c = line.find(':', k);
+        size_t b = line.find_first_not_of(" \"", c + 1);
+        size_t e = line.find_first_of("\",}", b);
+        return line.substr(b, e - b);
+    };
+    string line;
+    while (getline(is, line))
+    {
+        string name = field(line, "name"), geo = field(line, "geometry"), ns = field(line, "ns_per_op");
+        if (!name.empty() && !ns.empty())
+            out[{name, geo}] = stod(ns);
+    }
+    return out;
+}
+
+static int compare(const vector<BenchResult> &res, const string &baseline, double threshold_pct)
+{
+    auto base = read_json(baseline);
+    int regressions = 0;
+    cerr << "\n" << left << setw(24) << "benchmark" << setw(14) << "geometry" << right << setw(12) << "base"
+         << setw(12) << "now" << setw(10) << "delta" << "\n";
+    for (const auto &r : res)
+    {
+        auto it = base.find({r.name, r.geometry});
+        if (it == base.end() || it->second <= 0)
+            continue;
+        double delta = (r.ns_per_op - it->second) / it->second * 100.0;
+        bool bad = delta > threshold_pct;
+        regressions += bad;
+        cerr << left << setw(24) << r.name << setw(14) << r.geometry << right << fixed << setprecision(1)
+             << setw(12) << it->second << setw(12) << r.ns_per_op << setw(9) << delta << "%"
+             << (bad ? "  REGRESSION" : "") << "\n";
+    }
+    cerr << regressions << " regression(s) over " << threshold_pct << "%\n";
+    return regressions ? 2 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt;
+    string out_path, baseline;
+    double threshold = 10.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)
+            out_path = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            baseline = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc)
+            threshold = stod(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc)
+            opt.filter = argv[++i];
+        else if (arg == "--min-ms" && i + 1 < argc)
+            opt.min_ms = stoi(argv[++i]);
+        else if (arg == "--reps" && i + 1 < argc)
+            opt.reps = max(1, stoi(argv[++i]));
+        else
+        {
+            cerr << "usage: ftl_microbench [--out f.json] [--baseline f.json] [--threshold pct] [--filter s] [--min-ms N] [--reps N]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+
+    const vector<BenchGeometry> geometries = {
+        {1, 1, 64, 64},
+        {2, 2, 128, 64},
+        {4, 4, 128, 128},
+    };
+    vector<BenchResult> results;
+    for (const auto &g : geometries)
+        bench_geometry(opt, g, results);
+
+    if (out_path.empty())
+        write_json(cout, results);
+    else
+    {
+        ofstream os(out_path);
+        write_json(os, results);
+    }
+    return baseline.empty() ? 0 : compare(results, baseline, threshold);
+}
@@ -0,0 +1,296 @@
+#include "ftl.h"
+
+/* ---------------- 设计空间扫描 ----------------
+   参数网格的每个点各自构建一套 NandModel/NandRuntime/NandDriver/BlockManager/FTL，
+   在线程池上并发运行；各点结果写入自己的槽位，全部结束后由主线程汇总输出一个 CSV。
+   工作线程不打印、不写全局状态（日志关闭，trace 不开）。
+   用法：ftl_sweep [--dies 1,2] [--planes 1,2] [--blocks 32,64] [--pages 16,32]
+                   [--reserved-write 1] [--reserved-spare 2] [--op 0.1,0.2] [--slc 0,2]
+                   [--policy greedy,cost-benefit] [--workload uniform,hotcold]
+                   [--turns N] [--seed S] [--pe-limit N] [--factory-bad N] [--jobs N] [--out results.csv]
+   列表参数用逗号分隔，取笛卡尔积。
+   --op：用户容量之外留作 OP 的比例（相对可写容量）
+   --pe-limit：原生块 P/E 上限（0 = 不限），达到后擦除失败，消耗 spare 池
+   --factory-bad：每个点随机注入的出厂坏块数（按点号播种，可复现）
+*/
+
+struct SweepPoint
+{
+    int dies = 1, planes = 1, blocks = 32, pages = 16;
+    int reserved_write = 1, reserved_spare = 2, slc = 0;
+    double op = 0.1;
+    string policy = "greedy";
+    string workload = "uniform";
+};
+
+struct SweepResult
+{
+    string status = "ok"; // ok / invalid / data_loss
+    int lbas = 0;
+    uint64_t host_writes = 0;
+    uint64_t nand_programs = 0;
+    double waf = 0;
+    uint64_t gc_runs = 0;
+    uint32_t erase_min = 0, erase_max = 0;
+    double erase_mean = 0, erase_stddev = 0;
+    int bad_blocks = 0;  // BBT 中的坏块（出厂 + 运行时）
+    int grown_bad = 0;   // 运行期检测到的坏块
+    int spare_left = 0;  // spare 池剩余
+    int lost_lbas = 0;   // 读回与最后一次写不一致的 LBA
+    uint64_t sim_ms = 0; // 仿真时钟
+    double wall_ms = 0;  // 该点的运行时间
+};
+
+struct SweepOptions
+{
+    int turns = 4;
+    uint32_t seed = 1;
+    uint32_t pe_limit = 0;
+    int factory_bad = 0;
+};
+
+static vector<string> split_list(const string &s)
+{
+    vector<string> v;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            v.push_back(item);
+    return v;
+}
+
+static bool set_policy(FTL &ftl, const string &name)
+{
+    if (name == GreedyPolicy::name)
+        ftl.set_gc_policy<GreedyPolicy>();
+    else if (name == CostBenefitPolicy::name)
+        ftl.set_gc_policy<CostBenefitPolicy>();
+    else if (name == DChoicesPolicy<4>::name)
+        ftl.set_gc_policy<DChoicesPolicy<4>>();
+    else if (name == WindowedGreedyPolicy<8>::name)
+        ftl.set_gc_policy<WindowedGreedyPolicy<8>>();
+    else
+        return false;
+    return true;
+}
+
+static SweepResult run_point(const SweepPoint &pt, const SweepOptions &opt, size_t index)
+{
+    SweepResult r;
+    auto w0 = chrono::steady_clock::now();
+    int data_blocks = pt.blocks - pt.reserved_write - pt.reserved_spare - pt.slc;
+    int writable = data_blocks * pt.pages * pt.planes * pt.dies;
+    r.lbas = (int)(writable * (1.0 - pt.op));
+    if (data_blocks < 2 || r.lbas <= 0 || pt.op < 0 || pt.op >= 1)
+    {
+        r.status = "invalid";
+        return r;
+    }
+
+    NandModel model(pt.dies, pt.planes, pt.blocks, pt.pages);
+    NandRuntime runtime(pt.dies, pt.planes, pt.blocks);
+    NandDriver driver(model, runtime);
+    NandCellParams cp;
+    cp.pe_limit = opt.pe_limit;
+    driver.set_cell_params(cp);
+    mt19937 rng(opt.seed + (uint32_t)index * 7919u);
+    for (int i = 0; i < opt.factory_bad; ++i)
+        driver.inject_factory_bad(rng() % pt.dies, rng() % pt.planes, rng() % pt.blocks);
+    BlockManager bm(driver, runtime, pt.reserved_write, pt.reserved_spare, pt.slc);
+    FTL ftl(driver, runtime, bm, r.lbas);
+    if (!set_policy(ftl, pt.policy))
+    {
+        r.status = "invalid";
+        return r;
+    }
+
+    // 顺序写满后随机覆盖写 turns 遍（hotcold：80% 写落在 20% 的 LBA）；WAF 只算覆盖写阶段
+    vector<int> last(r.lbas, -1);
+    int seq = 0;
+    for (int lba = 0; lba < r.lbas; ++lba, ++seq)
+    {
+        ftl.write(lba, "W" + to_string(seq));
+        last[lba] = seq;
+    }
+    uint64_t prog0 = driver.get_stats().program_ops;
+    uint64_t gc0 = ftl.gc_stats().runs;
+    int hot = max(1, r.lbas / 5);
+    for (long i = 0; i < (long)r.lbas * opt.turns; ++i, ++seq)
+    {
+        int lba;
+        if (pt.workload == "hotcold")
+            lba = rng() % 100 < 80 ? rng() % hot : hot + rng() % max(1, r.lbas - hot);
+        else
+            lba = rng() % r.lbas;
+        ftl.write(lba, "W" + to_string(seq));
+        last[lba] = seq;
+        r.host_writes++;
+    }
+    ftl.flush_pack();
+    r.nand_programs = driver.get_stats().program_ops - prog0;
+    r.waf = r.host_writes ? (double)r.nand_programs / r.host_writes : 0.0;
+    r.gc_runs = ftl.gc_stats().runs - gc0;
+
+    string out;
+    for (int lba = 0; lba < r.lbas; ++lba)
+        if (!ftl.read_lba(lba, out) || out != "W" + to_string(last[lba]))
+            r.lost_lbas++;
+    if (r.lost_lbas)
+        r.status = "data_loss";
+
+    // 擦除分布只统计 BBT 外的块
+    vector<uint32_t> ec;
+    for (int d = 0; d < pt.dies; ++d)
+        for (int p = 0; p < pt.planes; ++p)
+            for (int b = 0; b < pt.blocks; ++b)
+            {
+                if (runtime.bad_block_table[runtime.idx(d, p, b)])
+                    r.bad_blocks++;
+                else
+                    ec.push_back(runtime.erase_count[runtime.idx(d, p, b)]);
+            }
+    if (!ec.empty())
+    {
+        auto [mn, mx] = minmax_element(ec.begin(), ec.end());
+        r.erase_min = *mn;
+        r.erase_max = *mx;
+        double sum = accumulate(ec.begin(), ec.end(), 0.0), sq = 0;
+        r.erase_mean = sum / ec.size();
+        for (uint32_t e : ec)
+            sq += (e - r.erase_mean) * (e - r.erase_mean);
+        r.erase_stddev = sqrt(sq / ec.size());
+    }
+    r.grown_bad = (int)driver.get_stats().bad_blocks_detected;
+    r.spare_left = bm.spare_blocks_left();
+    r.sim_ms = ftl.now_ns() / 1000000;
+    r.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - w0).count();
+    return r;
+}
+
+static void write_csv(ostream &os, const vector<SweepPoint> &pts, const vector<SweepResult> &res)
+{
+    os << "dies,planes,blocks,pages,reserved_write,reserved_spare,slc,op,policy,workload,"
+          "status,lbas,host_writes,nand_programs,waf,gc_runs,erase_min,erase_max,erase_mean,erase_stddev,"
+          "bad_blocks,grown_bad,spare_left,lost_lbas,sim_ms,wall_ms\n";
+    for (size_t i = 0; i < pts.size(); ++i)
+    {
+        const auto &p = pts[i];
+        const auto &r = res[i];
+        os << p.dies << ',' << p.planes << ',' << p.blocks << ',' << p.pages << ',' << p.reserved_write << ','
+           << p.reserved_spare << ',' << p.slc << ',' << p.op << ',' << p.policy << ',' << p.workload << ','
+           << r.status << ',' << r.lbas << ',' << r.host_writes << ',' << r.nand_programs << ','
+           << fixed << setprecision(4) << r.waf << ',' << r.gc_runs << ',' << r.erase_min << ',' << r.erase_max
+           << ',' << setprecision(2) << r.erase_mean << ',' << r.erase_stddev << ',' << r.bad_blocks << ','
+           << r.grown_bad << ',' << r.spare_left << ',' << r.lost_lbas << ',' << r.sim_ms << ','
+           << setprecision(1) << r.wall_ms << defaultfloat << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    map<string, vector<string>> grid = {
+        {"--dies", {"1", "2"}},
+        {"--planes", {"2"}},
+        {"--blocks", {"32", "64"}},
+        {"--pages", {"16"}},
+        {"--reserved-write", {"1"}},
+        {"--reserved-spare", {"2"}},
+        {"--op", {"0.07", "0.15", "0.28"}},
+        {"--slc", {"0", "2"}},
+        {"--policy", {"greedy"}},
+        {"--workload", {"uniform", "hotcold"}},
+    };
+    SweepOptions opt;
+    int jobs = (int)max(1u, thread::hardware_concurrency());
+    string out_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (grid.count(arg) && i + 1 < argc)
+            grid[arg] = split_list(argv[++i]);
+        else if (arg == "--turns" && i + 1 < argc)
+            opt.turns = stoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            opt.seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--pe-limit" && i + 1 < argc)
+            opt.pe_limit = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--factory-bad" && i + 1 < argc)
+            opt.factory_bad = stoi(argv[++i]);
+        else if (arg == "--jobs" && i + 1 < argc)
+            jobs = max(1, stoi(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc)
+            out_path = argv[++i];
+        else
+        {
+            cerr << "usage: ftl_sweep [--dies L] [--planes L] [--blocks L] [--pages L] [--reserved-write L]"
+                    " [--reserved-spare L] [--op L] [--slc L] [--policy L] [--workload L]"
+                    " [--turns N] [--seed S] [--pe-limit N] [--factory-bad N] [--jobs N] [--out file.csv]\n";
+            return 1;
+        }
+    }
+    for (auto &[k, v] : grid)
+        if (v.empty())
+        {
+            cerr << "empty list for " << k << "\n";
+            return 1;
+        }
+
+    // 笛卡尔积展开
+    vector<SweepPoint> pts(1);
+    auto expand = [&](const string &key, auto apply)
+    {
+        vector<SweepPoint> next;
+        for (const auto &p : pts)
+            for (const auto &val : grid[key])
+            {
+                SweepPoint q = p;
+                apply(q, val);
+                next.push_back(q);
+            }
+        pts.swap(next);
+    };
+    expand("--dies", [](SweepPoint &p, const string &v) { p.dies = stoi(v); });
+    expand("--planes", [](SweepPoint &p, const string &v) { p.planes = stoi(v); });
+    expand("--blocks", [](SweepPoint &p, const string &v) { p.blocks = stoi(v); });
+    expand("--pages", [](SweepPoint &p, const string &v) { p.pages = stoi(v); });
+    expand("--reserved-write", [](SweepPoint &p, const string &v) { p.reserved_write = stoi(v); });
+    expand("--reserved-spare", [](SweepPoint &p, const string &v) { p.reserved_spare = stoi(v); });
+    expand("--slc", [](SweepPoint &p, const string &v) { p.slc = stoi(v); });
+    expand("--op", [](SweepPoint &p, const string &v) { p.op = stod(v); });
+    expand("--policy", [](SweepPoint &p, const string &v) { p.policy = v; });
+    expand("--workload", [](SweepPoint &p, const string &v) { p.workload = v; });
+
+    // 各实例的日志会交错且互相争用输出：整体关闭
+    Logger::set_level(LogLevel::OFF);
+
+    vector<SweepResult> res(pts.size());
+    atomic<size_t> next{0};
+    auto w0 = chrono::steady_clock::now();
+    vector<thread> pool;
+    jobs = min(jobs, (int)pts.size());
+    for (int t = 0; t < jobs; ++t)
+        pool.emplace_back([&]
+                          {
+                              for (size_t i; (i = next.fetch_add(1)) < pts.size();)
+                                  res[i] = run_point(pts[i], opt, i);
+                          });
+    for (auto &th : pool)
+        th.join();
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - w0).count();
+
+    if (out_path.empty())
+        write_csv(cout, pts, res);
+    else
+    {
+        ofstream f(out_path);
+        if (!f)
+        {
+            cerr << "cannot write " << out_path << "\n";
+            return 1;
+        }
+        write_csv(f, pts, res);
+    }
+    cerr << pts.size() << " points, " << jobs << " jobs, " << fixed << setprecision(2) << wall << " s\n";
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "ftl.h"
+
+/* ---------------- GC 策略 benchmark ----------------
+   同一 trace 依次跑各 GC victim 策略，比较 WAF 与 GC CPU 时间。
+   用法：gc_bench [--policy greedy|cost-benefit|d-choices|windowed-greedy]
+                  [--workload uniform|hotcold] [--turns N] [--seed S] [--dedup PCT]
+                  [--sectors N] [--series PREFIX] [--snapshot PREFIX] [--precondition SPREAD]
+   trace：先顺序写满全部 LBA，再随机覆盖写 turns 遍（hotcold：80% 写落在 20% 的 LBA）
+   --dedup：打开在线去重，PCT% 的写入负载取自 64 个公共值，其余各不相同
+   --sectors：子页映射，每页 N 个扇区，LBA 为扇区；WAF 按扇区计（program 实际写下的扇区 / 主机扇区写，未凑满的打包页不按整页算）
+   --series：预写之后每 LBA 数 / 8 个主机写采一个点，写到 PREFIX_<workload>_<policy>.csv（区间 WAF、GC 效率）
+   --snapshot：每次运行结束时保存块级快照 PREFIX_<workload>_<policy>.snap（用 snap_view 查看）
+   --precondition：不做顺序预写，用 FTL::precondition 直接合成写满后的稳态（条带有效率按 ±SPREAD 分布）
+*/
+
+struct BenchConfig
+{
+    int dies = 2, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85; // 逻辑容量占可写容量的比例（其余为 OP）
+    int dedup_pct = -1;       // < 0：不去重，所有写入同一负载
+    int sectors = 1;          // 每页扇区数
+    string series;            // 非空：WAF 时间序列 CSV 的文件名前缀
+    string snapshot;          // 非空：块级快照的文件名前缀
+    double precondition = -1; // >= 0：合成稳态代替顺序预写，值为 valid_spread
+};
+
+struct BenchResult
+{
+    string policy;
+    uint64_t host_writes = 0;
+    FTL::WriteStats writes; // 测量区间内的写放大记账
+    int sectors = 1;
+    FTL::GcStats gc;
+    FTL::DedupStats dedup;
+};
+
+static int user_lbas(const BenchConfig &c)
+{
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    return (int)(writable * c.user_ratio) * c.sectors;
+}
+
+static vector<int> make_trace(const string &workload, int lbas, int turns, uint32_t seed)
+{
+    vector<int> t;
+    for (int i = 0; i < lbas; ++i)
+        t.push_back(i);
+    mt19937 rng(seed);
+    int hot = max(1, lbas / 5);
+    for (long i = 0; i < (long)lbas * turns; ++i)
+    {
+        if (workload == "hotcold" && rng() % 100 < 80)
+            t.push_back(rng() % hot);
+        else if (workload == "hotcold")
+            t.push_back(hot + rng() % (lbas - hot));
+        else
+            t.push_back(rng() % lbas);
+    }
+    return t;
+}
+
+static vector<string> make_payloads(const BenchConfig &c, size_t n, uint32_t seed)
+{
+    vector<string> v(n, "D");
+    if (c.dedup_pct < 0)
+        return v;
+    mt19937 rng(seed ^ 0x9e3779b9u);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = (int)(rng() % 100) < c.dedup_pct ? "Z" + to_string(rng() % 64) : "D" + to_string(i);
+    return v;
+}
+
+template <class Policy>
+static BenchResult run_policy(const BenchConfig &c, const string &workload, const vector<int> &trace,
+                              const vector<string> &payload, int lbas)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    FTL ftl(driver, runtime, bm, lbas, c.sectors);
+    ftl.set_gc_policy<Policy>();
+    // 低于 2 个空闲条带即回收，给策略留出选择余量
+    ftl.set_gc_free_watermark(2);
+    ftl.set_gc_just_in_time(false);
+    ftl.set_dedup(c.dedup_pct >= 0);
+
+    // 顺序预写（或合成稳态）不计入 WAF
+    size_t i = 0;
+    if (c.precondition >= 0)
+    {
+        FTL::PreconditionParams pp;
+        pp.valid_spread = c.precondition;
+        pp.payload = payload[0];
+        ftl.precondition(pp);
+        i = min((size_t)lbas, trace.size());
+    }
+    for (; i < (size_t)lbas && i < trace.size(); ++i)
+        ftl.write(trace[i], payload[i]);
+    FTL::WriteStats ws0 = ftl.write_stats();
+    FTL::GcStats gc0 = ftl.gc_stats();
+    FTL::DedupStats dd0 = ftl.dedup_stats();
+    if (!c.series.empty())
+        ftl.set_write_sample_interval(max(1, lbas / 8));
+    BenchResult r;
+    r.policy = Policy::name;
+    for (; i < trace.size(); ++i)
+    {
+        ftl.write(trace[i], payload[i]);
+        r.host_writes++;
+    }
+    r.writes = ftl.write_stats() - ws0;
+    r.sectors = ftl.sectors_per_page();
+    r.gc = ftl.gc_stats();
+    r.gc.runs -= gc0.runs;
+    r.gc.relocated_pages -= gc0.relocated_pages;
+    r.gc.select_calls -= gc0.select_calls;
+    r.gc.select_ns -= gc0.select_ns;
+    r.gc.gc_ns -= gc0.gc_ns;
+    r.dedup = ftl.dedup_stats();
+    r.dedup.lookups -= dd0.lookups;
+    r.dedup.hits -= dd0.hits;
+    r.dedup.fp_ns -= dd0.fp_ns;
+    if (!c.series.empty())
+        ftl.save_write_samples_csv(c.series + "_" + workload + "_" + Policy::name + ".csv");
+    if (!c.snapshot.empty())
+    {
+        BlockSnapshot snap;
+        ftl.capture_snapshot(snap);
+        snap.save(c.snapshot + "_" + workload + "_" + Policy::name + ".snap");
+    }
+    return r;
+}
+
+static void print_result(const string &workload, const BenchResult &r)
+{
+    double waf = r.writes.waf(r.sectors);
+    double sel_avg_ns = r.gc.select_calls ? (double)r.gc.select_ns / r.gc.select_calls : 0.0;
+    cout << left << setw(10) << workload << setw(18) << r.policy << right
+         << setw(8) << fixed << setprecision(3) << waf
+         << setw(10) << r.gc.runs << setw(12) << r.gc.relocated_pages
+         << setw(12) << setprecision(1) << sel_avg_ns
+         << setw(12) << r.gc.select_ns / 1000 << setw(12) << r.gc.gc_ns / 1000 << "\n";
+    if (r.dedup.lookups)
+        cout << "          dedup hits=" << r.dedup.hits << " hit_ratio=" << setprecision(3)
+             << (double)r.dedup.hits / r.dedup.lookups << " ns/lookup=" << setprecision(1)
+             << (double)r.dedup.fp_ns / r.dedup.lookups << " fp_us=" << r.dedup.fp_ns / 1000 << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    string only_policy, only_workload;
+    int turns = 4, dedup_pct = -1, sectors = 1;
+    string series, snapshot;
+    double precondition = -1;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--policy" && i + 1 < argc)
+            only_policy = argv[++i];
+        else if (arg == "--workload" && i + 1 < argc)
+            only_workload = argv[++i];
+        else if (arg == "--turns" && i + 1 < argc)
+            turns = stoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--dedup" && i + 1 < argc)
+            dedup_pct = clamp(stoi(argv[++i]), 0, 100);
+        else if (arg == "--sectors" && i + 1 < argc)
+            sectors = stoi(argv[++i]);
+        else if (arg == "--series" && i + 1 < argc)
+            series = argv[++i];
+        else if (arg == "--snapshot" && i + 1 < argc)
+            snapshot = argv[++i];
+        else if (arg == "--precondition" && i + 1 < argc)
+            precondition = max(0.0, stod(argv[++i]));
+        else
+        {
+            cerr << "usage: gc_bench [--policy name] [--workload uniform|hotcold] [--turns N] [--seed S] [--dedup PCT] [--sectors N] [--series PREFIX] [--snapshot PREFIX] [--precondition SPREAD]\n";
+            return 1;
+        }
+    }
+
+    // 日志关闭：热路径上只剩一次级别判断
+    Logger::set_level(LogLevel::OFF);
+
+    BenchConfig cfg;
+    cfg.dedup_pct = dedup_pct;
+    cfg.sectors = sectors;
+    cfg.series = series;
+    cfg.snapshot = snapshot;
+    cfg.precondition = precondition;
+    int lbas = user_lbas(cfg);
+    cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+         << " sectors/page=" << cfg.sectors << " lbas=" << lbas << " turns=" << turns << " seed=" << seed << "\n";
+    cout << left << setw(10) << "workload" << setw(18) << "policy" << right
+         << setw(8) << "WAF" << setw(10) << "gc_runs" << setw(12) << "relocated"
+         << setw(12) << "sel_ns/run" << setw(12) << "sel_us" << setw(12) << "gc_us" << "\n";
+
+    for (string workload : {"uniform", "hotcold"})
+    {
+        if (!only_workload.empty() && workload != only_workload)
+            continue;
+        vector<int> trace = make_trace(workload, lbas, turns, seed);
+        vector<string> payload = make_payloads(cfg, trace.size(), seed);
+        auto run = [&](auto tag)
+        {
+            using Policy = typename decltype(tag)::type;
+            if (!only_policy.empty() && only_policy != Policy::name)
+                return;
+            print_result(workload, run_policy<Policy>(cfg, workload, trace, payload, lbas));
+        };
+        run(common_type<GreedyPolicy>{});
+        run(common_type<CostBenefitPolicy>{});
+        run(common_type<DChoicesPolicy<4>>{});
+        run(common_type<WindowedGreedyPolicy<8>>{});
+    }
+    return 0;
+}
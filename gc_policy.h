@@ -0,0 +1,122 @@
+#ifndef GC_POLICY_H
+#define GC_POLICY_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- GC victim 选择策略 ----------------
+   策略在编译期特化：FTL::set_gc_policy<Policy>() 把 Policy::select 内联进选择循环，
+   运行期只剩一次成员函数指针调用。默认策略由构建选项 FTL_GC_POLICY 指定。
+
+   select(View &v) 的 View 接口（见 FTL::GcView）：
+     closed()      已写满的原生条带，按写满先后排列（队首最老）
+     valid(sb)     条带有效页数，O(lanes)
+     capacity(sb)  条带总页数
+     age(sb)       条带写满后经过的条带写满次数（>= 1）
+     random()      可复现的随机数
+   返回 victim 条带号，无候选返回 -1
+*/
+
+// 贪心：全扫描，有效页最少者（并列取条带号最小者），O(N)
+struct GreedyPolicy
+{
+    static constexpr const char *name = "greedy";
+
+    template <class View>
+    static int select(View &v)
+    {
+        int victim = -1, best = INT_MAX;
+        for (int sb : v.closed())
+        {
+            int valid = v.valid(sb);
+            if (valid < best || (valid == best && sb < victim))
+            {
+                best = valid;
+                victim = sb;
+            }
+        }
+        return victim;
+    }
+};
+
+// cost-benefit：age * invalid / valid 最大者；冷条带即使有效页稍多也优先回收，O(N)
+struct CostBenefitPolicy
+{
+    static constexpr const char *name = "cost-benefit";
+
+    template <class View>
+    static int select(View &v)
+    {
+        int victim = -1;
+        double best = -1.0;
+        for (int sb : v.closed())
+        {
+            int valid = v.valid(sb);
+            if (valid == 0)
+                return sb; // 全无效，擦除即可
+            double score = (double)v.age(sb) * (v.capacity(sb) - valid) / valid;
+            if (score > best)
+            {
+                best = score;
+                victim = sb;
+            }
+        }
+        return victim;
+    }
+};
+
+// d-choices：随机抽 D 个候选取有效页最少者，O(D)
+template <int D = 4>
+struct DChoicesPolicy
+{
+    static_assert(D > 0, "d-choices needs at least one sample");
+    static constexpr const char *name = "d-choices";
+
+    template <class View>
+    static int select(View &v)
+    {
+        const auto &closed = v.closed();
+        if (closed.empty())
+            return -1;
+        int victim = -1, best = INT_MAX;
+        for (int i = 0; i < D; ++i)
+        {
+            int sb = closed[v.random() % closed.size()];
+            int valid = v.valid(sb);
+            if (valid < best)
+            {
+                best = valid;
+                victim = sb;
+            }
+        }
+        return victim;
+    }
+};
+
+// windowed greedy：只在最老的 W 个条带里贪心，O(W)
+template <int W = 8>
+struct WindowedGreedyPolicy
+{
+    static_assert(W > 0, "window must not be empty");
+    static constexpr const char *name = "windowed-greedy";
+
+    template <class View>
+    static int select(View &v)
+    {
+        const auto &closed = v.closed();
+        int n = min<int>(W, (int)closed.size());
+        int victim = -1, best = INT_MAX;
+        for (int i = 0; i < n; ++i)
+        {
+            int valid = v.valid(closed[i]);
+            if (valid < best)
+            {
+                best = valid;
+                victim = closed[i];
+            }
+        }
+        return victim;
+    }
+};
+
+#endif // GC_POLICY_H
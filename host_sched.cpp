@@ -0,0 +1,116 @@
+#include "host_sched.h"
+#include "logger.h"
+
+HostScheduler::HostScheduler(FTL &ftl) : ftl_(ftl)
+{
+    queues_.resize(ftl_.namespace_count());
+    lat_.resize(ftl_.namespace_count());
+}
+
+void HostScheduler::set_weight(int ns, double w)
+{
+    if (ns < 0 || ns >= (int)queues_.size() || w <= 0)
+    {
+        LOG_WARN("[SCHED] bad weight " << ns << ":" << w);
+        return;
+    }
+    queues_[ns].weight = w;
+}
+
+void HostScheduler::submit(const HostIo &io)
+{
+    if (io.ns < 0 || io.ns >= (int)queues_.size())
+    {
+        LOG_WARN("[SCHED] bad namespace " << io.ns);
+        return;
+    }
+    auto &qu = queues_[io.ns];
+    if (qu.q.empty())
+    {
+        // 重新积压：不继承空闲期的落后量
+        double min_vt = numeric_limits<double>::max();
+        for (auto &o : queues_)
+            if (!o.q.empty())
+                min_vt = min(min_vt, o.vt);
+        if (min_vt != numeric_limits<double>::max())
+            qu.vt = max(qu.vt, min_vt);
+    }
+    qu.q.push_back(io);
+}
+
+uint64_t HostScheduler::earliest_arrival() const
+{
+    uint64_t t = numeric_limits<uint64_t>::max();
+    for (auto &qu : queues_)
+        if (!qu.q.empty())
+            t = min(t, qu.q.front().arrival_ns);
+    return t;
+}
+
+int HostScheduler::pick(uint64_t now) const
+{
+    int best = -1;
+    for (int ns = 0; ns < (int)queues_.size(); ++ns)
+    {
+        auto &qu = queues_[ns];
+        if (qu.q.empty() || qu.q.front().arrival_ns > now)
+            continue;
+        if (best < 0)
+            best = ns;
+        else if (fair_ ? qu.vt < queues_[best].vt : qu.q.front().arrival_ns < queues_[best].q.front().arrival_ns)
+            best = ns;
+    }
+    return best;
+}
+
+bool HostScheduler::dispatch()
+{
+    uint64_t first = earliest_arrival();
+    if (first == numeric_limits<uint64_t>::max())
+        return false;
+    // 设备空闲到下一个请求到达
+    if (first > ftl_.now_ns())
+        ftl_.idle(first - ftl_.now_ns());
+    uint64_t start = ftl_.now_ns();
+    int ns = pick(start);
+    auto &qu = queues_[ns];
+    HostIo io = std::move(qu.q.front());
+    qu.q.pop_front();
+
+    if (io.is_write)
+        ftl_.write_ns(io.ns, io.lba, io.data);
+    else
+    {
+        string out;
+        ftl_.read_ns(io.ns, io.lba, out);
+    }
+    uint64_t done = ftl_.now_ns();
+    qu.vt += (double)(done - start) / qu.weight;
+    (io.is_write ? lat_[ns].write_ns : lat_[ns].read_ns).push_back(done - io.arrival_ns);
+    if (!io.is_write)
+        lat_[ns].read_svc_ns.push_back(done - start);
+    return true;
+}
+
+static uint64_t percentile(vector<uint64_t> v, double p)
+{
+    if (v.empty())
+        return 0;
+    size_t k = min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+void HostScheduler::dump_latency_stats()
+{
+    for (int ns = 0; ns < (int)lat_.size(); ++ns)
+    {
+        auto &l = lat_[ns];
+        cout << "[SCHED] ns" << ns << " " << (fair_ ? "wfq" : "fifo") << " w=" << queues_[ns].weight
+             << " reads=" << l.read_ns.size() << " p50=" << percentile(l.read_ns, 0.5) / 1000
+             << "us p99=" << percentile(l.read_ns, 0.99) / 1000 << "us svc_p99=" << percentile(l.read_svc_ns, 0.99) / 1000
+             << "us"
+             << " writes=" << l.write_ns.size() << " p50=" << percentile(l.write_ns, 0.5) / 1000
+             << "us p99=" << percentile(l.write_ns, 0.99) / 1000 << "us\n";
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef HOST_SCHED_H
+#define HOST_SCHED_H
+
+#include <bits/stdc++.h>
+#include "ftl.h"
+using namespace std;
+
+/* ---------------- HostScheduler：多 namespace 的主机 I/O 调度 ----------------
+   - FTL 是串行服务台：一次下发一个主机请求，服务时间 = 下发前后仿真时钟之差
+   - FIFO：按到达顺序服务（各队首中到达最早者）
+   - WFQ：每个 namespace 一个队列和虚拟时间，服务后 vt += 服务时间 / 权重，
+     每次选已到达、vt 最小的 namespace；重新有积压的 namespace 的 vt 提到积压者中的最小值，
+     避免空闲期攒下的"信用"一次性抢占设备
+   - 延迟 = 完成时刻 - 到达时刻（含排队），按 namespace 分读写统计；读另记服务时间（NAND 上的等待 + 读）
+*/
+struct HostIo
+{
+    int ns = 0;
+    bool is_write = false;
+    int lba = 0; // namespace 内的 LBA
+    string data;
+    uint64_t arrival_ns = 0;
+};
+
+class HostScheduler
+{
+public:
+    struct LatencyStats
+    {
+        vector<uint64_t> read_ns, write_ns;
+        vector<uint64_t> read_svc_ns; // 读的服务时间（下发到完成，不含主机排队）
+    };
+
+    explicit HostScheduler(FTL &ftl);
+
+    void set_fair(bool on) { fair_ = on; }
+    void set_weight(int ns, double w);
+    // 请求须按 arrival_ns 非递减提交
+    void submit(const HostIo &io);
+    // 服务一个请求；队列全空返回 false
+    bool dispatch();
+    void drain()
+    {
+        while (dispatch())
+            ;
+    }
+
+    const LatencyStats &latency(int ns) const { return lat_[ns]; }
+    void dump_latency_stats();
+
+private:
+    struct Queue
+    {
+        deque<HostIo> q;
+        double weight = 1.0;
+        double vt = 0.0;
+    };
+
+    FTL &ftl_;
+    bool fair_ = true;
+    vector<Queue> queues_;
+    vector<LatencyStats> lat_;
+
+    int pick(uint64_t now) const;
+    uint64_t earliest_arrival() const;
+};
+
+#endif // HOST_SCHED_H
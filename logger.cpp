@@ -0,0 +1,96 @@
+#include "logger.h"
+
+/* ---------------- Logger ---------------- */
+Logger &Logger::instance()
+{
+    static Logger lg(1 << 13);
+    return lg;
+}
+
+Logger::Logger(size_t capacity) : slots_(capacity), mask_(capacity - 1)
+{
+    for (size_t i = 0; i < capacity; ++i)
+        slots_[i].seq.store(i, memory_order_relaxed);
+    worker_ = thread([this] { run(); });
+}
+
+Logger::~Logger()
+{
+    running_.store(false, memory_order_release);
+    if (worker_.joinable())
+        worker_.join();
+}
+
+// 有界 MPSC 队列（按槽位序号）：seq == pos 可写，seq == pos + 1 可读
+void Logger::push(LogLevel lv, string msg)
+{
+    uint64_t pos = enq_.load(memory_order_relaxed);
+    Slot *slot;
+    while (true)
+    {
+        slot = &slots_[pos & mask_];
+        uint64_t seq = slot->seq.load(memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+        if (diff == 0)
+        {
+            if (enq_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // 队列满：等后台线程腾出槽位
+            this_thread::yield();
+            pos = enq_.load(memory_order_relaxed);
+        }
+        else
+            pos = enq_.load(memory_order_relaxed);
+    }
+    slot->level = lv;
+    slot->msg = move(msg);
+    slot->seq.store(pos + 1, memory_order_release);
+}
+
+bool Logger::pop(LogLevel &lv, string &msg)
+{
+    Slot &slot = slots_[deq_ & mask_];
+    if (slot.seq.load(memory_order_acquire) != deq_ + 1)
+        return false;
+    lv = slot.level;
+    msg = move(slot.msg);
+    slot.seq.store(deq_ + mask_ + 1, memory_order_release);
+    deq_++;
+    return true;
+}
+
+void Logger::run()
+{
+    LogLevel lv;
+    string msg;
+    while (true)
+    {
+        bool any = false;
+        while (pop(lv, msg))
+        {
+            (lv >= LogLevel::WARN ? cerr : cout) << msg << "\n";
+            written_.fetch_add(1, memory_order_release);
+            any = true;
+        }
+        if (any)
+        {
+            cout.flush();
+            cerr.flush();
+            continue;
+        }
+        // 退出前保证生产者已入队的记录都写完
+        if (!running_.load(memory_order_acquire) && written_.load(memory_order_relaxed) == enq_.load(memory_order_acquire))
+            break;
+        this_thread::sleep_for(chrono::microseconds(500));
+    }
+}
+
+void Logger::flush()
+{
+    uint64_t target = enq_.load(memory_order_acquire);
+    while (written_.load(memory_order_acquire) < target)
+        this_thread::yield();
+}
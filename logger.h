@@ -0,0 +1,93 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- Logger：异步分级日志 ----------------
+   - 编译期裁剪：低于 FTL_LOG_MIN_LEVEL 的 LOG_xxx 整条语句被 if constexpr 丢弃
+   - 运行期级别：一次 relaxed 原子读判断；set_level(LogLevel::OFF) 后热路径不做格式化
+   - 记录经有界无锁 MPSC 队列交给后台线程输出（INFO 及以下 -> stdout，WARN 及以上 -> stderr）；
+     队列满时生产者让出 CPU 重试，不丢日志
+   - 需要与同步输出（cout 报表）保持先后顺序时调用 flush()
+*/
+enum class LogLevel : int
+{
+    TRACE = 0,
+    DEBUG = 1,
+    INFO = 2,
+    WARN = 3,
+    ERROR = 4,
+    OFF = 5
+};
+
+#ifndef FTL_LOG_MIN_LEVEL
+#define FTL_LOG_MIN_LEVEL 0
+#endif
+
+// 运行期级别放在全局：判断不经过 Logger::instance() 的静态初始化检查
+inline atomic<int> g_log_level{(int)LogLevel::INFO};
+
+inline bool log_enabled(LogLevel lv)
+{
+    return (int)lv >= g_log_level.load(memory_order_relaxed);
+}
+
+class Logger
+{
+public:
+    static Logger &instance();
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    static void set_level(LogLevel lv) { g_log_level.store((int)lv, memory_order_relaxed); }
+    static LogLevel level() { return (LogLevel)g_log_level.load(memory_order_relaxed); }
+
+    void push(LogLevel lv, string msg);
+    // 等待此前入队的记录全部写出
+    void flush();
+
+private:
+    struct Slot
+    {
+        atomic<uint64_t> seq{0};
+        LogLevel level = LogLevel::INFO;
+        string msg;
+    };
+
+    explicit Logger(size_t capacity);
+
+    vector<Slot> slots_;
+    size_t mask_;
+    atomic<uint64_t> enq_{0};
+    uint64_t deq_ = 0; // 仅后台线程访问
+    atomic<uint64_t> written_{0};
+    atomic<bool> running_{true};
+    thread worker_;
+
+    bool pop(LogLevel &lv, string &msg);
+    void run();
+};
+
+#define FTL_LOG(lvl, expr)                                           \
+    do                                                               \
+    {                                                                \
+        if constexpr ((int)(lvl) >= FTL_LOG_MIN_LEVEL)               \
+        {                                                            \
+            if (__builtin_expect(log_enabled(lvl), 0))               \
+            {                                                        \
+                ostringstream log_os_;                               \
+                log_os_ << expr;                                     \
+                Logger::instance().push(lvl, log_os_.str());         \
+            }                                                        \
+        }                                                            \
+    } while (0)
+
+#define LOG_TRACE(expr) FTL_LOG(LogLevel::TRACE, expr)
+#define LOG_DEBUG(expr) FTL_LOG(LogLevel::DEBUG, expr)
+#define LOG_INFO(expr) FTL_LOG(LogLevel::INFO, expr)
+#define LOG_WARN(expr) FTL_LOG(LogLevel::WARN, expr)
+#define LOG_ERROR(expr) FTL_LOG(LogLevel::ERROR, expr)
+
+#endif // LOGGER_H
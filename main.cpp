@@ -2,6 +2,7 @@
 #include <iostream>
 void  page_stats(FTL& ftl,NandModel& model)
 {
+    Logger::instance().flush();
     std::cout << "================== ftl Page Stats =================\n";
     ftl.dump_page_stats();
 
@@ -12,12 +13,39 @@ void  page_stats(FTL& ftl,NandModel& model)
 }
 void runtime_stat(FTL &ftl,BlockManager &block_manager)
 {
+    Logger::instance().flush();
     ftl.dump_stats();
     block_manager.dump_alloc_state();
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    // --image <path>：file-backed NAND 镜像（不存在则新建，存在则重新打开）
+    // --slc <n>：每 plane 划出 n 个 SLC 缓存块（从用户容量中扣除）
+    // --sectors <n>：子页映射，每页 n 个扇区（LBA 为扇区）
+    // --log-level <0..5>：运行期日志级别（0=TRACE ... 5=OFF）
+    // --trace <json>：记录 NAND 操作 / GC / remap，结束时导出 Chrome trace（Perfetto 可打开）
+    string image_path, trace_path;
+    int page_bytes = 4096;
+    int slc_blocks_per_plane = 0;
+    int sectors_per_page = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--image" && i + 1 < argc)
+            image_path = argv[++i];
+        else if (arg == "--page-bytes" && i + 1 < argc)
+            page_bytes = stoi(argv[++i]);
+        else if (arg == "--slc" && i + 1 < argc)
+            slc_blocks_per_plane = stoi(argv[++i]);
+        else if (arg == "--sectors" && i + 1 < argc)
+            sectors_per_page = stoi(argv[++i]);
+        else if (arg == "--log-level" && i + 1 < argc)
+            Logger::set_level((LogLevel)clamp(stoi(argv[++i]), 0, 5));
+        else if (arg == "--trace" && i + 1 < argc)
+            trace_path = argv[++i];
+    }
+
     int dies_per_nand = 1;
     int planes_per_die = 1;
     int blocks_per_plane = 8;
@@ -26,23 +54,53 @@ int main()
     int reserved_spare_blocks_per_plane = 2;
 
     int total_pages = pages_per_block * blocks_per_plane * planes_per_die * dies_per_nand;
-    int total_lbas = total_pages - pages_per_block * (reserved_write_blocks_per_plane + reserved_spare_blocks_per_plane) * planes_per_die * dies_per_nand;
+    int total_lbas = total_pages - pages_per_block * (reserved_write_blocks_per_plane + reserved_spare_blocks_per_plane + slc_blocks_per_plane) * planes_per_die * dies_per_nand;
+    total_lbas *= sectors_per_page;
+
+    if (!trace_path.empty())
+        Tracer::instance().enable(true);
 
     cout << "total_lbas: " << total_lbas << endl;
     cout << "total_pages: " << total_pages << endl;
 
-    NandModel model(dies_per_nand, planes_per_die, blocks_per_plane, pages_per_block);
+    unique_ptr<NandModel> model_ptr;
+    if (image_path.empty())
+        model_ptr = make_unique<NandModel>(dies_per_nand, planes_per_die, blocks_per_plane, pages_per_block);
+    else
+        model_ptr = make_unique<NandModel>(dies_per_nand, planes_per_die, blocks_per_plane, pages_per_block, image_path, page_bytes);
+    if (!model_ptr->ok())
+        return 1;
+    NandModel &model = *model_ptr;
     NandRuntime runtime(dies_per_nand, planes_per_die, blocks_per_plane);
+    string runtime_path = image_path + ".rt";
+    if (model.reopened() && !runtime.load(runtime_path))
+        cerr << "runtime state not restored: " << runtime_path << "\n";
     NandDriver driver(model, runtime);
     driver.inject_factory_bad(0, 0, 1);
 
-    BlockManager block_manager(driver, runtime, reserved_write_blocks_per_plane, reserved_spare_blocks_per_plane);
-    FTL ftl(driver, runtime, block_manager, total_lbas);
+    BlockManager block_manager(driver, runtime, reserved_write_blocks_per_plane, reserved_spare_blocks_per_plane,
+                               slc_blocks_per_plane);
+    // 系统区（BBT / remap / spare 池快照 + 运行时坏块日志）：载入成功则 FTL 不再逐块探测
+    string sys_path = image_path + ".sys";
+    bool sys_loaded = model.reopened() && block_manager.load_system_area(sys_path);
+    if (model.reopened() && !sys_loaded)
+        cerr << "system area not restored, probing all blocks: " << sys_path << "\n";
+    FTL ftl(driver, runtime, block_manager, total_lbas, sectors_per_page);
+    if (model.is_file_backed() && !sys_loaded)
+        block_manager.save_system_area(sys_path);
+    // 映射优先从检查点恢复（只验证各条带首页 + 扫描保存时打开的条带），没有或已过期才全盘扫描 OOB
+    string ckpt_path = image_path + ".ftl";
+    if (model.reopened() && !ftl.load_checkpoint(ckpt_path))
+    {
+        cerr << "checkpoint not usable, rebuilding from OOB: " << ckpt_path << "\n";
+        ftl.rebuild_from_oob();
+    }
 
     // 连续写，期间注入一个运行时坏块（例如 PBN=3）
     for (int i = 0; i < 16 ; ++i){
         ftl.write(i % total_lbas, "D" + to_string(i));
     }
+    Logger::instance().flush();
     cout << "-- before GROWN BAD BLOCK --\n";
     runtime_stat(ftl, block_manager);
     page_stats(ftl, model);
@@ -50,6 +108,7 @@ int main()
     driver.inject_runtime_fail(0, 0, 3);//注入坏块 PBN=3
     for (int i = 16; i < total_lbas; ++i)
         ftl.write(i % total_lbas, "D" + to_string(i));
+    Logger::instance().flush();
     cout << "-- after GROWN BAD BLOCK & BAD BLOCK TABLE --\n";
     runtime_stat(ftl, block_manager);
 
@@ -60,6 +119,7 @@ int main()
     // 触发GC
     for (int i = total_lbas ; i < total_lbas*100; ++i)
         ftl.write(i % total_lbas, "D" + to_string(i));
+    Logger::instance().flush();
     cout << "-- after GC --\n";
     runtime_stat(ftl, block_manager);
 
@@ -79,6 +139,19 @@ int main()
     runtime_stat(ftl, block_manager);
 
     runtime.status();
+    if (slc_blocks_per_plane > 0)
+        ftl.dump_slc_stats();
+
+    if (!trace_path.empty())
+        Tracer::instance().export_chrome_json(trace_path);
 
+    if (model.is_file_backed())
+    {
+        // 检查点先写：它会把打包缓冲刷下去
+        ftl.save_checkpoint(ckpt_path);
+        model.sync();
+        runtime.save(runtime_path);
+        block_manager.save_system_area(sys_path);
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "mem_account.h"
+#include "nand_model.h"
+#include "nand_runtime.h"
+#include "block_allocator.h"
+#include "read_cache.h"
+#include "ftl.h"
+#include "logger.h"
+
+namespace mem_account_detail
+{
+    thread_local MemComponent tag = MemComponent::OTHER;
+
+    struct Counter
+    {
+        atomic<uint64_t> live{0}, peak{0}, allocs{0};
+    };
+    static Counter counters[kMemComponents];
+    static atomic<bool> installed{false};
+
+    void on_alloc(MemComponent c, size_t n)
+    {
+        Counter &k = counters[(size_t)c];
+        uint64_t now = k.live.fetch_add(n, memory_order_relaxed) + n;
+        k.allocs.fetch_add(1, memory_order_relaxed);
+        uint64_t peak = k.peak.load(memory_order_relaxed);
+        while (now > peak && !k.peak.compare_exchange_weak(peak, now, memory_order_relaxed))
+        {
+        }
+    }
+
+    void on_free(MemComponent c, size_t n) { counters[(size_t)c].live.fetch_sub(n, memory_order_relaxed); }
+
+    void mark_installed() { installed.store(true); }
+}
+
+const char *mem_component_name(MemComponent c)
+{
+    switch (c)
+    {
+    case MemComponent::OTHER:
+        return "other";
+    case MemComponent::NAND_PAGES:
+        return "nand_pages";
+    case MemComponent::NAND_RUNTIME:
+        return "nand_runtime";
+    case MemComponent::BM_REMAP:
+        return "bm_remap";
+    case MemComponent::BM_POOLS:
+        return "bm_pools";
+    case MemComponent::BM_SUPERBLOCKS:
+        return "bm_superblocks";
+    case MemComponent::FTL_MAP:
+        return "ftl_map";
+    case MemComponent::FTL_OTHER:
+        return "ftl_other";
+    case MemComponent::READ_CACHE:
+        return "read_cache";
+    default:
+        return "?";
+    }
+}
+
+bool mem_hooks_installed() { return mem_account_detail::installed.load(); }
+
+MemUsage mem_measured(MemComponent c)
+{
+    auto &k = mem_account_detail::counters[(size_t)c];
+    return {k.live.load(), k.peak.load(), k.allocs.load()};
+}
+
+uint64_t mem_measured_total()
+{
+    uint64_t sum = 0;
+    for (auto &k : mem_account_detail::counters)
+        sum += k.live.load();
+    return sum;
+}
+
+void mem_reset_peaks()
+{
+    for (auto &k : mem_account_detail::counters)
+        k.peak.store(k.live.load());
+}
+
+/* ---------------- 分析 / what-if ---------------- */
+long long MemGeometry::export_lbas() const
+{
+    if (lbas >= 0)
+        return lbas;
+    long long writable = (long long)max(0, blocks - reserved_write - reserved_spare) * pages * planes * dies * sectors_per_page;
+    return (long long)(writable * user_ratio);
+}
+
+void MemGeometry::scale_to_capacity(double gib, int page_kib)
+{
+    long long target_pages = (long long)(gib * 1024 * 1024 / max(1, page_kib));
+    long long per_block_row = (long long)dies * planes * pages;
+    blocks = (int)min<long long>(INT_MAX, max<long long>(reserved_write + reserved_spare + slc_blocks + 1,
+                                                        (target_pages + per_block_row - 1) / per_block_row));
+    lbas = -1;
+}
+
+uint64_t MemEstimate::total() const
+{
+    uint64_t sum = 0;
+    for (uint64_t b : bytes)
+        sum += b;
+    return sum;
+}
+
+uint64_t MemEstimate::peak_total() const
+{
+    uint64_t sum = total();
+    for (uint64_t b : transient)
+        sum += b;
+    return sum;
+}
+
+MemEstimate mem_estimate(const MemGeometry &g)
+{
+    MemEstimate e;
+    uint64_t D = g.dies, P = g.planes, B = g.blocks, G = g.pages;
+    uint64_t blocks = D * P * B, pages = blocks * G;
+    uint64_t sectors = pages * g.sectors_per_page;
+    uint64_t lbas = g.export_lbas();
+    uint64_t lanes = D * P;
+    auto &b = e.bytes;
+    auto &t = e.transient;
+    // 打包页（spp > 1）：每个槽位前有定长的二进制头
+    uint64_t page_payload = g.payload_bytes;
+    if (g.sectors_per_page > 1)
+        page_payload = g.sectors_per_page * (g.payload_bytes + FTL::kPackSlotHeaderBytes);
+
+    // 各对象本身按堆上分配计入所属组件
+    // NandModel：嵌套 vector 逐个 emplace_back（容量按倍增），Block 的页数组一次建好；
+    // 负载按每页都写过一次估（擦除只 clear，字符串的堆容量留着）
+    b[(size_t)MemComponent::NAND_PAGES] = sizeof(NandModel);
+    if (g.file_backed)
+        e.image_bytes = 4096 + pages * (sizeof(NandOobRecord) + page_payload);
+    else
+        b[(size_t)MemComponent::NAND_PAGES] += mem_grown_capacity(D) * sizeof(Die) +
+                                               D * mem_grown_capacity(P) * sizeof(Plane) +
+                                               D * P * mem_grown_capacity(B) * sizeof(Block) +
+                                               pages * (sizeof(Page) + mem_string_heap(page_payload));
+    // 打包页的槽位头定长，同一负载长度下各页等长；只有不满页（flush_pack）会短一些，不单独建模
+
+    // NandRuntime：每块一项；BBT 是 vector<bool>，按 64 位字分配
+    b[(size_t)MemComponent::NAND_RUNTIME] =
+        sizeof(NandRuntime) + blocks * (2 * sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint64_t)) + (blocks + 63) / 64 * 8;
+
+    // remap_ / reverse_remap_：[die][plane][vbn] 三层 vector，两份
+    b[(size_t)MemComponent::BM_REMAP] =
+        2 * (D * sizeof(vector<vector<int>>) + D * P * sizeof(vector<int>) + blocks * sizeof(int));
+    // resize 的填充原型：一个 plane 的 vector<int> 加一个 die 的 vector<vector<int>>
+    t[(size_t)MemComponent::BM_REMAP] = B * sizeof(int) + P * (sizeof(vector<int>) + B * sizeof(int));
+
+    // 各 plane 四个队列；默认构造的 deque 也要一个 map + 一个节点
+    uint64_t rw = max(0, g.reserved_write), rs = max(0, g.reserved_spare), slc = max(0, g.slc_blocks);
+    uint64_t normal = B > rw + rs + slc ? B - rw - rs - slc : 0;
+    b[(size_t)MemComponent::BM_POOLS] =
+        D * sizeof(vector<BlockManager::PlaneManager>) + D * P * sizeof(BlockManager::PlaneManager) +
+        D * P * (mem_deque_bytes<int>(normal) + mem_deque_bytes<int>(rw) + mem_deque_bytes<int>(rs) + mem_deque_bytes<int>(slc));
+    // resize 的填充原型：一个 die 的 PlaneManager 数组，四个空队列各带 map + 节点
+    t[(size_t)MemComponent::BM_POOLS] = P * (sizeof(BlockManager::PlaneManager) + 4 * mem_deque_bytes<int>(0));
+
+    // 超级块表：lane_ok 一次 assign，members 分配时逐个 push_back；fold 队列；各 lane 的在队位图与空闲条带的键。
+    // 空闲条带的有序索引与 closed 队列（总表 + 单流）此消彼长，取两者较大者（初始全部空闲 / 全部写满）
+    b[(size_t)MemComponent::BM_SUPERBLOCKS] =
+        sizeof(BlockManager) + B * (sizeof(BlockManager::Superblock) + lanes + mem_grown_capacity(lanes) * sizeof(pair<int, int>)) +
+        mem_deque_bytes<int>(0) + sizeof(deque<int>) + D * P * B + B * sizeof(BlockManager::FreeKey) +
+        max(2 * mem_deque_bytes<int>(B), mem_tree_bytes<BlockManager::FreeKey>(B));
+
+    uint64_t map = 3 * lbas * sizeof(int) + sectors * (sizeof(int) + sizeof(uint32_t) + sizeof(PageState)) +
+                   blocks * sizeof(int);
+    if (g.dedup)
+    {
+        map += sectors * sizeof(uint64_t) + mem_hash_bytes<pair<const uint64_t, int>>(lbas);
+        // 扩容时新旧桶数组同时在（桶数按 2 倍增长）
+        t[(size_t)MemComponent::FTL_MAP] = mem_grown_capacity(lbas) * sizeof(void *) / 2;
+    }
+    b[(size_t)MemComponent::FTL_MAP] = map;
+    // 其余只有 refresh 标记按超级块数增长；读缓存的三条空队列与 refresh 队列各占一个 deque 节点
+    b[(size_t)MemComponent::FTL_OTHER] = sizeof(FTL) + B + 3 * mem_deque_bytes<pair<int, uint64_t>>(0) + mem_deque_bytes<int>(0);
+    // GC / fold 搬移的工作集：整条带的源页地址（push_back 增长，扩容时新旧两份）+ 一批目标页的扇区与负载
+    uint64_t src = mem_grown_capacity(G * lanes) * sizeof(NandAddr);
+    uint64_t batch = lanes * g.sectors_per_page;
+    t[(size_t)MemComponent::FTL_OTHER] = src + src / 2 +
+                                         mem_grown_capacity(batch) * (sizeof(pair<int, string>) + mem_string_heap(g.payload_bytes)) +
+                                         lanes * (sizeof(string) + mem_string_heap(page_payload) + 2 * sizeof(int) + 1);
+
+    if (g.read_cache_pages > 0)
+        b[(size_t)MemComponent::READ_CACHE] = ReadCache::estimate_bytes(g.read_cache_pages, g.payload_bytes);
+    return e;
+}
+
+uint64_t mem_available_bytes()
+{
+    ifstream in("/proc/meminfo");
+    string key, unit;
+    uint64_t kib = 0;
+    while (in >> key >> kib)
+    {
+        getline(in, unit);
+        if (key == "MemAvailable:")
+            return kib * 1024;
+    }
+    return 0;
+}
+
+bool mem_fits(const MemEstimate &e, uint64_t budget, double headroom)
+{
+    if (!budget)
+        budget = mem_available_bytes();
+    if (!budget)
+    {
+        LOG_WARN("mem_fits: MemAvailable unknown, skip check");
+        return true;
+    }
+    return e.peak_total() * kMemModelMargin <= budget * headroom;
+}
+
+static string human_bytes(double v)
+{
+    static const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int u = 0;
+    while (v >= 1024 && u < 4)
+    {
+        v /= 1024;
+        u++;
+    }
+    ostringstream os;
+    os << fixed << setprecision(u ? 2 : 0) << v << units[u];
+    return os.str();
+}
+
+void mem_dump_report(const MemGeometry &g, const MemEstimate &e, bool measured)
+{
+    measured = measured && mem_hooks_installed();
+    uint64_t pages = max<long long>(1, g.total_pages());
+    cout << "[MEM] geometry " << g.dies << "x" << g.planes << "x" << g.blocks << "x" << g.pages
+         << " pages=" << g.total_pages() << " lbas=" << g.export_lbas() << " spp=" << g.sectors_per_page
+         << " payload=" << g.payload_bytes << (g.file_backed ? " file-backed" : "") << (g.dedup ? " dedup" : "")
+         << " read_cache=" << g.read_cache_pages << "\n";
+    cout << left << setw(16) << "[MEM] component" << right << setw(14) << "estimate" << setw(14) << "est_peak"
+         << setw(10) << "B/page";
+    if (measured)
+        cout << setw(14) << "live" << setw(14) << "peak" << setw(12) << "allocs" << setw(9) << "est/peak";
+    cout << "\n";
+    uint64_t peak_sum = 0;
+    for (size_t i = 0; i < kMemComponents; ++i)
+    {
+        MemComponent c = (MemComponent)i;
+        MemUsage u = mem_measured(c);
+        peak_sum += u.peak;
+        if (!e.bytes[i] && (!measured || !u.peak))
+            continue;
+        cout << "[MEM] " << left << setw(16) << mem_component_name(c) << right << setw(14) << human_bytes(e.bytes[i])
+             << setw(14) << human_bytes(e.peak(c)) << setw(10) << fixed << setprecision(2) << (double)e.bytes[i] / pages;
+        if (measured)
+        {
+            cout << setw(14) << human_bytes(u.live) << setw(14) << human_bytes(u.peak) << setw(12) << u.allocs;
+            if (u.peak)
+                cout << setw(9) << (double)e.peak(c) / u.peak;
+        }
+        cout << defaultfloat << "\n";
+    }
+    cout << "[MEM] " << left << setw(16) << "total" << right << setw(14) << human_bytes(e.total()) << setw(14)
+         << human_bytes(e.peak_total()) << setw(10) << fixed << setprecision(2) << (double)e.total() / pages << defaultfloat;
+    if (measured)
+        cout << setw(14) << human_bytes(mem_measured_total()) << setw(14) << human_bytes(peak_sum) << setw(12) << ""
+             << setw(9) << fixed << setprecision(2) << (double)e.peak_total() / max<uint64_t>(1, peak_sum) << defaultfloat;
+    cout << "\n";
+    cout << "[MEM] fit check: est_peak x " << setprecision(3) << kMemModelMargin << " = " << human_bytes(e.peak_total() * kMemModelMargin) << "\n";
+    if (e.image_bytes)
+        cout << "[MEM] nand image (mmap, not heap) " << human_bytes(e.image_bytes) << "\n";
+}
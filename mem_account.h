@@ -0,0 +1,138 @@
+#ifndef MEM_ACCOUNT_H
+#define MEM_ACCOUNT_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- 内存账本：仿真进程的 DRAM 按数据结构分项 ----------------
+   - 分析值（mem_estimate）：只凭几何推算，不构造任何对象；元素大小取真实类型的 sizeof，
+     vector 按 libstdc++ 的增长方式取容量，deque 按 512 字节节点 + 指针 map 计。可直接对目标容量做 what-if，
+     再用 mem_fits 对照可用内存，在分配之前拦下放不下的配置
+   - 实测值（mem_measured）：mem_hook.cpp 替换全局 operator new/delete，每次分配记到当前线程的组件标签下，
+     释放记回分配时的标签。只有把 mem_hook.cpp 编进去的程序才有实测值（mem_hooks_installed()），
+     ftl_core 本身不替换分配器
+   - 标签用 MemScope 标注：各结构的构造处由调用方标注，构造函数 / 运行时热点（页负载写入、池进出、读缓存插入）
+     内部再细分；没标的分配记到 OTHER
+   - 两边都只计请求的字节数，不含 malloc 的块头与对齐
+   - 峰值高于常驻量：分析值另给已知的瞬时分配（transient：构造时的填充原型、GC 搬移的工作集、哈希表扩容时的新旧桶数组），
+     放不放得下按常驻 + 瞬时再乘 kMemModelMargin 判断
+*/
+enum class MemComponent : uint8_t
+{
+    OTHER,
+    NAND_PAGES,     // NandModel：Die/Plane/Block/Page 嵌套 vector + 页负载字符串（内存模式）
+    NAND_RUNTIME,   // NandRuntime：每块擦写 / 读计数、BBT、SLC 标记、program 时刻
+    BM_REMAP,       // BlockManager::remap_ / reverse_remap_
+    BM_POOLS,       // BlockManager：各 plane 的 free / reserved_write / spare / SLC 队列
+    BM_SUPERBLOCKS, // 超级块表（lane_ok / members）+ closed / fold 队列
+    FTL_MAP,        // FTL：L2P / P2L / 同页链表 / page_ref / pstate / blk_valid / 去重指纹
+    FTL_OTHER,      // FTL 其余：打包缓冲、refresh 标记、统计样本……
+    READ_CACHE,
+    COUNT
+};
+constexpr size_t kMemComponents = (size_t)MemComponent::COUNT;
+
+const char *mem_component_name(MemComponent c);
+
+namespace mem_account_detail
+{
+    extern thread_local MemComponent tag;
+    void on_alloc(MemComponent c, size_t n);
+    void on_free(MemComponent c, size_t n);
+    void mark_installed();
+}
+
+// 当前线程的分配标签；离开作用域恢复外层标签
+class MemScope
+{
+public:
+    explicit MemScope(MemComponent c) : prev_(mem_account_detail::tag) { mem_account_detail::tag = c; }
+    ~MemScope() { mem_account_detail::tag = prev_; }
+    MemScope(const MemScope &) = delete;
+    MemScope &operator=(const MemScope &) = delete;
+
+private:
+    MemComponent prev_;
+};
+
+/* ---------------- 实测 ---------------- */
+struct MemUsage
+{
+    uint64_t live = 0;   // 当前在用字节
+    uint64_t peak = 0;   // 自上次 mem_reset_peaks 以来的峰值
+    uint64_t allocs = 0; // 累计分配次数
+};
+
+bool mem_hooks_installed();
+MemUsage mem_measured(MemComponent c);
+uint64_t mem_measured_total();
+void mem_reset_peaks();
+
+/* ---------------- 分析 / what-if ---------------- */
+// libstdc++ 的堆占用模型：push_back 逐个增长的 vector 容量、string 负载、deque 节点 + map
+inline size_t mem_grown_capacity(size_t n)
+{
+    size_t c = n ? 1 : 0;
+    while (c < n)
+        c <<= 1;
+    return c;
+}
+inline size_t mem_string_heap(size_t len) { return len <= 15 ? 0 : max<size_t>(len, 30) + 1; }
+template <class T>
+size_t mem_deque_bytes(size_t n)
+{
+    size_t per = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    size_t nodes = n / per + 1;
+    return nodes * per * sizeof(T) + max<size_t>(8, nodes + 2) * sizeof(T *);
+}
+// 哈希表：每个节点一个后继指针 + 元素，桶数组约与元素数相当
+template <class V>
+size_t mem_hash_bytes(size_t n) { return n * (sizeof(V) + sizeof(void *)) + n * sizeof(void *); }
+// 红黑树（set / map）：每个节点颜色 + 三个指针 + 元素
+template <class V>
+size_t mem_tree_bytes(size_t n) { return n * (sizeof(V) + 4 * sizeof(void *)); }
+
+struct MemGeometry
+{
+    int dies = 4, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2, slc_blocks = 0;
+    int sectors_per_page = 1;
+    double user_ratio = 0.85; // lbas < 0 时：导出 LBA = 可写扇区 × user_ratio（与各 bench 相同）
+    long long lbas = -1;
+    int payload_bytes = 16;   // 每页负载字符串的平均长度（内存模式；<= 15 时在 SSO 里不上堆）
+    bool file_backed = false; // 负载在 mmap 镜像里，不占堆
+    bool dedup = false;       // 去重：page_fp_ + 指纹索引
+    long long read_cache_pages = 0;
+
+    long long total_pages() const { return (long long)dies * planes * blocks * pages; }
+    long long export_lbas() const;
+    // 保持 dies / planes / pages 与保留块不变，按目标原始容量（GiB，每页 page_kib KiB）求每 plane 块数
+    void scale_to_capacity(double gib, int page_kib);
+};
+
+struct MemEstimate
+{
+    array<uint64_t, kMemComponents> bytes{};     // 常驻
+    array<uint64_t, kMemComponents> transient{}; // 峰值时在常驻之外多出的瞬时分配
+    uint64_t image_bytes = 0; // file-backed：镜像文件大小（mmap，走页缓存，不计入堆）
+
+    uint64_t operator[](MemComponent c) const { return bytes[(size_t)c]; }
+    uint64_t peak(MemComponent c) const { return bytes[(size_t)c] + transient[(size_t)c]; }
+    uint64_t total() const;
+    // 各组件峰值之和（各组件的峰值不一定同时出现，偏保守）
+    uint64_t peak_total() const;
+};
+
+// 分析模型之外的余量：没建模的瞬时分配（条带成员 / 队列扩容、请求路径上的临时对象），
+// 以及打包页负载容量按平均值估带来的偏差。mem_report 各配置下峰值估算 / 实测峰值合计最低约 0.96，再留一些
+constexpr double kMemModelMargin = 1.15;
+
+MemEstimate mem_estimate(const MemGeometry &g);
+// /proc/meminfo 的 MemAvailable；读不到返回 0
+uint64_t mem_available_bytes();
+// 峰值估算 × kMemModelMargin 是否放得下 budget × headroom（budget 为 0 时取 mem_available_bytes）
+bool mem_fits(const MemEstimate &e, uint64_t budget = 0, double headroom = 0.9);
+// 分项表：常驻 / 峰值分析值、每页字节数，有钩子时附实测在用 / 峰值
+void mem_dump_report(const MemGeometry &g, const MemEstimate &e, bool measured);
+
+#endif // MEM_ACCOUNT_H
@@ -0,0 +1,45 @@
+#include "mem_account.h"
+
+/* ---------------- 分配器钩子：替换全局 operator new/delete ----------------
+   每块前面加一个 16 字节的头，记请求大小与分配时的组件标签（返回地址仍按 16 字节对齐），释放时记回原标签。
+   不进 ftl_core：只编进需要实测值的程序（add_executable(x x.cpp mem_hook.cpp)），其余程序照常走默认分配器。
+   对齐版本（align_val_t）与 nothrow / sized 版本走 libstdc++ 默认实现，后两者最终转到这里
+*/
+namespace
+{
+    struct alignas(16) AllocHeader
+    {
+        size_t size;
+        MemComponent tag;
+    };
+    static_assert(sizeof(AllocHeader) == 16, "header must keep 16-byte alignment");
+
+    void *hooked_alloc(size_t n)
+    {
+        auto *h = static_cast<AllocHeader *>(malloc(n + sizeof(AllocHeader)));
+        if (!h)
+            throw bad_alloc();
+        h->size = n;
+        h->tag = mem_account_detail::tag;
+        mem_account_detail::on_alloc(h->tag, n);
+        return h + 1;
+    }
+
+    void hooked_free(void *p) noexcept
+    {
+        if (!p)
+            return;
+        auto *h = static_cast<AllocHeader *>(p) - 1;
+        mem_account_detail::on_free(h->tag, h->size);
+        free(h);
+    }
+
+    const bool kInstalled = (mem_account_detail::mark_installed(), true);
+}
+
+void *operator new(size_t n) { return hooked_alloc(n); }
+void *operator new[](size_t n) { return hooked_alloc(n); }
+void operator delete(void *p) noexcept { hooked_free(p); }
+void operator delete[](void *p) noexcept { hooked_free(p); }
+void operator delete(void *p, size_t) noexcept { hooked_free(p); }
+void operator delete[](void *p, size_t) noexcept { hooked_free(p); }
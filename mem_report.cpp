@@ -0,0 +1,178 @@
+#include "ftl.h"
+#include "mem_account.h"
+#include "logger.h"
+
+/* ---------------- DRAM 占用报告 ----------------
+   先按几何给出各数据结构的分析值（每页字节数便于按容量外推），对照可用内存判断放不放得下；放不下直接退出（返回 3），
+   不做任何分配。放得下且没有 --what-if 时按同一几何建一套 NAND/FTL（与 mem_hook.cpp 链接，分配按组件记账），
+   顺序写满全部 LBA、再随机覆盖写 overwrite 倍 LBA 数并随机读，输出分析值与实测在用 / 峰值的对照。
+   用法：mem_report [--dies N] [--planes N] [--blocks N] [--pages N] [--spp N] [--user-ratio R] [--payload BYTES]
+                    [--read-cache PAGES] [--dedup] [--file-backed] [--capacity-gib G --page-kib K]
+                    [--budget-gib G] [--overwrite X] [--what-if] [--seed S]
+   --capacity-gib：what-if 目标原始容量，保持 dies/planes/pages 不变求每 plane 块数（--page-kib 默认 16）
+   --budget-gib：可用内存上限（默认取 /proc/meminfo 的 MemAvailable）；--file-backed 只估算（负载在镜像里）
+*/
+
+struct MemConfig
+{
+    MemGeometry geo;
+    double capacity_gib = 0;
+    int page_kib = 16;
+    double budget_gib = 0;
+    double overwrite = 1.0;
+    bool what_if = false;
+    uint32_t seed = 1;
+};
+
+// 与估算相同的负载长度：LBA 与代数打头，补齐到 payload_bytes
+static string make_payload(int lba, int gen, int bytes)
+{
+    string s = "L" + to_string(lba) + "." + to_string(gen);
+    if ((int)s.size() < bytes)
+        s.resize(bytes, '#');
+    return s;
+}
+
+static void print_measured(const char *when)
+{
+    cout << "[MEM] live after " << when << ":";
+    for (size_t i = 0; i < kMemComponents; ++i)
+    {
+        uint64_t live = mem_measured((MemComponent)i).live;
+        if (live)
+            cout << " " << mem_component_name((MemComponent)i) << "=" << live;
+    }
+    cout << " total=" << mem_measured_total() << "\n";
+}
+
+static void run_measured(const MemConfig &c, const MemEstimate &est)
+{
+    const MemGeometry &g = c.geo;
+    unique_ptr<NandModel> model;
+    unique_ptr<NandRuntime> runtime;
+    unique_ptr<NandDriver> driver;
+    unique_ptr<BlockManager> bm;
+    unique_ptr<FTL> ftl;
+    // 构造处标注组件（成员初始化在构造函数体之前），构造函数内部再细分
+    {
+        MemScope scope(MemComponent::NAND_PAGES);
+        model = make_unique<NandModel>(g.dies, g.planes, g.blocks, g.pages);
+    }
+    {
+        MemScope scope(MemComponent::NAND_RUNTIME);
+        runtime = make_unique<NandRuntime>(g.dies, g.planes, g.blocks);
+    }
+    driver = make_unique<NandDriver>(*model, *runtime);
+    {
+        MemScope scope(MemComponent::BM_SUPERBLOCKS);
+        bm = make_unique<BlockManager>(*driver, *runtime, g.reserved_write, g.reserved_spare, g.slc_blocks);
+    }
+    int lbas = (int)g.export_lbas();
+    {
+        MemScope scope(MemComponent::FTL_OTHER);
+        ftl = make_unique<FTL>(*driver, *runtime, *bm, lbas, g.sectors_per_page);
+        if (g.dedup)
+            ftl->set_dedup(true);
+        if (g.read_cache_pages > 0)
+            ftl->set_read_cache(g.read_cache_pages);
+    }
+    print_measured("build");
+
+    mt19937 rng(c.seed);
+    vector<int> gen(lbas, 0);
+    // 运行中没标到的分配（请求路径上的临时对象等）记到 FTL_OTHER
+    MemScope scope(MemComponent::FTL_OTHER);
+    for (int l = 0; l < lbas; ++l)
+        ftl->write(l, make_payload(l, gen[l], g.payload_bytes));
+    long long n = (long long)(lbas * c.overwrite);
+    for (long long i = 0; i < n; ++i)
+    {
+        int l = rng() % lbas;
+        ftl->write(l, make_payload(l, ++gen[l], g.payload_bytes));
+    }
+    int bad = 0;
+    string out;
+    for (int i = 0; i < lbas; ++i)
+    {
+        int l = rng() % lbas;
+        if (!ftl->read_lba(l, out) || out != make_payload(l, gen[l], g.payload_bytes))
+            bad++;
+    }
+    print_measured("fill");
+    if (bad)
+        cout << "[MEM] read-back mismatches: " << bad << "\n";
+    mem_dump_report(g, est, true);
+}
+
+int main(int argc, char **argv)
+{
+    MemConfig cfg;
+    MemGeometry &g = cfg.geo;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--dies" && i + 1 < argc)
+            g.dies = max(1, stoi(argv[++i]));
+        else if (arg == "--planes" && i + 1 < argc)
+            g.planes = max(1, stoi(argv[++i]));
+        else if (arg == "--blocks" && i + 1 < argc)
+            g.blocks = max(8, stoi(argv[++i]));
+        else if (arg == "--pages" && i + 1 < argc)
+            g.pages = max(2, stoi(argv[++i]));
+        else if (arg == "--spp" && i + 1 < argc)
+            g.sectors_per_page = max(1, stoi(argv[++i]));
+        else if (arg == "--user-ratio" && i + 1 < argc)
+            g.user_ratio = min(1.0, max(0.1, stod(argv[++i])));
+        else if (arg == "--payload" && i + 1 < argc)
+            g.payload_bytes = max(0, stoi(argv[++i]));
+        else if (arg == "--read-cache" && i + 1 < argc)
+            g.read_cache_pages = max(0LL, stoll(argv[++i]));
+        else if (arg == "--dedup")
+            g.dedup = true;
+        else if (arg == "--file-backed")
+            g.file_backed = true;
+        else if (arg == "--capacity-gib" && i + 1 < argc)
+            cfg.capacity_gib = max(0.0, stod(argv[++i]));
+        else if (arg == "--page-kib" && i + 1 < argc)
+            cfg.page_kib = max(1, stoi(argv[++i]));
+        else if (arg == "--budget-gib" && i + 1 < argc)
+            cfg.budget_gib = max(0.0, stod(argv[++i]));
+        else if (arg == "--overwrite" && i + 1 < argc)
+            cfg.overwrite = max(0.0, stod(argv[++i]));
+        else if (arg == "--what-if")
+            cfg.what_if = true;
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else
+        {
+            cerr << "usage: mem_report [--dies N] [--planes N] [--blocks N] [--pages N] [--spp N] [--user-ratio R]"
+                    " [--payload BYTES] [--read-cache PAGES] [--dedup] [--file-backed] [--capacity-gib G --page-kib K]"
+                    " [--budget-gib G] [--overwrite X] [--what-if] [--seed S]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    if (cfg.capacity_gib > 0)
+        g.scale_to_capacity(cfg.capacity_gib, cfg.page_kib);
+    if (g.sectors_per_page & (g.sectors_per_page - 1))
+    {
+        cerr << "--spp must be a power of two\n";
+        return 1;
+    }
+
+    MemEstimate est = mem_estimate(g);
+    uint64_t budget = cfg.budget_gib > 0 ? (uint64_t)(cfg.budget_gib * (1ULL << 30)) : mem_available_bytes();
+    bool fits = mem_fits(est, budget);
+    // int 索引：超过 INT_MAX 的页 / LBA 数本仿真器装不下，与内存无关
+    bool indexable = g.total_pages() * g.sectors_per_page <= INT_MAX && g.export_lbas() <= INT_MAX;
+    bool measure = !cfg.what_if && !g.file_backed && fits && indexable;
+    if (measure)
+        run_measured(cfg, est);
+    else
+        mem_dump_report(g, est, false);
+    cout << "[MEM] budget=" << budget << "B estimate=" << est.total() << "B est_peak=" << est.peak_total() << "B fits=" << (fits ? "yes" : "no");
+    if (!indexable)
+        cout << " (geometry exceeds int page index)";
+    cout << "\n";
+    return fits && indexable ? 0 : 3;
+}
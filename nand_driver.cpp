@@ -3,7 +3,9 @@
 
 /* ---------------- NandDriver ---------------- */
 NandDriver::NandDriver(NandModel &model, NandRuntime &runtime)
-    : model_(model), runtime_(runtime) {}
+    : model_(model), runtime_(runtime), die_busy_until_(model.dies_per_nand, 0),
+      die_start_ns_(model.dies_per_nand, 0), die_end_ns_(model.dies_per_nand, 0),
+      die_q_(model.dies_per_nand) {}
 
 pair<NandStatus, string> NandDriver::submit(NandOp &op)
 {
@@ -14,29 +16,190 @@ pair<NandStatus, string> NandDriver::submit(NandOp &op)
         stats_.failed_ops++;
         return v;
     }
+    account_timing(op);
+    pair<NandStatus, string> r;
     switch (op.cmd) {
         case NandCmd::READ_PAGE:
-            stats_.read_ops++;
-            return execute_read(op);
+            r = execute_read(op);
+            break;
             
         case NandCmd::PROGRAM_PAGE:
-            stats_.program_ops++;
-            return execute_program(op);
+            r = execute_program(op);
+            break;
             
         case NandCmd::ERASE_BLOCK:
-            stats_.erase_ops++;
-            return execute_erase(op);
+            r = execute_erase(op);
+            break;
             
         default:
             stats_.failed_ops++;
             return {NandStatus::FAILED, "unknown command"};
     }
+    if (trace_enabled())
+        trace_op(op, r.first);
+    return r;
+}
+
+// 每个目标一条记录：die 上的执行区间 [start, busy_until) 与 issue 之后的排队时间
+void NandDriver::trace_op(const NandOp &op, NandStatus st)
+{
+    for (const auto &a : op.targets) {
+        TraceRecord t;
+        t.kind = TraceKind::NAND_OP;
+        t.cmd = (uint8_t)op.cmd;
+        t.status = (uint8_t)st;
+        t.ts_ns = die_start_ns_[a.die];
+        t.dur_ns = die_end_ns_[a.die] - die_start_ns_[a.die];
+        t.wait_ns = die_start_ns_[a.die] - op.issue_ns;
+        t.die = a.die;
+        t.plane = a.plane;
+        t.block = a.block;
+        t.page = a.page;
+        Tracer::instance().record(t);
+    }
+}
+
+// 每个 die 串行执行；同一 op 内同 die 的多 plane 目标并行，取最长者
+void NandDriver::account_timing(NandOp &op)
+{
+    vector<pair<int, uint64_t>> per_die;
+    for (const auto &a : op.targets) {
+        uint64_t lat = op_latency_ns(op.cmd, a);
+        auto it = find_if(per_die.begin(), per_die.end(), [&](const pair<int, uint64_t> &x) { return x.first == a.die; });
+        if (it == per_die.end()) per_die.push_back({a.die, lat});
+        else it->second = max(it->second, lat);
+    }
+    op.complete_ns = op.issue_ns;
+    bool timeline = cell_.read_priority || cell_.max_suspends;
+    for (const auto &[d, lat] : per_die) {
+        uint64_t end;
+        if (timeline) {
+            end = schedule_on_die(d, op.cmd, op.issue_ns, lat);
+        } else {
+            uint64_t start = max(op.issue_ns, die_busy_until_[d]);
+            die_start_ns_[d] = start;
+            end = die_end_ns_[d] = die_busy_until_[d] = start + lat;
+            if (record_prog_lat_ && op.cmd == NandCmd::PROGRAM_PAGE)
+                prog_lat_ns_.push_back(end - op.issue_ns);
+        }
+        op.complete_ns = max(op.complete_ns, end);
+    }
+}
+
+// 读优先 / suspend：在该 die 的时间线上安排一个操作，返回它的完成时刻
+// - 读到达时正在执行 program/erase 且未超过打断次数：暂停它先做读，它顺延 (暂停 + 读 + 恢复)；
+//   暂停期间再来的读接在前一个读之后
+// - 否则读优先时插到正在执行的操作之后、排队的操作之前；不优先时排到队尾
+// 插入后后面的操作只按重叠部分往后推。已返回给调用方的完成时刻不再更新，program/erase 被推迟的时长
+// 记到 NandStats（delayed_long_ops / long_op_delay_ns），program 的最终时延在退出时间线时记样本
+uint64_t NandDriver::schedule_on_die(int d, NandCmd cmd, uint64_t issue, uint64_t lat)
+{
+    auto &q = die_q_[d];
+    while (!q.empty() && q.front().end <= issue) {
+        if (record_prog_lat_ && q.front().program)
+            prog_lat_ns_.push_back(q.front().end - q.front().issue);
+        q.pop_front();
+    }
+    auto push_back = [&]() {
+        uint64_t start = max(issue, die_busy_until_[d]);
+        q.push_back({start, start + lat, cmd != NandCmd::READ_PAGE, 0, 0, issue, cmd == NandCmd::PROGRAM_PAGE});
+        die_start_ns_[d] = start;
+        die_end_ns_[d] = die_busy_until_[d] = start + lat;
+        return start + lat;
+    };
+    if (cmd != NandCmd::READ_PAGE || q.empty())
+        return push_back();
+
+    // 从第 k 个操作起，按重叠往后推到 cursor 之后
+    auto shift_from = [&](size_t k, uint64_t cursor) {
+        for (; k < q.size() && q[k].start < cursor; ++k) {
+            uint64_t delta = cursor - q[k].start;
+            q[k].start += delta;
+            q[k].end += delta;
+            if (q[k].long_op)
+                delay_long_op(q[k], delta);
+            cursor = q[k].end;
+        }
+        die_busy_until_[d] = q.back().end;
+    };
+    // 读优先：从第 k 个起跳过已插队的读（读之间先来先服务），插到第一个排队的 program/erase 之前
+    auto insert_read = [&](size_t k, uint64_t cursor) {
+        for (; k < q.size() && !q[k].long_op; ++k)
+            cursor = max(cursor, q[k].end);
+        q.insert(q.begin() + k, DieSlot{cursor, cursor + lat, false, 0, 0});
+        shift_from(k + 1, cursor + lat);
+        return cursor;
+    };
+    uint64_t start;
+    auto &run = q.front();
+    if (run.start > issue) {
+        // die 此刻空闲，下一个操作还没开始
+        if (!cell_.read_priority)
+            return push_back();
+        start = insert_read(0, issue);
+    } else if (run.long_op && cell_.max_suspends && (cell_.read_priority || q.size() == 1) &&
+               (issue < run.read_end || run.suspends < cell_.max_suspends)) {
+        if (issue < run.read_end) {
+            start = run.read_end;
+            run.end += lat;
+            delay_long_op(run, lat);
+        } else {
+            start = issue + cell_.t_suspend_ns;
+            run.end += cell_.t_suspend_ns + lat + cell_.t_resume_ns;
+            delay_long_op(run, cell_.t_suspend_ns + lat + cell_.t_resume_ns);
+            run.suspends++;
+            stats_.suspends++;
+        }
+        run.read_end = start + lat;
+        shift_from(1, run.end);
+    } else if (cell_.read_priority) {
+        start = insert_read(1, run.end);
+    } else {
+        return push_back();
+    }
+    die_start_ns_[d] = start;
+    die_end_ns_[d] = start + lat;
+    return start + lat;
+}
+
+void NandDriver::delay_long_op(DieSlot &s, uint64_t delta)
+{
+    if (!s.delayed) {
+        s.delayed = true;
+        stats_.delayed_long_ops++;
+    }
+    stats_.long_op_delay_ns += delta;
+}
+
+vector<uint64_t> NandDriver::program_latencies_ns() const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    vector<uint64_t> v = prog_lat_ns_;
+    if (record_prog_lat_)
+        for (const auto &q : die_q_)
+            for (const auto &s : q)
+                if (s.program)
+                    v.push_back(s.end - s.issue);
+    return v;
+}
+
+uint64_t NandDriver::op_latency_ns(NandCmd cmd, const NandAddr &a) const
+{
+    bool slc = is_block_slc(a.die, a.plane, a.block);
+    switch (cmd) {
+        case NandCmd::READ_PAGE:    return slc ? cell_.t_read_slc_ns : cell_.t_read_ns;
+        case NandCmd::PROGRAM_PAGE: return slc ? cell_.t_prog_slc_ns : cell_.t_prog_ns;
+        case NandCmd::ERASE_BLOCK:  return cell_.t_erase_ns;
+    }
+    return 0;
 }
 
 pair<NandStatus, string> NandDriver::execute_read(NandOp &op)
 {
     op.data.clear(); op.oob_lba.clear(); op.oob_seq.clear();
+    op.done = 0;
     for (const auto &a : op.targets) {
+        stats_.read_ops++;
         //检查是否是注入的坏块
         if (runtime_.should_fail(a.die, a.plane, a.block)) {
             stats_.failed_ops++;
@@ -46,10 +209,21 @@ pair<NandStatus, string> NandDriver::execute_read(NandOp &op)
             stats_.bad_blocks_detected++;
             return {NandStatus::BAD_BLOCK, "bad block"};
         }
-        const Page pg = model_.dies[a.die].planes[a.plane].blocks[a.block].pages[a.page];
+        // read disturb / retention：超出单元能力则 ECC 纠不回来
+        int bi = runtime_.idx(a.die, a.plane, a.block);
+        uint32_t reads = ++runtime_.read_count[bi];
+        uint64_t t_prog = runtime_.prog_time_ns[bi];
+        if ((cell_.read_disturb_limit && reads > cell_.read_disturb_limit) ||
+            (cell_.retention_limit_ns && t_prog != NandRuntime::kNoProgTime && op.issue_ns > t_prog &&
+             op.issue_ns - t_prog > cell_.retention_limit_ns)) {
+            stats_.ecc_errors++;
+            return {NandStatus::ECC_ERROR, "uncorrectable ecc"};
+        }
+        const Page pg = model_.read_page(a.die, a.plane, a.block, a.page);
         op.data.push_back(pg.data);
         op.oob_lba.push_back(pg.oob_lba);
         op.oob_seq.push_back(pg.oob_seq);
+        op.done++;
     }
     return {NandStatus::SUCCESS, "read success"};
 }
@@ -57,8 +231,10 @@ pair<NandStatus, string> NandDriver::execute_read(NandOp &op)
 pair<NandStatus, string> NandDriver::execute_program(NandOp &op)
 {
     // parameter consistency validated in submit
+    op.done = 0;
     for (size_t i = 0; i < op.targets.size(); ++i) {
         const auto &a = op.targets[i];
+        stats_.program_ops++;
         if (runtime_.should_fail(a.die, a.plane, a.block)) {
             stats_.failed_ops++;
             return {NandStatus::FAILED, "injected failure"};
@@ -67,23 +243,36 @@ pair<NandStatus, string> NandDriver::execute_program(NandOp &op)
             stats_.bad_blocks_detected++;
             return {NandStatus::BAD_BLOCK, "bad block"};
         }
-        Page &pg = model_.dies[a.die].planes[a.plane].blocks[a.block].pages[a.page];
-        if (!(pg.data.empty() && pg.oob_seq == 0)) {
+        if (a.page >= pages_in_block(a.die, a.plane, a.block)) {
+            stats_.failed_ops++;
+            return {NandStatus::FAILED, "page beyond SLC capacity"};
+        }
+        if (!model_.is_page_erased(a.die, a.plane, a.block, a.page)) {
             stats_.failed_ops++;
             return {NandStatus::FAILED, "program on non-erased page"};
         }
+        Page pg;
+        pg.oob_bad = model_.page_oob_bad(a.die, a.plane, a.block, a.page);
         if (!op.data.empty()) pg.data = op.data[i];
         if (!op.oob_lba.empty()) pg.oob_lba = op.oob_lba[i];
         if (!op.oob_seq.empty()) pg.oob_seq = op.oob_seq[i];
-        if (verbose_) std::cout << "pba[" << a.die << ":" << a.plane << ":" << a.block << ":" << a.page << "] data:" << pg.data << " lba" << pg.oob_lba << std::endl;
-        runtime_.prog_count[runtime_.idx(a.die, a.plane, a.block)]++;
+        model_.write_page(a.die, a.plane, a.block, a.page, pg);
+        if (verbose_) LOG_INFO("pba[" << a.die << ":" << a.plane << ":" << a.block << ":" << a.page << "] data:" << pg.data << " lba" << pg.oob_lba);
+        int bi = runtime_.idx(a.die, a.plane, a.block);
+        runtime_.prog_count[bi]++;
+        if (runtime_.prog_time_ns[bi] == NandRuntime::kNoProgTime)
+            runtime_.prog_time_ns[bi] = op.issue_ns;
+        if (is_block_slc(a.die, a.plane, a.block)) stats_.slc_program_ops++;
+        op.done++;
     }
     return {NandStatus::SUCCESS, "program success"};
 }
 
 pair<NandStatus, string> NandDriver::execute_erase(NandOp &op)
 {
+    op.done = 0;
     for (const auto &a : op.targets) {
+        stats_.erase_ops++;
         if (!valid_block(a.die, a.plane, a.block)) {
             stats_.failed_ops++;
             return {NandStatus::FAILED, "invalid block"};
@@ -96,26 +285,37 @@ pair<NandStatus, string> NandDriver::execute_erase(NandOp &op)
             stats_.bad_blocks_detected++;
             return {NandStatus::BAD_BLOCK, "bad block"};
         }
+        // 耐久：SLC 模式与原生模式各自的 P/E 上限
+        uint32_t limit = is_block_slc(a.die, a.plane, a.block) ? cell_.slc_pe_limit : cell_.pe_limit;
+        if (limit && runtime_.erase_count[runtime_.idx(a.die, a.plane, a.block)] >= limit) {
+            stats_.failed_ops++;
+            return {NandStatus::FAILED, "wear out"};
+        }
         erase_block(a.die, a.plane, a.block, true);
+        op.done++;
     }
     return {NandStatus::SUCCESS, "erase success"};
 }
 
 pair<NandStatus,string> NandDriver::validate_op_common(const NandOp &op) const
 {
-    if (op.targets.empty()) return {NandStatus::FAILED, "no targets"};
+    if (op.targets.empty()) return {NandStatus::INVALID_PARAM, "no targets"};
     // basic checks for target addresses
     for (const auto &a : op.targets) {
-        if (!valid_block(a.die, a.plane, a.block)) return {NandStatus::FAILED, "invalid block"};
+        if (!valid_block(a.die, a.plane, a.block)) return {NandStatus::INVALID_PARAM, "invalid block"};
         if (op.cmd == NandCmd::READ_PAGE) {
-            if (a.page < 0 || a.page >= model_.pages_per_block) return {NandStatus::FAILED, "invalid page"};
+            if (a.page < 0 || a.page >= model_.pages_per_block) return {NandStatus::INVALID_PARAM, "invalid page"};
         }
     }
     // PROGRAM specific param counts
     if (op.cmd == NandCmd::PROGRAM_PAGE) {
-        if (!op.data.empty() && op.data.size() != op.targets.size()) return {NandStatus::FAILED, "data size mismatch"};
-        if (!op.oob_lba.empty() && op.oob_lba.size() != op.targets.size()) return {NandStatus::FAILED, "oob_lba size mismatch"};
-        if (!op.oob_seq.empty() && op.oob_seq.size() != op.targets.size()) return {NandStatus::FAILED, "oob_seq size mismatch"};
+        if (!op.data.empty() && op.data.size() != op.targets.size()) return {NandStatus::INVALID_PARAM, "data size mismatch"};
+        if (!op.oob_lba.empty() && op.oob_lba.size() != op.targets.size()) return {NandStatus::INVALID_PARAM, "oob_lba size mismatch"};
+        if (!op.oob_seq.empty() && op.oob_seq.size() != op.targets.size()) return {NandStatus::INVALID_PARAM, "oob_seq size mismatch"};
+        // file-backed 镜像的页大小固定
+        if (model_.is_file_backed())
+            for (const auto &d : op.data)
+                if ((int)d.size() > model_.page_bytes()) return {NandStatus::INVALID_PARAM, "payload exceeds page size"};
     }
     return {NandStatus::SUCCESS, "ok"};
 }
@@ -129,8 +329,7 @@ pair<NandStatus,string> NandDriver::validate_targets_for_program(const NandOp &o
         // check bad block or runtime fail
         if (runtime_.should_fail(a.die, a.plane, a.block)) return {NandStatus::FAILED, "injected failure"};
         if (is_block_bad(a.die, a.plane, a.block)) return {NandStatus::BAD_BLOCK, "bad block"};
-        const Page &pg = model_.dies[a.die].planes[a.plane].blocks[a.block].pages[a.page];
-        if (!(pg.data.empty() && pg.oob_seq == 0)) return {NandStatus::FAILED, "program on non-erased page"};
+        if (!model_.is_page_erased(a.die, a.plane, a.block, a.page)) return {NandStatus::FAILED, "program on non-erased page"};
     }
     return {NandStatus::SUCCESS, "ok"};
 }
@@ -139,9 +338,8 @@ bool NandDriver::is_block_bad(int d, int p, int b) const
 {
     if (!valid_block(d, p, b))
         return true;
-    const auto &blk = model_.dies[d].planes[p].blocks[b];
-    uint8_t b0 = blk.pages[0].oob_bad;
-    uint8_t b1 = (model_.pages_per_block >= 2) ? blk.pages[1].oob_bad : 0xFF;
+    uint8_t b0 = model_.page_oob_bad(d, p, b, 0);
+    uint8_t b1 = (model_.pages_per_block >= 2) ? model_.page_oob_bad(d, p, b, 1) : 0xFF;
     return (b0 != 0xFF) || (b1 != 0xFF);
 }
 
@@ -149,39 +347,67 @@ void NandDriver::mark_block_bad_oob(int d, int p, int b)
 {
     if (!valid_block(d, p, b))
         return;
-    auto &blk = model_.dies[d].planes[p].blocks[b];
     if (model_.pages_per_block >= 1)
-        blk.pages[0].oob_bad = 0x00;
+        model_.set_page_oob_bad(d, p, b, 0, 0x00);
     if (model_.pages_per_block >= 2)
-        blk.pages[1].oob_bad = 0x00;
+        model_.set_page_oob_bad(d, p, b, 1, 0x00);
     
     stats_.bad_blocks_detected++;
-    std::cout << "Marking block [" << d << "-" << p << "-" << b << "] bad" << std::endl;
+    LOG_INFO("Marking block [" << d << "-" << p << "-" << b << "] bad");
 }
 
-int NandDriver::pages_per_block() const 
-{ 
-    return model_.pages_per_block; 
+pair<int, uint64_t> NandDriver::read_oob(int d, int p, int b, int g) const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!valid_block(d, p, b) || g < 0 || g >= model_.pages_per_block)
+        return {-1, 0};
+    return {model_.page_oob_lba(d, p, b, g), model_.page_oob_seq(d, p, b, g)};
 }
 
-int NandDriver::blocks_per_plane() const 
-{ 
-    return model_.blocks_per_plane; 
+bool NandDriver::preload_page(const NandAddr &a, const string &data, int oob_lba, uint64_t oob_seq, uint64_t now_ns)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!valid_addr(a) || is_block_bad(a.die, a.plane, a.block) || !model_.is_page_erased(a.die, a.plane, a.block, a.page))
+        return false;
+    if (model_.is_file_backed() && (int)data.size() > model_.page_bytes())
+        return false;
+    Page pg;
+    pg.oob_bad = model_.page_oob_bad(a.die, a.plane, a.block, a.page);
+    pg.data = data;
+    pg.oob_lba = oob_lba;
+    pg.oob_seq = oob_seq;
+    model_.write_page(a.die, a.plane, a.block, a.page, pg);
+    int bi = runtime_.idx(a.die, a.plane, a.block);
+    runtime_.prog_count[bi]++;
+    if (runtime_.prog_time_ns[bi] == NandRuntime::kNoProgTime)
+        runtime_.prog_time_ns[bi] = now_ns;
+    return true;
 }
 
-int NandDriver::planes_per_die() const 
+uint32_t NandDriver::get_erase_count(int d, int p, int b) const 
 { 
-    return model_.planes_per_die; 
+    return runtime_.erase_count[runtime_.idx(d, p, b)]; 
 }
 
-int NandDriver::dies_per_nand() const 
-{ 
-    return model_.dies_per_nand; 
+void NandDriver::set_block_slc(int d, int p, int b, bool slc)
+{
+    if (valid_block(d, p, b))
+        runtime_.slc_mode[runtime_.idx(d, p, b)] = slc ? 1 : 0;
 }
 
-uint32_t NandDriver::get_erase_count(int d, int p, int b) const 
-{ 
-    return runtime_.erase_count[runtime_.idx(d, p, b)]; 
+bool NandDriver::is_block_slc(int d, int p, int b) const
+{
+    return valid_block(d, p, b) && runtime_.slc_mode[runtime_.idx(d, p, b)] != 0;
+}
+
+int NandDriver::slc_pages_per_block() const
+{
+    return max(1, model_.pages_per_block / max(1, cell_.bits_per_cell));
+}
+
+int NandDriver::pages_in_block(int d, int p, int b) const
+{
+    return is_block_slc(d, p, b) ? slc_pages_per_block() : model_.pages_per_block;
 }
 
 void NandDriver::inject_factory_bad(int d, int p, int b) 
@@ -213,15 +439,9 @@ void NandDriver::erase_block(int d, int p, int b, bool preserve_bad_mark)
 {
     if (!valid_block(d, p, b))
         return;
-    Block &blk = model_.dies[d].planes[p].blocks[b];
-    for (int pg = 0; pg < model_.pages_per_block; ++pg)
-    {
-        Page &pgi = blk.pages[pg];
-        pgi.data.clear();
-        pgi.oob_lba = -1;
-        pgi.oob_seq = 0;
-        if (!preserve_bad_mark)
-            pgi.oob_bad = 0xFF;
-    }
-    runtime_.erase_count[runtime_.idx(d, p, b)]++;
+    model_.erase_block(d, p, b, preserve_bad_mark);
+    int bi = runtime_.idx(d, p, b);
+    runtime_.erase_count[bi]++;
+    runtime_.read_count[bi] = 0;
+    runtime_.prog_time_ns[bi] = NandRuntime::kNoProgTime;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <bits/stdc++.h>
 #include "nand_model.h"
 #include "nand_runtime.h"
+#include "trace.h"
 using namespace std;
 
 /* ---------------- NandOp / NandDriver ---------------- */
@@ -18,7 +19,8 @@ enum class NandStatus {
     FAILED = 1,
     BAD_BLOCK = 2,
     ECC_ERROR = 3,
-    TIMEOUT = 4
+    TIMEOUT = 4,
+    INVALID_PARAM = 5 // 命令本身不合法（地址越界、负载超出镜像页等），未触及介质，不能据此判坏
 };
 
 struct NandOp
@@ -28,15 +30,47 @@ struct NandOp
     vector<string> data;      
     vector<int> oob_lba;      
     vector<uint64_t> oob_seq; 
+    // 时序模型：issue_ns 由调用方填写（仿真时钟），complete_ns 由 driver 返回
+    uint64_t issue_ns = 0;
+    uint64_t complete_ns = 0;
+    // 多目标 op 按 targets 顺序执行、遇错即停：done 为成功完成的目标数（失败时即出错目标的下标）
+    size_t done = 0;
 };
 
-// NAND驱动统计信息
+// 单元/时序参数：SLC 模式块只写 ppb / bits_per_cell 页，program 更快、耐久更高
+struct NandCellParams {
+    int bits_per_cell = 3;            // 3 = TLC, 4 = QLC
+    uint64_t t_read_ns = 60000;
+    uint64_t t_read_slc_ns = 30000;
+    uint64_t t_prog_ns = 700000;
+    uint64_t t_prog_slc_ns = 150000;
+    uint64_t t_erase_ns = 3000000;
+    uint32_t pe_limit = 0;            // 0 = 不限；达到后擦除失败（磨损坏块）
+    uint32_t slc_pe_limit = 0;
+    // 超出后读返回 ECC_ERROR（0 = 不模拟）：擦除后累计读次数 / 距首次 program 的时间
+    uint32_t read_disturb_limit = 0;
+    uint64_t retention_limit_ns = 0;
+    // 读优先：读插到同 die 已排队的 program/erase 之前（已在执行的那个仍要等它做完）
+    bool read_priority = false;
+    // program/erase suspend：读到达时可打断同 die 上正在执行的 program/erase（0 = 不支持）
+    uint32_t max_suspends = 0;       // 每个 program/erase 最多被打断的次数
+    uint64_t t_suspend_ns = 20000;   // 暂停进行中操作的开销（读开始前）
+    uint64_t t_resume_ns = 10000;    // 恢复开销（加到被打断的操作上）
+};
+
+// NAND驱动统计信息（读 / 写 / 擦按目标计，多目标 op 计多次）
 struct NandStats {
     uint64_t read_ops = 0;
     uint64_t program_ops = 0;
     uint64_t erase_ops = 0;
     uint64_t failed_ops = 0;
     uint64_t bad_blocks_detected = 0;
+    uint64_t slc_program_ops = 0;
+    uint64_t ecc_errors = 0;
+    uint64_t suspends = 0;            // 读打断 program/erase 的次数
+    // 读优先 / suspend 的写侧代价：program/erase 的完成时刻返回给调用方之后，又被打断或插队的读推迟
+    uint64_t delayed_long_ops = 0;    // 被推迟过的 program/erase（按 die 计）
+    uint64_t long_op_delay_ns = 0;    // 推迟总时长
 };
 
 class NandDriver
@@ -55,16 +89,34 @@ public:
     
     // 标记块为坏块
     void mark_block_bad_oob(int d, int p, int b);
+
+    // 只读 OOB（lba, seq），不搬运 payload，用于上电重建映射
+    pair<int, uint64_t> read_oob(int d, int p, int b, int g) const;
+    // 预置状态（FTL::precondition）：直接写页与 OOB 并计 prog_count，不排时序、不计统计、不做故障注入
+    bool preload_page(const NandAddr &a, const string &data, int oob_lba, uint64_t oob_seq, uint64_t now_ns);
     
-    // NAND参数获取
-    int pages_per_block() const;
-    int blocks_per_plane() const;
-    int planes_per_die() const;
-    int dies_per_nand() const;
+    // NAND参数获取（热路径上频繁调用，内联）
+    int pages_per_block() const { return model_.pages_per_block; }
+    int blocks_per_plane() const { return model_.blocks_per_plane; }
+    int planes_per_die() const { return model_.planes_per_die; }
+    int dies_per_nand() const { return model_.dies_per_nand; }
+    const NandGeometry &geometry() const { return model_.geo; }
+    // file-backed 镜像的固定页大小（program 负载不得超出）；内存模式为 0（不限）
+    int fixed_page_bytes() const { return model_.is_file_backed() ? model_.page_bytes() : 0; }
 
     // 获取块擦除计数
     uint32_t get_erase_count(int d, int p, int b) const;
 
+    // 单元模式（SLC/原生）与时序参数
+    void set_cell_params(const NandCellParams &cp) { cell_ = cp; }
+    const NandCellParams &cell_params() const { return cell_; }
+    void set_block_slc(int d, int p, int b, bool slc);
+    bool is_block_slc(int d, int p, int b) const;
+    int slc_pages_per_block() const;
+    int pages_in_block(int d, int p, int b) const;
+    // 该 die 上最后一个已提交操作的完成时刻
+    uint64_t die_busy_until(int d) const { return die_busy_until_[d]; }
+
     // 坏块注入（用于测试）
     void inject_factory_bad(int d, int p, int b);
     void inject_runtime_fail(int d, int p, int b);
@@ -73,11 +125,34 @@ public:
     // 统计信息
     const NandStats& get_stats() const { return stats_; }
     void reset_stats() { stats_ = NandStats{}; }
+    // 记录每个 program 在每个 die 上的最终时延（完成 - 下发，含排队与返回后被读推迟的部分）；默认关闭
+    void set_record_program_latency(bool on) { record_prog_lat_ = on; }
+    // 已记录的样本，加上时间线上尚未退出、完成时刻可能还会被推迟的 program 的当前值
+    vector<uint64_t> program_latencies_ns() const;
+    void clear_program_latencies() { prog_lat_ns_.clear(); }
 
 private:
     NandModel &model_;
     NandRuntime &runtime_;
     NandStats stats_;
+    NandCellParams cell_;
+    vector<uint64_t> die_busy_until_;
+    vector<uint64_t> die_start_ns_; // 该 die 上最后一个操作的开始 / 结束时刻（trace 用）
+    vector<uint64_t> die_end_ns_;
+    // 读优先 / suspend 打开时按 die 保留尚未完成的操作时间线，读可插队或打断
+    struct DieSlot
+    {
+        uint64_t start = 0, end = 0;
+        bool long_op = false;  // program / erase
+        uint64_t read_end = 0; // 打断期间插入的读在此时刻之前占用 die
+        uint32_t suspends = 0;
+        uint64_t issue = 0;
+        bool program = false;
+        bool delayed = false;  // 完成时刻返回后被推迟过
+    };
+    vector<deque<DieSlot>> die_q_;
+    bool record_prog_lat_ = false;
+    vector<uint64_t> prog_lat_ns_;
     // protect access to model_/runtime_/stats_ (use recursive to allow submit->read_page nesting)
     mutable std::mutex mtx_;
     bool verbose_ = false;
@@ -91,6 +166,11 @@ private:
     pair<NandStatus, string> execute_program(NandOp &op);
     pair<NandStatus, string> execute_erase(NandOp &op);
     // helpers
+    void account_timing(NandOp &op);
+    uint64_t schedule_on_die(int d, NandCmd cmd, uint64_t issue, uint64_t lat);
+    void delay_long_op(DieSlot &s, uint64_t delta);
+    void trace_op(const NandOp &op, NandStatus st);
+    uint64_t op_latency_ns(NandCmd cmd, const NandAddr &a) const;
     pair<NandStatus,string> validate_op_common(const NandOp &op) const;
     pair<NandStatus,string> validate_targets_for_program(const NandOp &op) const;
 };
@@ -1,6 +1,14 @@
 #include "nand_model.h"
+#include "mem_account.h"
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char kImageMagic[8] = {'F', 'T', 'L', 'N', 'A', 'N', 'D', '1'};
+static const uint32_t kImageVersion = 1;
+static const uint64_t kImageHeaderBytes = 4096;
 
 /* ---------------- NandModel (pure physical) ---------------- */
 Block::Block(int ppb) : pages(ppb) {}
@@ -18,19 +26,208 @@ Die::Die(int ppb, int bpp, int ppd)
 }
 
 NandModel::NandModel(int dpn, int ppd, int bpp, int ppb)
-    : pages_per_block(ppb), blocks_per_plane(bpp), planes_per_die(ppd), dies_per_nand(dpn)
+    : pages_per_block(ppb), blocks_per_plane(bpp), planes_per_die(ppd), dies_per_nand(dpn),
+      geo(dpn, ppd, bpp, ppb)
 {
+    MemScope scope(MemComponent::NAND_PAGES);
     for (int d = 0; d < dpn; ++d)
         dies.emplace_back(ppb, bpp, ppd);
 }
-     
+
+NandModel::NandModel(int dpn, int ppd, int bpp, int ppb, const string &image_path, int page_bytes)
+    : pages_per_block(ppb), blocks_per_plane(bpp), planes_per_die(ppd), dies_per_nand(dpn),
+      geo(dpn, ppd, bpp, ppb), page_bytes_(page_bytes)
+{
+    ok_ = page_bytes_ > 0 && open_image(image_path);
+    if (!ok_)
+        LOG_ERROR("[NAND] open image failed: " << image_path);
+}
+
+NandModel::~NandModel()
+{
+    if (base_)
+    {
+        msync(base_, map_bytes_, MS_ASYNC);
+        munmap(base_, map_bytes_);
+    }
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+bool NandModel::open_image(const string &path)
+{
+    uint64_t total_pages = (uint64_t)dies_per_nand * planes_per_die * blocks_per_plane * pages_per_block;
+    uint64_t oob_offset = kImageHeaderBytes;
+    uint64_t data_offset = oob_offset + total_pages * sizeof(NandOobRecord);
+    data_offset = (data_offset + 4095) & ~(uint64_t)4095;
+    uint64_t file_bytes = data_offset + total_pages * (uint64_t)page_bytes_;
+
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd_, &st) != 0)
+        return false;
+
+    NandImageHeader hdr{};
+    if (st.st_size > 0)
+    {
+        // 已有镜像：校验几何
+        if (pread(fd_, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+            return false;
+        if (memcmp(hdr.magic, kImageMagic, sizeof(kImageMagic)) != 0 || hdr.version != kImageVersion)
+            return false;
+        if ((int)hdr.dies != dies_per_nand || (int)hdr.planes != planes_per_die ||
+            (int)hdr.blocks != blocks_per_plane || (int)hdr.pages != pages_per_block ||
+            (int)hdr.page_bytes != page_bytes_)
+        {
+            LOG_ERROR("[NAND] image geometry mismatch");
+            return false;
+        }
+        if ((uint64_t)st.st_size < file_bytes)
+            return false;
+        reopened_ = true;
+    }
+    else
+    {
+        // 新镜像：写头并扩展为稀疏文件（全零 == 全擦除）
+        memcpy(hdr.magic, kImageMagic, sizeof(kImageMagic));
+        hdr.version = kImageVersion;
+        hdr.dies = dies_per_nand;
+        hdr.planes = planes_per_die;
+        hdr.blocks = blocks_per_plane;
+        hdr.pages = pages_per_block;
+        hdr.page_bytes = page_bytes_;
+        hdr.oob_offset = oob_offset;
+        hdr.data_offset = data_offset;
+        if (ftruncate(fd_, (off_t)file_bytes) != 0)
+            return false;
+        if (pwrite(fd_, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+            return false;
+    }
+
+    void *m = mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED)
+        return false;
+    base_ = static_cast<uint8_t *>(m);
+    map_bytes_ = file_bytes;
+    oob_ = reinterpret_cast<NandOobRecord *>(base_ + hdr.oob_offset);
+    data_ = base_ + hdr.data_offset;
+    return true;
+}
+
+void NandModel::sync()
+{
+    if (base_)
+        msync(base_, map_bytes_, MS_SYNC);
+}
+
+Page NandModel::read_page(int d, int p, int b, int g) const
+{
+    if (!base_)
+        return dies[d].planes[p].blocks[b].pages[g];
+    uint64_t i = page_index(d, p, b, g);
+    const NandOobRecord &r = oob_[i];
+    Page pg;
+    pg.data.assign(reinterpret_cast<const char *>(data_ + i * page_bytes_), r.data_len);
+    pg.oob_lba = r.oob_lba_plus1 - 1;
+    pg.oob_seq = r.oob_seq;
+    pg.oob_bad = r.oob_bad_inv ^ 0xFF;
+    return pg;
+}
+
+void NandModel::write_page(int d, int p, int b, int g, const Page &pg)
+{
+    if (!base_)
+    {
+        MemScope scope(MemComponent::NAND_PAGES);
+        dies[d].planes[p].blocks[b].pages[g] = pg;
+        return;
+    }
+    uint64_t i = page_index(d, p, b, g);
+    NandOobRecord &r = oob_[i];
+    // payload 超出页大小由 driver 拒绝，这里只做截断保护
+    uint32_t n = (uint32_t)min<size_t>(pg.data.size(), (size_t)page_bytes_);
+    if (n)
+        memcpy(data_ + i * page_bytes_, pg.data.data(), n);
+    r.data_len = n;
+    r.oob_lba_plus1 = pg.oob_lba + 1;
+    r.oob_seq = pg.oob_seq;
+    r.oob_bad_inv = pg.oob_bad ^ 0xFF;
+}
+
+bool NandModel::is_page_erased(int d, int p, int b, int g) const
+{
+    if (!base_)
+    {
+        const Page &pg = dies[d].planes[p].blocks[b].pages[g];
+        return pg.data.empty() && pg.oob_seq == 0;
+    }
+    const NandOobRecord &r = oob_[page_index(d, p, b, g)];
+    return r.data_len == 0 && r.oob_seq == 0;
+}
+
+int NandModel::page_oob_lba(int d, int p, int b, int g) const
+{
+    if (!base_)
+        return dies[d].planes[p].blocks[b].pages[g].oob_lba;
+    return oob_[page_index(d, p, b, g)].oob_lba_plus1 - 1;
+}
+
+uint64_t NandModel::page_oob_seq(int d, int p, int b, int g) const
+{
+    if (!base_)
+        return dies[d].planes[p].blocks[b].pages[g].oob_seq;
+    return oob_[page_index(d, p, b, g)].oob_seq;
+}
+
+uint8_t NandModel::page_oob_bad(int d, int p, int b, int g) const
+{
+    if (!base_)
+        return dies[d].planes[p].blocks[b].pages[g].oob_bad;
+    return oob_[page_index(d, p, b, g)].oob_bad_inv ^ 0xFF;
+}
+
+void NandModel::set_page_oob_bad(int d, int p, int b, int g, uint8_t v)
+{
+    if (!base_)
+    {
+        dies[d].planes[p].blocks[b].pages[g].oob_bad = v;
+        return;
+    }
+    oob_[page_index(d, p, b, g)].oob_bad_inv = v ^ 0xFF;
+}
+
+void NandModel::erase_block(int d, int p, int b, bool preserve_bad_mark)
+{
+    for (int g = 0; g < pages_per_block; ++g)
+    {
+        if (!base_)
+        {
+            Page &pgi = dies[d].planes[p].blocks[b].pages[g];
+            pgi.data.clear();
+            pgi.oob_lba = -1;
+            pgi.oob_seq = 0;
+            if (!preserve_bad_mark)
+                pgi.oob_bad = 0xFF;
+            continue;
+        }
+        NandOobRecord &r = oob_[page_index(d, p, b, g)];
+        r.data_len = 0;
+        r.oob_lba_plus1 = 0;
+        r.oob_seq = 0;
+        if (!preserve_bad_mark)
+            r.oob_bad_inv = 0;
+    }
+}
+
 void NandModel::dump_page_stats()
 {
-    for (auto &die : dies){
-        for (auto &plane : die.planes){
-            for (auto &block : plane.blocks){
-                for (auto &page : block.pages){
-                    cout << (page.oob_bad == 0xFF ? "E" : "B")<< " ";
+    for (int d = 0; d < dies_per_nand; ++d){
+        for (int p = 0; p < planes_per_die; ++p){
+            for (int b = 0; b < blocks_per_plane; ++b){
+                for (int g = 0; g < pages_per_block; ++g){
+                    cout << (page_oob_bad(d, p, b, g) == 0xFF ? "E" : "B")<< " ";
                 }
                 cout << endl;
             }
@@ -39,18 +236,18 @@ void NandModel::dump_page_stats()
 }
 void NandModel::dump_page_data()
 {
-    for (auto &die : dies){
-        for (auto &plane : die.planes){
-            for (auto &block : plane.blocks){
-                if(block.pages[0].oob_bad==0x00){
+    for (int d = 0; d < dies_per_nand; ++d){
+        for (int p = 0; p < planes_per_die; ++p){
+            for (int b = 0; b < blocks_per_plane; ++b){
+                if(page_oob_bad(d, p, b, 0)==0x00){
                     cout << setw(6) << "BAD" << endl;
                     continue;
                 }
-                for (auto &page : block.pages){
-                    cout << setw(6) << page.data<< " ";
+                for (int g = 0; g < pages_per_block; ++g){
+                    cout << setw(6) << read_page(d, p, b, g).data<< " ";
                 }
                 cout << endl;
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 #define NAND_MODEL_H
 
 #include <bits/stdc++.h>
+#include "nand_geometry.h"
+#include "logger.h"
 using namespace std;
 
 /* ---------------- basic enums ---------------- */
@@ -45,14 +47,74 @@ struct Die
     Die(int ppb, int bpp, int ppd);
 };
 
+/* ---------------- 镜像文件布局（file-backed 模式） ----------------
+   [ NandImageHeader | pad 到 4KiB ][ OOB 区: NandOobRecord × 总页数 ][ 数据区: page_bytes × 总页数 ]
+   - OOB 与数据分区存放：重建映射时只扫描 OOB 区，不触碰 payload
+   - 全零即擦除态：oob_lba 存 lba+1，oob_bad 存 ~bad，新建的稀疏文件无需初始化
+*/
+struct NandImageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dies, planes, blocks, pages;
+    uint32_t page_bytes;
+    uint64_t oob_offset;
+    uint64_t data_offset;
+};
+
+struct NandOobRecord
+{
+    uint32_t data_len;
+    int32_t oob_lba_plus1;
+    uint64_t oob_seq;
+    uint8_t oob_bad_inv;
+    uint8_t pad[7];
+};
+
 struct NandModel
 {
     int pages_per_block, blocks_per_plane, planes_per_die, dies_per_nand;
-    vector<Die> dies;
+    NandGeometry geo;
+    vector<Die> dies; // 仅内存模式使用
     NandModel(int dpn, int ppd, int bpp, int ppb);
+    // file-backed 模式：打开/创建镜像文件并 mmap；几何不一致或 I/O 失败时 ok() 为 false
+    NandModel(int dpn, int ppd, int bpp, int ppb, const string &image_path, int page_bytes);
+    ~NandModel();
+    NandModel(const NandModel &) = delete;
+    NandModel &operator=(const NandModel &) = delete;
+
+    bool ok() const { return ok_; }
+    bool is_file_backed() const { return base_ != nullptr; }
+    // 打开的是已有镜像（而非新建）
+    bool reopened() const { return reopened_; }
+    int page_bytes() const { return page_bytes_; }
+    void sync();
+
+    // —— 页访问（driver 统一经由这里，屏蔽内存/镜像两种存储） —— //
+    Page read_page(int d, int p, int b, int g) const;
+    void write_page(int d, int p, int b, int g, const Page &pg);
+    bool is_page_erased(int d, int p, int b, int g) const;
+    int page_oob_lba(int d, int p, int b, int g) const;
+    uint64_t page_oob_seq(int d, int p, int b, int g) const;
+    uint8_t page_oob_bad(int d, int p, int b, int g) const;
+    void set_page_oob_bad(int d, int p, int b, int g, uint8_t v);
+    void erase_block(int d, int p, int b, bool preserve_bad_mark);
+
     void dump_page_stats();
     void dump_page_data();
 
+private:
+    bool ok_ = true;
+    bool reopened_ = false;
+    int page_bytes_ = 0;
+    int fd_ = -1;
+    uint8_t *base_ = nullptr;
+    size_t map_bytes_ = 0;
+    NandOobRecord *oob_ = nullptr;
+    uint8_t *data_ = nullptr;
+
+    bool open_image(const string &path);
+    uint64_t page_index(int d, int p, int b, int g) const { return geo.pba64(d, p, b, g); }
 };
 
-#endif // NAND_MODEL_H
\ No newline at end of file
+#endif // NAND_MODEL_H
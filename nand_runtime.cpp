@@ -8,7 +8,10 @@ NandRuntime::NandRuntime(int dies_, int planes_, int blocks_)
     : dies(dies_), planes(planes_), blocks(blocks_),
       erase_count(dies_ * planes_ * blocks_, 0),
       prog_count(dies_ * planes_ * blocks_, 0),
-      bad_block_table(dies_ * planes_ * blocks_, false) {}
+      bad_block_table(dies_ * planes_ * blocks_, false),
+      slc_mode(dies_ * planes_ * blocks_, 0),
+      read_count(dies_ * planes_ * blocks_, 0),
+      prog_time_ns(dies_ * planes_ * blocks_, kNoProgTime) {}
 
 void NandRuntime::status()
 {
@@ -29,8 +32,58 @@ void NandRuntime::status()
     cout << "\n=========================================================\n";
 }
 
-int NandRuntime::idx(int d, int p, int b) const { 
-    return ((d * planes) + p) * blocks + b; 
-}
 uint64_t NandRuntime::key(int d, int p, int b) const { return ((uint64_t)d << 30) | ((uint64_t)p << 20) | (uint64_t)b; }
 bool NandRuntime::should_fail(int d, int p, int b) const { return injected_fail_blocks.count(key(d, p, b)) > 0; }
+
+/* 文件格式: magic "FTLRT001" | dies planes blocks (uint32) | erase_count[] | prog_count[] | bbt[] (uint8)
+            [| read_count[]]（可选尾段，旧文件没有；prog_time_ns 属于仿真时钟，不持久化） */
+static const char kRuntimeMagic[8] = {'F', 'T', 'L', 'R', 'T', '0', '0', '1'};
+
+bool NandRuntime::save(const string &path) const
+{
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out)
+        return false;
+    uint32_t geo[3] = {(uint32_t)dies, (uint32_t)planes, (uint32_t)blocks};
+    out.write(kRuntimeMagic, sizeof(kRuntimeMagic));
+    out.write(reinterpret_cast<const char *>(geo), sizeof(geo));
+    out.write(reinterpret_cast<const char *>(erase_count.data()), erase_count.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(prog_count.data()), prog_count.size() * sizeof(uint32_t));
+    vector<uint8_t> bbt(bad_block_table.begin(), bad_block_table.end());
+    out.write(reinterpret_cast<const char *>(bbt.data()), bbt.size());
+    out.write(reinterpret_cast<const char *>(read_count.data()), read_count.size() * sizeof(uint32_t));
+    return (bool)out;
+}
+
+bool NandRuntime::load(const string &path)
+{
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    char magic[8];
+    uint32_t geo[3];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(geo), sizeof(geo));
+    if (!in || memcmp(magic, kRuntimeMagic, sizeof(magic)) != 0)
+        return false;
+    if ((int)geo[0] != dies || (int)geo[1] != planes || (int)geo[2] != blocks)
+    {
+        LOG_ERROR("[RUNTIME] geometry mismatch: " << path);
+        return false;
+    }
+    size_t n = erase_count.size();
+    vector<uint32_t> ec(n), pc(n);
+    vector<uint8_t> bbt(n);
+    in.read(reinterpret_cast<char *>(ec.data()), n * sizeof(uint32_t));
+    in.read(reinterpret_cast<char *>(pc.data()), n * sizeof(uint32_t));
+    in.read(reinterpret_cast<char *>(bbt.data()), n);
+    if (!in)
+        return false;
+    erase_count.swap(ec);
+    prog_count.swap(pc);
+    bad_block_table.assign(bbt.begin(), bbt.end());
+    vector<uint32_t> rc(n);
+    if (in.read(reinterpret_cast<char *>(rc.data()), n * sizeof(uint32_t)))
+        read_count.swap(rc);
+    return true;
+}
@@ -12,15 +12,24 @@ struct NandRuntime
     vector<uint32_t> erase_count; // per-block
     vector<uint32_t> prog_count;
     vector<bool> bad_block_table;                             // bad-block table
+    vector<uint8_t> slc_mode;                                 // per-block: 1 = SLC 模式
+    // read disturb / retention：擦除后清零；prog_time_ns 为擦除后第一次 program 的仿真时刻
+    static constexpr uint64_t kNoProgTime = UINT64_MAX;
+    vector<uint32_t> read_count;
+    vector<uint64_t> prog_time_ns;
     unordered_set<uint64_t> injected_fail_blocks; // fault inject
 
     NandRuntime(int dies_, int planes_, int blocks_);
     void status();
 
-    int idx(int d, int p, int b) const;
+    int idx(int d, int p, int b) const { return ((d * planes) + p) * blocks + b; }
     uint64_t key(int d, int p, int b) const;
     bool should_fail(int d, int p, int b) const;
 
+    // 持久化 erase/prog 计数与 BBT（与 NandModel 镜像放在一起，"<image>.rt"）
+    bool save(const string &path) const;
+    bool load(const string &path);
+
 };
 
 #endif // NAND_RUNTIME_H
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "nvme_host.h"
+#include "logger.h"
+
+NvmeHost::NvmeHost(FTL &ftl, uint64_t cmd_overhead_ns) : ftl_(ftl), overhead_ns_(cmd_overhead_ns)
+{
+    ftl_.set_host_async(true);
+    now_ns_ = ctrl_busy_ns_ = ftl_.now_ns();
+}
+
+NvmeHost::~NvmeHost()
+{
+    ftl_.set_host_async(false);
+}
+
+int NvmeHost::create_queue_pair(int depth)
+{
+    depth = max(1, depth);
+    QueuePair qp;
+    qp.sq.resize(depth + 1);
+    qp.sq_time.resize(depth + 1);
+    qp.cq.resize(depth + 1);
+    qps_.push_back(move(qp));
+    return (int)qps_.size() - 1;
+}
+
+bool NvmeHost::submit(int qid, const NvmeCmd &cmd)
+{
+    if (qid < 0 || qid >= (int)qps_.size())
+    {
+        LOG_WARN("[NVME] bad qid " << qid);
+        return false;
+    }
+    auto &qp = qps_[qid];
+    int next = (qp.sq_tail + 1) % qp.entries();
+    if (next == qp.sq_head)
+    {
+        stats_.sq_full++;
+        return false;
+    }
+    qp.sq[qp.sq_tail] = cmd;
+    qp.sq_time[qp.sq_tail] = now_ns_;
+    qp.sq_tail = next;
+    qp.outstanding++;
+    stats_.submitted++;
+    return true;
+}
+
+void NvmeHost::ring_sq_doorbell(int qid)
+{
+    if (qid < 0 || qid >= (int)qps_.size())
+        return;
+    qps_[qid].sq_db = qps_[qid].sq_tail;
+    fetch_commands();
+}
+
+// 轮询仲裁：每轮每个有新命令的 SQ 取一条，固件按顺序串行处理
+void NvmeHost::fetch_commands()
+{
+    bool any = true;
+    while (any)
+    {
+        any = false;
+        for (size_t i = 0; i < qps_.size(); ++i)
+        {
+            size_t qid = (rr_ + i) % qps_.size();
+            auto &qp = qps_[qid];
+            if (qp.sq_head == qp.sq_db)
+                continue;
+            any = true;
+            const NvmeCmd &cmd = qp.sq[qp.sq_head];
+            uint64_t t = max(now_ns_, ctrl_busy_ns_) + overhead_ns_;
+            ctrl_busy_ns_ = t;
+            ftl_.advance_to(t);
+            uint64_t done = t;
+            Pending p{0, seq_++, execute(cmd, t, done)};
+            p.complete_ns = done;
+            p.cqe.sqid = (uint16_t)qid;
+            p.cqe.submit_ns = qp.sq_time[qp.sq_head];
+            p.cqe.complete_ns = done;
+            qp.sq_head = (qp.sq_head + 1) % qp.entries();
+            pending_.push(move(p));
+            stats_.max_inflight = max<uint64_t>(stats_.max_inflight, inflight());
+        }
+        rr_ = (rr_ + 1) % max<size_t>(1, qps_.size());
+    }
+}
+
+NvmeCqe NvmeHost::execute(const NvmeCmd &cmd, uint64_t dispatch_ns, uint64_t &complete_ns)
+{
+    NvmeCqe cqe;
+    cqe.cid = cmd.cid;
+    complete_ns = dispatch_ns;
+    if (cmd.opcode == NvmeOpcode::FLUSH)
+    {
+        // 打包缓冲落盘；完成时刻取所有 die 的忙碌结束时刻
+        ftl_.flush_pack();
+        complete_ns = max(complete_ns, ftl_.host_complete_ns());
+        if (!pending_.empty())
+        {
+            auto copy = pending_;
+            while (!copy.empty())
+            {
+                complete_ns = max(complete_ns, copy.top().complete_ns);
+                copy.pop();
+            }
+        }
+        return cqe;
+    }
+    if (cmd.ns < 0 || cmd.ns >= ftl_.namespace_count() || cmd.nlb < 1)
+    {
+        cqe.status = NvmeStatus::INVALID_FIELD;
+        return cqe;
+    }
+    if (cmd.slba < 0 || cmd.slba + cmd.nlb > ftl_.namespace_lbas(cmd.ns))
+    {
+        cqe.status = NvmeStatus::LBA_OUT_OF_RANGE;
+        return cqe;
+    }
+    for (int i = 0; i < cmd.nlb; ++i)
+    {
+        if (cmd.opcode == NvmeOpcode::WRITE)
+            ftl_.write_ns(cmd.ns, cmd.slba + i, cmd.data);
+        else
+        {
+            string out;
+            if (!ftl_.read_ns(cmd.ns, cmd.slba + i, out))
+                cqe.status = NvmeStatus::READ_ERROR;
+            cqe.data.push_back(move(out));
+        }
+        complete_ns = max(complete_ns, ftl_.host_complete_ns());
+    }
+    return cqe;
+}
+
+bool NvmeHost::post(Pending &p)
+{
+    auto &qp = qps_[p.cqe.sqid];
+    int next = (qp.cq_tail + 1) % qp.entries();
+    if (next == qp.cq_head)
+        return false;
+    qp.cq[qp.cq_tail] = move(p.cqe);
+    qp.cq_tail = next;
+    stats_.completed++;
+    return true;
+}
+
+// 到期的完成项进 CQ；先补之前因 CQ 满而推迟的
+void NvmeHost::post_completions()
+{
+    for (size_t n = stalled_.size(); n > 0; --n)
+    {
+        Pending p = move(stalled_.front());
+        stalled_.pop_front();
+        if (!post(p))
+            stalled_.push_back(move(p));
+    }
+    while (!pending_.empty() && pending_.top().complete_ns <= now_ns_)
+    {
+        Pending p = pending_.top();
+        pending_.pop();
+        if (!post(p))
+        {
+            stats_.cq_stalls++;
+            stalled_.push_back(move(p));
+        }
+    }
+}
+
+int NvmeHost::poll(int qid, vector<NvmeCqe> &out, int max)
+{
+    if (qid < 0 || qid >= (int)qps_.size())
+        return 0;
+    post_completions();
+    auto &qp = qps_[qid];
+    int n = 0;
+    while (n < max && qp.cq_head != qp.cq_tail)
+    {
+        out.push_back(move(qp.cq[qp.cq_head]));
+        qp.cq_head = (qp.cq_head + 1) % qp.entries();
+        n++;
+    }
+    qp.outstanding -= n;
+    // CQ doorbell 释放了槽位
+    if (n && !stalled_.empty())
+        post_completions();
+    return n;
+}
+
+void NvmeHost::advance_to(uint64_t t)
+{
+    now_ns_ = max(now_ns_, t);
+    post_completions();
+}
+
+bool NvmeHost::wait_completion()
+{
+    if (!pending_.empty())
+    {
+        advance_to(max(now_ns_, pending_.top().complete_ns));
+        return true;
+    }
+    return !stalled_.empty();
+}
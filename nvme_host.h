@@ -0,0 +1,126 @@
+#ifndef NVME_HOST_H
+#define NVME_HOST_H
+
+#include <bits/stdc++.h>
+#include "ftl.h"
+using namespace std;
+
+/* ---------------- NvmeHost：NVMe 风格的多队列主机接口 ----------------
+   - 若干 SQ/CQ 队列对，环形缓冲；深度 = 可同时在途的命令数（环多留一个空槽区分满/空）
+   - 主机：写 SQE 到 SQ 尾部 -> ring_sq_doorbell() 通知控制器；poll() 从 CQ 取完成项并前移 CQ 头（CQ doorbell）
+   - 控制器：收到 doorbell 后按轮询仲裁（每轮每个 SQ 取一条）取命令，固件串行处理，每条 cmd_overhead_ns；
+     命令在处理时刻下发给异步模式的 FTL，完成时刻由 NAND 时序决定，多条命令可同时在各 die 上执行
+   - 完成项在主机时钟到达完成时刻后才进 CQ；CQ 满时完成项等待（反压）
+   - 主机时钟：advance_to() / wait_completion()（推进到最早的在途完成时刻）
+*/
+enum class NvmeOpcode : uint8_t
+{
+    FLUSH = 0,
+    WRITE = 1,
+    READ = 2
+};
+
+struct NvmeCmd
+{
+    NvmeOpcode opcode = NvmeOpcode::READ;
+    uint16_t cid = 0; // 命令号，原样带回 CQE
+    int ns = 0;       // FTL namespace 下标
+    int slba = 0;     // namespace 内起始 LBA
+    int nlb = 1;      // LBA 个数
+    string data;      // 写：每个 LBA 写入同一负载
+};
+
+enum class NvmeStatus : uint16_t
+{
+    SUCCESS = 0,
+    INVALID_FIELD = 2,
+    LBA_OUT_OF_RANGE = 0x80,
+    READ_ERROR = 0x281
+};
+
+struct NvmeCqe
+{
+    uint16_t cid = 0;
+    uint16_t sqid = 0;
+    NvmeStatus status = NvmeStatus::SUCCESS;
+    uint64_t submit_ns = 0;   // doorbell 时刻
+    uint64_t complete_ns = 0; // NAND 完成时刻
+    vector<string> data;      // 读：各 LBA 的负载
+};
+
+class NvmeHost
+{
+public:
+    struct Stats
+    {
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t sq_full = 0;     // submit 时 SQ 已满
+        uint64_t cq_stalls = 0;   // 完成项因 CQ 满而推迟
+        uint64_t max_inflight = 0;
+    };
+
+    // FTL 切到异步模式；cmd_overhead_ns 为控制器固件处理每条命令的串行开销
+    explicit NvmeHost(FTL &ftl, uint64_t cmd_overhead_ns = 1000);
+    ~NvmeHost();
+
+    // 创建一个队列对，返回 qid；depth 为该队列最多同时在途的命令数
+    int create_queue_pair(int depth);
+    int queue_count() const { return (int)qps_.size(); }
+
+    // 主机侧：写入 SQE（不通知控制器）；SQ 满返回 false
+    bool submit(int qid, const NvmeCmd &cmd);
+    // SQ doorbell：控制器取走该 SQ 中新写入的命令并开始处理
+    void ring_sq_doorbell(int qid);
+    // 取 CQ 中已完成的项（最多 max 个），随即前移 CQ 头；返回个数
+    int poll(int qid, vector<NvmeCqe> &out, int max = INT_MAX);
+    // 该队列已提交、尚未被 poll 取走的命令数
+    int outstanding(int qid) const { return qps_[qid].outstanding; }
+
+    uint64_t now() const { return now_ns_; }
+    void advance_to(uint64_t t);
+    // 推进到最早的在途完成时刻；没有在途命令返回 false
+    bool wait_completion();
+    uint64_t inflight() const { return pending_.size() + stalled_.size(); }
+    const Stats &stats() const { return stats_; }
+
+private:
+    struct QueuePair
+    {
+        vector<NvmeCmd> sq;
+        vector<uint64_t> sq_time; // 各 SQE 写入时的主机时钟
+        int sq_head = 0, sq_tail = 0, sq_db = 0; // sq_db：最近一次 doorbell 写入的尾
+        vector<NvmeCqe> cq;
+        int cq_head = 0, cq_tail = 0;
+        int outstanding = 0;
+        int entries() const { return (int)sq.size(); }
+    };
+    struct Pending
+    {
+        uint64_t complete_ns;
+        uint64_t seq;
+        NvmeCqe cqe;
+        bool operator>(const Pending &o) const
+        {
+            return complete_ns != o.complete_ns ? complete_ns > o.complete_ns : seq > o.seq;
+        }
+    };
+
+    FTL &ftl_;
+    uint64_t overhead_ns_;
+    uint64_t now_ns_ = 0;
+    uint64_t ctrl_busy_ns_ = 0; // 控制器固件空闲时刻
+    uint64_t seq_ = 0;
+    size_t rr_ = 0; // 轮询仲裁起点
+    vector<QueuePair> qps_;
+    priority_queue<Pending, vector<Pending>, greater<Pending>> pending_;
+    deque<Pending> stalled_; // 到期但 CQ 已满
+    Stats stats_;
+
+    void fetch_commands();
+    NvmeCqe execute(const NvmeCmd &cmd, uint64_t dispatch_ns, uint64_t &complete_ns);
+    void post_completions();
+    bool post(Pending &p);
+};
+
+#endif // NVME_HOST_H
@@ -0,0 +1,123 @@
+#include "ftl.h"
+#include "logger.h"
+
+/* ---------------- file-backed 镜像 + 子页映射回归测试 ----------------
+   2x1x16x8 镜像、page_bytes=4096、每页 4 个扇区：
+   - 负载恰为 max_sector_bytes() 的扇区写满若干页，不得出现失败的 NAND 操作或判坏块，读回一致
+   - 超出预算的扇区（1 KiB，加上槽位头放不进 1/4 页）在 FTL::write 被拒绝，不下发 program、不判坏、原映射不变
+   - 同步镜像后重新打开、从 OOB 重建映射，读回一致
+   用法：pack_image_test [image_path]（默认在当前目录建 pack_image_test.img，结束时删除）
+   失败时输出原因并返回 1
+*/
+
+static int failures = 0;
+#define CHECK(cond, what)                                  \
+    do                                                     \
+    {                                                      \
+        if (!(cond))                                       \
+        {                                                  \
+            cerr << "FAIL: " << what << "\n";              \
+            failures++;                                    \
+        }                                                  \
+    } while (0)
+
+static const int kDies = 2, kPlanes = 1, kBlocks = 16, kPages = 8;
+static const int kPageBytes = 4096, kSpp = 4;
+static const int kReservedWrite = 1, kReservedSpare = 2;
+
+static string payload(int lba, int gen, int bytes)
+{
+    string s = "L" + to_string(lba) + "." + to_string(gen) + ".";
+    s.resize(bytes, (char)('a' + (lba + gen) % 26));
+    return s;
+}
+
+static int bad_blocks(const NandRuntime &rt)
+{
+    int n = 0;
+    for (int d = 0; d < kDies; ++d)
+        for (int p = 0; p < kPlanes; ++p)
+            for (int b = 0; b < kBlocks; ++b)
+                n += rt.bad_block_table[rt.idx(d, p, b)] ? 1 : 0;
+    return n;
+}
+
+static void remove_image(const string &path)
+{
+    for (const char *ext : {"", ".rt", ".sys", ".sys.jnl"})
+        remove((path + ext).c_str());
+}
+
+int main(int argc, char **argv)
+{
+    string path = argc > 1 ? argv[1] : "pack_image_test.img";
+    Logger::set_level(LogLevel::OFF);
+    remove_image(path);
+    int lbas = (kBlocks - kReservedWrite - kReservedSpare) * kPages * kPlanes * kDies * kSpp / 2;
+    map<int, string> expect;
+
+    {
+        NandModel model(kDies, kPlanes, kBlocks, kPages, path, kPageBytes);
+        CHECK(model.ok(), "create image");
+        if (!model.ok())
+            return 1;
+        NandRuntime runtime(kDies, kPlanes, kBlocks);
+        NandDriver driver(model, runtime);
+        BlockManager bm(driver, runtime, kReservedWrite, kReservedSpare);
+        FTL ftl(driver, runtime, bm, lbas, kSpp);
+        int budget = ftl.max_sector_bytes();
+        CHECK(budget == kPageBytes / kSpp - FTL::kPackSlotHeaderBytes, "sector budget " << budget);
+
+        // 满预算的扇区：覆盖写两轮，打包页正好放满镜像页
+        for (int gen = 0; gen < 2; ++gen)
+            for (int l = 0; l < lbas; ++l)
+            {
+                expect[l] = payload(l, gen, budget);
+                ftl.write(l, expect[l]);
+            }
+        ftl.flush_pack();
+        CHECK(driver.get_stats().failed_ops == 0, "failed_ops=" << driver.get_stats().failed_ops);
+        CHECK(bad_blocks(runtime) == 0, "bad blocks=" << bad_blocks(runtime));
+
+        // 超出预算：拒绝，不碰 NAND
+        uint64_t programs = driver.get_stats().program_ops;
+        for (int l = 0; l < 8; ++l)
+            ftl.write(l, string(1024, 'X'));
+        ftl.flush_pack();
+        CHECK(driver.get_stats().program_ops == programs, "oversized sectors were programmed");
+        CHECK(driver.get_stats().failed_ops == 0, "oversized: failed_ops=" << driver.get_stats().failed_ops);
+        CHECK(bad_blocks(runtime) == 0, "oversized: bad blocks=" << bad_blocks(runtime));
+
+        string out;
+        for (auto &[l, data] : expect)
+            CHECK(ftl.read_lba(l, out) && out == data, "read back LBA " << l);
+
+        model.sync();
+        runtime.save(path + ".rt");
+        bm.save_system_area(path + ".sys");
+    }
+
+    // 重新打开：映射从镜像重建
+    {
+        NandModel model(kDies, kPlanes, kBlocks, kPages, path, kPageBytes);
+        CHECK(model.ok() && model.reopened(), "reopen image");
+        if (!model.ok())
+            return 1;
+        NandRuntime runtime(kDies, kPlanes, kBlocks);
+        CHECK(runtime.load(path + ".rt"), "load runtime");
+        NandDriver driver(model, runtime);
+        BlockManager bm(driver, runtime, kReservedWrite, kReservedSpare);
+        CHECK(bm.load_system_area(path + ".sys"), "load system area");
+        FTL ftl(driver, runtime, bm, lbas, kSpp);
+        ftl.rebuild_from_oob();
+        string out;
+        for (auto &[l, data] : expect)
+            CHECK(ftl.read_lba(l, out) && out == data, "reopened: read back LBA " << l);
+        CHECK(bad_blocks(runtime) == 0, "reopened: bad blocks=" << bad_blocks(runtime));
+    }
+
+    if (argc <= 1)
+        remove_image(path);
+    cout << (failures ? "pack_image_test: FAILED\n" : "pack_image_test: ok\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+#include "parallel_sim.h"
+#include "logger.h"
+
+static uint64_t mix(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h * 1099511628211ull;
+}
+
+static void summarize(vector<uint64_t> &v, double &avg, double &p99)
+{
+    if (v.empty())
+        return;
+    double sum = 0;
+    for (uint64_t x : v)
+        sum += x;
+    avg = sum / v.size() / 1000.0;
+    size_t k = min(v.size() - 1, (size_t)(0.99 * (v.size() - 1)));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    p99 = v[k] / 1000.0;
+}
+
+ParallelSim::ParallelSim(const Params &p) : p_(p)
+{
+    if (p_.partitions < 1 || p_.dies % p_.partitions != 0 || p_.stripe_lbas < 1 ||
+        (p_.closed_loop && (p_.host_ns == 0 || p_.qd < 1)) || (!p_.closed_loop && (p_.iops <= 0 || p_.window_ns == 0)))
+    {
+        LOG_ERROR("[PSIM] bad params: dies=" << p_.dies << " partitions=" << p_.partitions);
+        ok_ = false;
+        return;
+    }
+    int dpp = p_.dies / p_.partitions;
+    int writable = (p_.blocks - p_.reserved_write - p_.reserved_spare) * p_.pages * p_.planes * dpp;
+    lbas_per_part_ = (int)(writable * p_.user_ratio) / p_.stripe_lbas * p_.stripe_lbas;
+    if (lbas_per_part_ <= 0)
+    {
+        LOG_ERROR("[PSIM] no user capacity per partition");
+        ok_ = false;
+        return;
+    }
+    for (int i = 0; i < p_.partitions; ++i)
+    {
+        auto pt = make_unique<Partition>();
+        pt->model = make_unique<NandModel>(dpp, p_.planes, p_.blocks, p_.pages);
+        pt->runtime = make_unique<NandRuntime>(dpp, p_.planes, p_.blocks);
+        pt->driver = make_unique<NandDriver>(*pt->model, *pt->runtime);
+        pt->bm = make_unique<BlockManager>(*pt->driver, *pt->runtime, p_.reserved_write, p_.reserved_spare);
+        pt->ftl = make_unique<FTL>(*pt->driver, *pt->runtime, *pt->bm, lbas_per_part_);
+        parts_.push_back(move(pt));
+    }
+    threads_ = max(1, min(p_.threads, p_.partitions));
+    for (int k = 1; k < threads_; ++k)
+        pool_.emplace_back([this, k] { worker(k); });
+}
+
+ParallelSim::~ParallelSim()
+{
+    {
+        lock_guard<mutex> lk(mtx_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &th : pool_)
+        th.join();
+}
+
+void ParallelSim::run_share(int k)
+{
+    for (size_t i = k; i < parts_.size(); i += threads_)
+        job_(*parts_[i]);
+}
+
+void ParallelSim::worker(int k)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        unique_lock<mutex> lk(mtx_);
+        start_cv_.wait(lk, [&] { return stop_ || job_id_ != seen; });
+        if (stop_)
+            return;
+        seen = job_id_;
+        lk.unlock();
+        run_share(k);
+        lk.lock();
+        if (--pending_ == 0)
+            done_cv_.notify_one();
+    }
+}
+
+void ParallelSim::run_parallel(function<void(Partition &)> job)
+{
+    job_ = move(job);
+    if (threads_ == 1)
+    {
+        run_share(0);
+        return;
+    }
+    {
+        lock_guard<mutex> lk(mtx_);
+        pending_ = threads_ - 1;
+        job_id_++;
+    }
+    start_cv_.notify_all();
+    run_share(0);
+    unique_lock<mutex> lk(mtx_);
+    done_cv_.wait(lk, [&] { return pending_ == 0; });
+}
+
+pair<int, int> ParallelSim::route(int lba) const
+{
+    int chunk = lba / p_.stripe_lbas;
+    return {chunk % p_.partitions, chunk / p_.partitions * p_.stripe_lbas + lba % p_.stripe_lbas};
+}
+
+ParallelSim::Cmd ParallelSim::make_cmd(mt19937 &rng, uint64_t t, uint64_t a, uint64_t b, int slot, int &part) const
+{
+    Cmd c{t, a, b, false, 0, slot};
+    c.is_write = (int)(rng() % 100) >= p_.read_pct;
+    tie(part, c.lba) = route(rng() % lbas());
+    return c;
+}
+
+void ParallelSim::prefill()
+{
+    if (!ok_)
+        return;
+    run_parallel([this](Partition &pt)
+                 {
+                     for (int l = 0; l < lbas_per_part_; ++l)
+                         pt.ftl->write(l, "D" + to_string(l));
+                     pt.ftl->set_write_buffer(p_.write_buffer);
+                     pt.ftl->set_host_async(true);
+                     pt.fw_free = pt.last_done = pt.ftl->now_ns();
+                 });
+}
+
+// 一条命令：固件串行取命令（每条 cmd_overhead_ns）后下发给本分区的 FTL，完成时刻由 NAND 时序决定
+void ParallelSim::process(Partition &pt, const Cmd &c)
+{
+    uint64_t t = max(c.t, pt.fw_free) + p_.cmd_overhead_ns;
+    pt.fw_free = t;
+    FTL &ftl = *pt.ftl;
+    ftl.advance_to(t);
+    uint64_t h = 0;
+    if (c.is_write)
+        ftl.write(c.lba, "W" + to_string(c.a) + "." + to_string(c.b));
+    else
+    {
+        string out;
+        if (ftl.read_lba(c.lba, out))
+            h = hash<string>()(out);
+    }
+    uint64_t done = max(t, ftl.host_complete_ns());
+    pt.last_done = max(pt.last_done, done);
+    (c.is_write ? pt.write_lat : pt.read_lat).push_back(done - c.t);
+    pt.digest = mix(mix(mix(pt.digest, c.t), done), h);
+
+    if (c.slot < 0)
+        return;
+    // 闭环：该槽位的下一条命令在 done + host_ns 到达，最早也在本窗口之后
+    Slot &s = slots_[c.slot];
+    if (s.left <= 0)
+        return;
+    s.left--;
+    int part = 0;
+    Cmd next = make_cmd(s.rng, done + p_.host_ns, ++s.seq, c.slot, c.slot, part);
+    pt.outbox.push_back({part, next});
+}
+
+void ParallelSim::drain(Partition &pt)
+{
+    while (!pt.q.empty() && pt.q.top().t < horizon_)
+    {
+        Cmd c = pt.q.top();
+        pt.q.pop();
+        process(pt, c);
+    }
+}
+
+ParallelSim::Result ParallelSim::run()
+{
+    Result r;
+    if (!ok_)
+        return r;
+    uint64_t t0 = 0;
+    for (auto &pt : parts_)
+    {
+        t0 = max(t0, pt->ftl->now_ns());
+        pt->programs0 = pt->driver->get_stats().program_ops;
+        pt->gc0 = pt->ftl->gc_stats().runs;
+        pt->digest = 1469598103934665603ull;
+        pt->read_lat.clear();
+        pt->write_lat.clear();
+    }
+
+    // 主机：闭环各槽位在 t0 同时下发第一条；开环按泊松过程逐条生成
+    mt19937 host_rng(p_.seed);
+    exponential_distribution<double> gap(p_.iops / 1e9);
+    double next_arrival = t0 + gap(host_rng);
+    long issued = 0;
+    if (p_.closed_loop)
+    {
+        slots_.clear();
+        int qd = (int)min<long>(p_.qd, max(1L, p_.ops));
+        for (int s = 0; s < qd; ++s)
+        {
+            Slot sl;
+            sl.rng.seed(p_.seed * 1000003u + s);
+            sl.left = p_.ops / qd + (s < p_.ops % qd ? 1 : 0) - 1;
+            slots_.push_back(move(sl));
+            int part = 0;
+            Cmd c = make_cmd(slots_[s].rng, t0, 0, s, s, part);
+            parts_[part]->q.push(c);
+        }
+    }
+
+    while (true)
+    {
+        // 闭环窗口：分区里最早的命令最早在 max(到达, 固件空闲) + cmd_overhead 完成，它引出的下一条再晚 host_ns
+        uint64_t first = UINT64_MAX, bound = UINT64_MAX;
+        for (auto &pt : parts_)
+            if (!pt->q.empty())
+            {
+                first = min(first, pt->q.top().t);
+                bound = min(bound, max(pt->q.top().t, pt->fw_free) + p_.cmd_overhead_ns + p_.host_ns);
+            }
+        if (!p_.closed_loop && issued < p_.ops)
+            first = min(first, (uint64_t)next_arrival);
+        if (first == UINT64_MAX)
+            break;
+        horizon_ = p_.closed_loop ? bound : first + p_.window_ns;
+        // 开环：窗口内的到达全部投递后再放行
+        while (!p_.closed_loop && issued < p_.ops && (uint64_t)next_arrival < horizon_)
+        {
+            int part = 0;
+            Cmd c = make_cmd(host_rng, (uint64_t)next_arrival, (uint64_t)issued, 0, -1, part);
+            parts_[part]->q.push(c);
+            issued++;
+            next_arrival += gap(host_rng);
+        }
+        // 窗口内只有一个分区有事可做时不唤醒线程池
+        int busy = 0;
+        for (auto &pt : parts_)
+            busy += !pt->q.empty() && pt->q.top().t < horizon_;
+        if (busy > 1)
+            run_parallel([this](Partition &pt) { drain(pt); });
+        else
+            for (auto &pt : parts_)
+                drain(*pt);
+        r.rounds++;
+        for (auto &pt : parts_)
+        {
+            for (auto &[dst, c] : pt->outbox)
+                parts_[dst]->q.push(c);
+            pt->outbox.clear();
+        }
+    }
+
+    vector<uint64_t> rd, wr;
+    uint64_t programs = 0;
+    r.digest = 1469598103934665603ull;
+    for (auto &pt : parts_)
+    {
+        rd.insert(rd.end(), pt->read_lat.begin(), pt->read_lat.end());
+        wr.insert(wr.end(), pt->write_lat.begin(), pt->write_lat.end());
+        programs += pt->driver->get_stats().program_ops - pt->programs0;
+        r.gc_runs += pt->ftl->gc_stats().runs - pt->gc0;
+        r.sim_ns = max(r.sim_ns, pt->last_done - min(pt->last_done, t0));
+        r.digest = mix(r.digest, pt->digest);
+    }
+    r.reads = rd.size();
+    r.writes = wr.size();
+    summarize(rd, r.read_avg_us, r.read_p99_us);
+    summarize(wr, r.write_avg_us, r.write_p99_us);
+    r.waf = r.writes ? (double)programs / r.writes : 0.0;
+    return r;
+}
+
+ParallelSim::Result ParallelSim::run_serial(const Params &p)
+{
+    Result r;
+    int writable = (p.blocks - p.reserved_write - p.reserved_spare) * p.pages * p.planes * p.dies;
+    int lbas = (int)(writable * p.user_ratio) / p.stripe_lbas * p.stripe_lbas;
+    if (lbas <= 0 || (p.closed_loop && (p.host_ns == 0 || p.qd < 1)) || (!p.closed_loop && p.iops <= 0))
+        return r;
+    NandModel model(p.dies, p.planes, p.blocks, p.pages);
+    NandRuntime runtime(p.dies, p.planes, p.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, p.reserved_write, p.reserved_spare);
+    FTL ftl(driver, runtime, bm, lbas);
+    for (int l = 0; l < lbas; ++l)
+        ftl.write(l, "D" + to_string(l));
+    ftl.set_write_buffer(p.write_buffer);
+    ftl.set_host_async(true);
+    uint64_t t0 = ftl.now_ns(), fw_free = t0, last_done = t0;
+    uint64_t programs0 = driver.get_stats().program_ops, gc0 = ftl.gc_stats().runs;
+
+    // 与 make_cmd 相同的随机数消耗顺序（整盘只有一个分区，LBA 不变换）
+    auto next_cmd = [&](mt19937 &rng, uint64_t t, uint64_t a, uint64_t b, int slot)
+    {
+        Cmd c{t, a, b, false, 0, slot};
+        c.is_write = (int)(rng() % 100) >= p.read_pct;
+        c.lba = rng() % lbas;
+        return c;
+    };
+    priority_queue<Cmd, vector<Cmd>, greater<Cmd>> q;
+    vector<Slot> slots;
+    if (p.closed_loop)
+    {
+        int qd = (int)min<long>(p.qd, max(1L, p.ops));
+        for (int s = 0; s < qd; ++s)
+        {
+            Slot sl;
+            sl.rng.seed(p.seed * 1000003u + s);
+            sl.left = p.ops / qd + (s < p.ops % qd ? 1 : 0) - 1;
+            slots.push_back(move(sl));
+            q.push(next_cmd(slots[s].rng, t0, 0, s, s));
+        }
+    }
+    else
+    {
+        // 开环到达与完成无关，一次生成全部
+        mt19937 host_rng(p.seed);
+        exponential_distribution<double> gap(p.iops / 1e9);
+        double arrival = t0 + gap(host_rng);
+        for (long i = 0; i < p.ops; ++i)
+        {
+            q.push(next_cmd(host_rng, (uint64_t)arrival, (uint64_t)i, 0, -1));
+            arrival += gap(host_rng);
+        }
+    }
+
+    uint64_t digest = 1469598103934665603ull;
+    vector<uint64_t> rd, wr;
+    while (!q.empty())
+    {
+        Cmd c = q.top();
+        q.pop();
+        uint64_t t = max(c.t, fw_free) + p.cmd_overhead_ns;
+        fw_free = t;
+        ftl.advance_to(t);
+        uint64_t h = 0;
+        if (c.is_write)
+            ftl.write(c.lba, "W" + to_string(c.a) + "." + to_string(c.b));
+        else
+        {
+            string out;
+            if (ftl.read_lba(c.lba, out))
+                h = hash<string>()(out);
+        }
+        uint64_t done = max(t, ftl.host_complete_ns());
+        last_done = max(last_done, done);
+        (c.is_write ? wr : rd).push_back(done - c.t);
+        digest = mix(mix(mix(digest, c.t), done), h);
+        if (c.slot >= 0 && slots[c.slot].left > 0)
+        {
+            Slot &s = slots[c.slot];
+            s.left--;
+            q.push(next_cmd(s.rng, done + p.host_ns, ++s.seq, c.slot, c.slot));
+        }
+    }
+
+    r.digest = mix(1469598103934665603ull, digest);
+    r.gc_runs = ftl.gc_stats().runs - gc0;
+    r.sim_ns = last_done - t0;
+    r.reads = rd.size();
+    r.writes = wr.size();
+    summarize(rd, r.read_avg_us, r.read_p99_us);
+    summarize(wr, r.write_avg_us, r.write_p99_us);
+    r.waf = r.writes ? (double)(driver.get_stats().program_ops - programs0) / r.writes : 0.0;
+    return r;
+}
@@ -0,0 +1,137 @@
+#ifndef PARALLEL_SIM_H
+#define PARALLEL_SIM_H
+
+#include <bits/stdc++.h>
+#include "ftl.h"
+using namespace std;
+
+/* ---------------- ParallelSim：按 die 分区的并行仿真 ----------------
+   - die 按连续区间分成 P 个分区，每个分区一套 NandModel/NandRuntime/NandDriver/BlockManager/FTL（异步模式），
+     相当于每个 FTL 核独占几个 die：超级块只跨分区内的 lane，GC 的源与目的都在分区内，不产生跨分区交互
+   - 主机 LBA 以 stripe_lbas 为粒度轮转到各分区；每个分区有自己的事件队列（按到达时刻排序）与固件时钟
+   - 分区间唯一的交互是主机下发：
+     开环：到达序列与完成无关，主机是源头，每轮按 window_ns 推进；
+     闭环：qd 个主机槽位，每个槽位一条命令完成后隔 host_ns 下发下一条，目标分区由该槽位自己的随机序列决定
+   - 保守同步（按窗口推进）：每轮定一个时刻 H，H 之前到达各分区的命令都已投递，各分区在工作线程上并行处理到 H。
+     开环 H = 最早事件 + window_ns；闭环 H = 各分区 max(最早到达, 固件空闲) + cmd_overhead_ns + host_ns 的最小值
+     （命令最早在固件取走后完成，引出的下一条再晚 host_ns）。窗口内新产生的命令进本分区发件箱，屏障后由主线程投递；
+     闭环窗口小，每轮可并行的命令约为 qd × host_ns / 平均延迟
+   - 事件按 (时刻, 键) 全序处理，与线程数、线程调度无关：同一种子、同一分区数，结果与 digest 逐位相同
+   - 分区数 > 1 时仿真的是另一台设备（更窄的超级块、GC 限在分区内），WAF 与延迟不能与整盘的串行仿真对比；
+     分区数 = 1 时应与串行仿真逐位相同，run_serial 是对照用的参考实现
+*/
+class ParallelSim
+{
+public:
+    struct Params
+    {
+        int dies = 8, planes = 2, blocks = 64, pages = 32;
+        int partitions = 4; // 须整除 dies
+        int threads = 1;    // 工作线程数（含主线程），超过分区数时按分区数
+        int reserved_write = 1, reserved_spare = 2;
+        double user_ratio = 0.85;
+        int write_buffer = 16;
+        uint64_t cmd_overhead_ns = 1000; // 每个分区固件处理一条命令的串行开销
+        int stripe_lbas = 1;             // 主机 LBA 轮转到分区的粒度
+        bool closed_loop = false;
+        int qd = 64;                   // 闭环：主机槽位数
+        uint64_t host_ns = 10000;      // 闭环：完成到下一条下发的主机开销（即 lookahead，须 > 0）
+        double iops = 10000;           // 开环：泊松到达的平均速率
+        uint64_t window_ns = 10000000; // 开环：每轮推进的仿真时间
+        long ops = 200000;
+        int read_pct = 70;
+        uint32_t seed = 1;
+    };
+
+    struct Result
+    {
+        uint64_t reads = 0, writes = 0;
+        double read_avg_us = 0, read_p99_us = 0;
+        double write_avg_us = 0, write_p99_us = 0;
+        uint64_t sim_ns = 0; // 最后一条命令的完成时刻
+        double waf = 0;
+        uint64_t gc_runs = 0;
+        uint64_t rounds = 0; // 同步轮数
+        uint64_t digest = 0; // 各分区按处理顺序累积的 (到达, 完成, 读出负载)
+    };
+
+    explicit ParallelSim(const Params &p);
+    ~ParallelSim();
+    ParallelSim(const ParallelSim &) = delete;
+    ParallelSim &operator=(const ParallelSim &) = delete;
+
+    // 参数不合法（分区数不整除 die、闭环 host_ns 为 0 等）时为 false
+    bool ok() const { return ok_; }
+    int lbas() const { return lbas_per_part_ * (int)parts_.size(); }
+    int partition_count() const { return (int)parts_.size(); }
+    int thread_count() const { return threads_; }
+    FTL &partition_ftl(int i) { return *parts_[i]->ftl; }
+
+    // 各分区顺序写满自己的 LBA（并行，不计入统计），随后切到异步模式
+    void prefill();
+    Result run();
+    // 参考实现：整盘一套 NAND/FTL，同样的预写满与主机序列，单个事件队列逐条处理，不分区、不按窗口同步。
+    // 忽略 partitions / threads / window_ns；与 partitions = 1 的 run() 结果与 digest 应逐位相同
+    static Result run_serial(const Params &p);
+
+private:
+    struct Cmd
+    {
+        uint64_t t;     // 到达分区的时刻
+        uint64_t a, b;  // 同一时刻的全序键：开环 (到达序号, 0)，闭环 (槽位序号, 槽位)
+        bool is_write;
+        int lba;        // 分区内 LBA
+        int slot;       // 闭环槽位（开环 -1）
+        bool operator>(const Cmd &o) const { return tie(t, a, b) > tie(o.t, o.a, o.b); }
+    };
+    struct Slot
+    {
+        mt19937 rng;
+        long left = 0;
+        uint64_t seq = 0;
+    };
+    struct Partition
+    {
+        unique_ptr<NandModel> model;
+        unique_ptr<NandRuntime> runtime;
+        unique_ptr<NandDriver> driver;
+        unique_ptr<BlockManager> bm;
+        unique_ptr<FTL> ftl;
+        priority_queue<Cmd, vector<Cmd>, greater<Cmd>> q;
+        vector<pair<int, Cmd>> outbox; // (目标分区, 命令)
+        uint64_t fw_free = 0;
+        uint64_t last_done = 0;
+        uint64_t digest = 1469598103934665603ull;
+        vector<uint64_t> read_lat, write_lat;
+        uint64_t programs0 = 0, gc0 = 0;
+    };
+
+    Params p_;
+    bool ok_ = true;
+    int lbas_per_part_ = 0;
+    int threads_ = 1;
+    vector<unique_ptr<Partition>> parts_;
+    vector<Slot> slots_;
+    uint64_t horizon_ = 0;
+
+    // 工作线程池：主线程发布一项任务，各线程处理 k, k + threads, ... 号分区，全部完成后返回
+    vector<thread> pool_;
+    mutex mtx_;
+    condition_variable start_cv_, done_cv_;
+    uint64_t job_id_ = 0;
+    int pending_ = 0;
+    bool stop_ = false;
+    function<void(Partition &)> job_;
+
+    void worker(int k);
+    void run_parallel(function<void(Partition &)> job);
+    void run_share(int k);
+
+    // 全局 LBA -> (分区, 分区内 LBA)
+    pair<int, int> route(int lba) const;
+    Cmd make_cmd(mt19937 &rng, uint64_t t, uint64_t a, uint64_t b, int slot, int &part) const;
+    void drain(Partition &pt);
+    void process(Partition &pt, const Cmd &c);
+};
+
+#endif // PARALLEL_SIM_H
@@ -0,0 +1,141 @@
+#include "parallel_sim.h"
+#include "logger.h"
+
+/* ---------------- 分区并行仿真 benchmark ----------------
+   同一配置（几何、分区数、负载、种子）按 --threads 列出的线程数各跑一遍，每次一套新的 ParallelSim（预写满不计入仿真统计），
+   输出仿真结果、同步轮数与墙钟时间；各线程数的 digest 必须相同（确定性），墙钟时间给出加速比。
+   随后用同一负载跑 partitions = 1 与整盘串行 FTL（ParallelSim::run_serial）做等价检查，二者 digest 必须相同。
+   分区数 > 1 时每个分区是独立的 FTL（超级块更窄、GC 限在分区内），仿真的是另一台设备：其 WAF 与延迟
+   不能与串行行对比，只有墙钟时间可比。硬件线程数少于所测线程数时加速比没有意义（只测得调度开销）。
+   用法：psim_bench [--dies N] [--planes N] [--blocks N] [--pages N] [--partitions N] [--threads L]
+                   [--closed] [--qd N] [--host-ns NS] [--iops R] [--window-us US] [--stripe N]
+                   [--ops N] [--read-pct PCT] [--seed S]
+   --threads：逗号分隔的线程数列表（默认 1,2,4,...,分区数）
+   默认开环（泊松到达，--iops）；--closed 为闭环，--qd 个主机槽位，--host-ns 为完成到下一条下发的间隔，
+   也是同步窗口：窗口越小每轮可并行的事件越少
+*/
+
+int main(int argc, char **argv)
+{
+    ParallelSim::Params p;
+    p.dies = 16;
+    p.blocks = 128;
+    p.partitions = 8;
+    p.iops = 15000;
+    vector<int> threads;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--dies" && i + 1 < argc)
+            p.dies = stoi(argv[++i]);
+        else if (arg == "--planes" && i + 1 < argc)
+            p.planes = stoi(argv[++i]);
+        else if (arg == "--blocks" && i + 1 < argc)
+            p.blocks = stoi(argv[++i]);
+        else if (arg == "--pages" && i + 1 < argc)
+            p.pages = stoi(argv[++i]);
+        else if (arg == "--partitions" && i + 1 < argc)
+            p.partitions = stoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            stringstream ss(argv[++i]);
+            string tok;
+            while (getline(ss, tok, ','))
+                threads.push_back(max(1, stoi(tok)));
+        }
+        else if (arg == "--closed")
+            p.closed_loop = true;
+        else if (arg == "--qd" && i + 1 < argc)
+            p.qd = stoi(argv[++i]);
+        else if (arg == "--host-ns" && i + 1 < argc)
+            p.host_ns = stoull(argv[++i]);
+        else if (arg == "--iops" && i + 1 < argc)
+            p.iops = stod(argv[++i]);
+        else if (arg == "--window-us" && i + 1 < argc)
+            p.window_ns = (uint64_t)(stod(argv[++i]) * 1000);
+        else if (arg == "--stripe" && i + 1 < argc)
+            p.stripe_lbas = stoi(argv[++i]);
+        else if (arg == "--ops" && i + 1 < argc)
+            p.ops = max(1L, stol(argv[++i]));
+        else if (arg == "--read-pct" && i + 1 < argc)
+            p.read_pct = min(100, max(0, stoi(argv[++i])));
+        else if (arg == "--seed" && i + 1 < argc)
+            p.seed = (uint32_t)stoul(argv[++i]);
+        else
+        {
+            cerr << "usage: psim_bench [--dies N] [--planes N] [--blocks N] [--pages N] [--partitions N] [--threads L]"
+                    " [--closed] [--qd N] [--host-ns NS] [--iops R] [--window-us US] [--stripe N]"
+                    " [--ops N] [--read-pct PCT] [--seed S]\n";
+            return 1;
+        }
+    }
+    if (threads.empty())
+        for (int t = 1; t <= p.partitions; t *= 2)
+            threads.push_back(t);
+    Logger::set_level(LogLevel::OFF);
+
+    cout << "geometry " << p.dies << "x" << p.planes << "x" << p.blocks << "x" << p.pages << " partitions="
+         << p.partitions << " " << (p.closed_loop ? "closed qd=" + to_string(p.qd) : "open") << " ops=" << p.ops
+         << " read_pct=" << p.read_pct << " hw_threads=" << thread::hardware_concurrency() << "\n";
+    auto print_sim = [](const char *tag, const ParallelSim::Result &r)
+    {
+        cout << tag << fixed << setprecision(1) << "reads=" << r.reads << " avg=" << r.read_avg_us << "us p99="
+             << r.read_p99_us << "us  writes=" << r.writes << " avg=" << r.write_avg_us << "us p99=" << r.write_p99_us
+             << "us  kiops=" << (r.reads + r.writes) * 1e6 / max<uint64_t>(1, r.sim_ns) << setprecision(2)
+             << "  waf=" << r.waf << "  gc_runs=" << r.gc_runs;
+        if (r.rounds)
+            cout << "  rounds=" << r.rounds << setprecision(1)
+                 << "  events/round=" << (double)(r.reads + r.writes) / r.rounds;
+        cout << defaultfloat << "\n";
+    };
+    double base_wall = 0;
+    uint64_t base_digest = 0;
+    bool same = true;
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        p.threads = threads[i];
+        ParallelSim sim(p);
+        if (!sim.ok())
+        {
+            cerr << "bad geometry / partition parameters\n";
+            return 1;
+        }
+        auto w0 = chrono::steady_clock::now();
+        sim.prefill();
+        auto w1 = chrono::steady_clock::now();
+        ParallelSim::Result r = sim.run();
+        auto w2 = chrono::steady_clock::now();
+        double prefill_s = chrono::duration<double>(w1 - w0).count();
+        double wall = chrono::duration<double>(w2 - w1).count();
+        if (i == 0)
+        {
+            base_wall = wall;
+            base_digest = r.digest;
+            print_sim("sim: ", r);
+        }
+        same = same && r.digest == base_digest;
+        cout << "threads=" << setw(2) << sim.thread_count() << fixed << setprecision(3) << "  prefill=" << prefill_s
+             << "s  run=" << wall << "s  speedup=" << setprecision(2) << base_wall / max(1e-9, wall) << "  digest=" << hex
+             << r.digest << dec << (r.digest == base_digest ? "" : "  MISMATCH") << defaultfloat << "\n";
+    }
+    unsigned hw = thread::hardware_concurrency();
+    if (hw < (unsigned)*max_element(threads.begin(), threads.end()))
+        cout << "speedup not measured: " << hw << " hardware thread(s), extra threads only add scheduling overhead\n";
+
+    // 等价检查：分区数为 1 时按窗口同步的 ParallelSim 与整盘串行 FTL 逐位相同
+    ParallelSim::Params q = p;
+    q.partitions = 1;
+    q.threads = 1;
+    ParallelSim one(q);
+    one.prefill();
+    ParallelSim::Result r1 = one.run();
+    ParallelSim::Result rs = ParallelSim::run_serial(q);
+    bool equiv = r1.digest == rs.digest && r1.reads == rs.reads && r1.writes == rs.writes && r1.waf == rs.waf;
+    print_sim("serial FTL (whole device): ", rs);
+    if (p.partitions > 1)
+        cout << "note: partitions=" << p.partitions << " simulates " << p.partitions
+             << " independent FTLs; its waf / latency above are not comparable to the serial FTL\n";
+    cout << "equivalence partitions=1 vs serial FTL: digest=" << hex << r1.digest << " / " << rs.digest << dec
+         << (equiv ? "  ok" : "  MISMATCH") << "\n";
+    return same && equiv ? 0 : 2;
+}
@@ -0,0 +1,168 @@
+#include "nvme_host.h"
+#include "logger.h"
+
+/* ---------------- 队列深度 benchmark ----------------
+   经 NvmeHost 的 SQ/CQ 队列对驱动 FTL，闭环：每个队列始终保持 QD/queues 条在途命令，
+   一条完成立刻补一条。QD 取 1,2,4,...,max-qd，每个点用一套新的 NAND/FTL（顺序预写满，不计入统计），
+   输出吞吐（IOPS）与延迟（doorbell -> CQE 可取），可直接画吞吐-延迟曲线。
+   用法：qd_bench [--queues N] [--ops N] [--read-pct PCT] [--max-qd N] [--overhead-ns NS]
+                 [--dies N] [--seed S] [--csv]
+   读写 LBA 均匀随机；吞吐在 QD 足以占满所有 die 后饱和，之后延迟随 QD 线性增长
+*/
+
+struct QdConfig
+{
+    int dies = 4, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85;
+    int queues = 4;
+    int ops = 20000;    // 每个 QD 点完成的命令数
+    int read_pct = 70;
+    int max_qd = 256;
+    uint64_t overhead_ns = 1000;
+    uint32_t seed = 1;
+    bool csv = false;
+};
+
+struct QdResult
+{
+    double iops = 0;
+    double avg_us = 0, p50_us = 0, p99_us = 0;
+    uint64_t max_inflight = 0;
+};
+
+static double pct(vector<uint64_t> &v, double p)
+{
+    if (v.empty())
+        return 0;
+    size_t k = min(v.size() - 1, (size_t)(p * (v.size() - 1)));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1000.0;
+}
+
+static QdResult run(const QdConfig &c, int qd)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    int lbas = (int)(writable * c.user_ratio);
+    FTL ftl(driver, runtime, bm, lbas);
+    ftl.set_gc_free_watermark(2);
+    for (int l = 0; l < lbas; ++l)
+        ftl.write(l, "P");
+
+    NvmeHost host(ftl, c.overhead_ns);
+    int queues = max(1, min(c.queues, qd));
+    vector<int> depth(queues, qd / queues);
+    for (int q = 0; q < qd % queues; ++q)
+        depth[q]++;
+    for (int q = 0; q < queues; ++q)
+        host.create_queue_pair(depth[q]);
+
+    mt19937 rng(c.seed);
+    uint16_t cid = 0;
+    int issued = 0, done = 0;
+    auto refill = [&](int q) {
+        bool any = false;
+        while (issued < c.ops && host.outstanding(q) < depth[q])
+        {
+            NvmeCmd cmd;
+            cmd.cid = cid++;
+            cmd.slba = rng() % lbas;
+            cmd.opcode = (int)(rng() % 100) < c.read_pct ? NvmeOpcode::READ : NvmeOpcode::WRITE;
+            if (cmd.opcode == NvmeOpcode::WRITE)
+                cmd.data = "W";
+            if (!host.submit(q, cmd))
+                break;
+            issued++;
+            any = true;
+        }
+        if (any)
+            host.ring_sq_doorbell(q);
+    };
+
+    uint64_t t0 = host.now();
+    vector<uint64_t> lat;
+    lat.reserve(c.ops);
+    for (int q = 0; q < queues; ++q)
+        refill(q);
+    vector<NvmeCqe> cqes;
+    while (done < c.ops)
+    {
+        if (!host.wait_completion())
+            break;
+        for (int q = 0; q < queues; ++q)
+        {
+            cqes.clear();
+            host.poll(q, cqes);
+            for (auto &e : cqes)
+                lat.push_back(host.now() - e.submit_ns);
+            done += (int)cqes.size();
+            refill(q);
+        }
+    }
+
+    QdResult r;
+    double secs = (host.now() - t0) / 1e9;
+    r.iops = secs > 0 ? done / secs : 0;
+    double sum = 0;
+    for (uint64_t v : lat)
+        sum += v;
+    r.avg_us = lat.empty() ? 0 : sum / lat.size() / 1000.0;
+    r.p50_us = pct(lat, 0.50);
+    r.p99_us = pct(lat, 0.99);
+    r.max_inflight = host.stats().max_inflight;
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    QdConfig cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--queues" && i + 1 < argc)
+            cfg.queues = max(1, stoi(argv[++i]));
+        else if (arg == "--ops" && i + 1 < argc)
+            cfg.ops = max(1, stoi(argv[++i]));
+        else if (arg == "--read-pct" && i + 1 < argc)
+            cfg.read_pct = min(100, max(0, stoi(argv[++i])));
+        else if (arg == "--max-qd" && i + 1 < argc)
+            cfg.max_qd = max(1, stoi(argv[++i]));
+        else if (arg == "--overhead-ns" && i + 1 < argc)
+            cfg.overhead_ns = stoull(argv[++i]);
+        else if (arg == "--dies" && i + 1 < argc)
+            cfg.dies = max(1, stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--csv")
+            cfg.csv = true;
+        else
+        {
+            cerr << "usage: qd_bench [--queues N] [--ops N] [--read-pct PCT] [--max-qd N] [--overhead-ns NS]"
+                    " [--dies N] [--seed S] [--csv]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    if (cfg.csv)
+        cout << "qd,iops,avg_us,p50_us,p99_us,max_inflight\n";
+    else
+        cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+             << " queues=" << cfg.queues << " ops=" << cfg.ops << " read_pct=" << cfg.read_pct
+             << " overhead=" << cfg.overhead_ns << "ns\n";
+    for (int qd = 1; qd <= cfg.max_qd; qd *= 2)
+    {
+        QdResult r = run(cfg, qd);
+        if (cfg.csv)
+            cout << qd << "," << fixed << setprecision(1) << r.iops << "," << r.avg_us << "," << r.p50_us << ","
+                 << r.p99_us << "," << r.max_inflight << "\n";
+        else
+            cout << "qd=" << setw(3) << qd << fixed << setprecision(1) << "  iops=" << setw(9) << r.iops
+                 << "  avg=" << setw(8) << r.avg_us << "us  p50=" << setw(8) << r.p50_us
+                 << "us  p99=" << setw(8) << r.p99_us << "us  inflight=" << r.max_inflight << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "read_cache.h"
+#include "mem_account.h"
+
+void ReadCache::set_capacity(size_t n)
+{
+    cap_ = n;
+    small_cap_ = n ? max<size_t>(1, n / 10) : 0;
+    clear();
+}
+
+void ReadCache::clear()
+{
+    map_.clear();
+    small_.clear();
+    main_.clear();
+    ghost_.clear();
+    ghost_map_.clear();
+    small_n_ = main_n_ = 0;
+}
+
+const string *ReadCache::get(int lba)
+{
+    if (!cap_)
+        return nullptr;
+    stats_.lookups++;
+    auto it = map_.find(lba);
+    if (it == map_.end())
+        return nullptr;
+    stats_.hits++;
+    if (it->second.freq < 3)
+        it->second.freq++;
+    return &it->second.data;
+}
+
+void ReadCache::put(int lba, const string &data)
+{
+    if (!cap_)
+        return;
+    MemScope scope(MemComponent::READ_CACHE);
+    auto it = map_.find(lba);
+    if (it != map_.end())
+    {
+        it->second.data = data;
+        return;
+    }
+    while (map_.size() >= cap_)
+        evict();
+    Entry e;
+    e.data = data;
+    e.id = next_id_++;
+    auto g = ghost_map_.find(lba);
+    if (g != ghost_map_.end())
+    {
+        // 不久前从 small 被挤出、又被读到：直接进 main
+        ghost_map_.erase(g);
+        stats_.ghost_hits++;
+        e.main = true;
+        main_.push_back({lba, e.id});
+        main_n_++;
+    }
+    else
+    {
+        small_.push_back({lba, e.id});
+        small_n_++;
+    }
+    map_.emplace(lba, move(e));
+    stats_.inserts++;
+}
+
+void ReadCache::invalidate(int lba)
+{
+    if (!cap_)
+        return;
+    auto it = map_.find(lba);
+    if (it == map_.end())
+        return;
+    (it->second.main ? main_n_ : small_n_)--;
+    map_.erase(it);
+    stats_.invalidations++;
+    // 队列里的旧位置出队时跳过；失效多、淘汰少时压缩，免得队列只增不减
+    if (small_.size() > 2 * cap_ + 64)
+        compact(small_, false);
+    if (main_.size() > 2 * cap_ + 64)
+        compact(main_, true);
+}
+
+void ReadCache::compact(deque<Slot> &q, bool main)
+{
+    deque<Slot> live;
+    for (const auto &[lba, id] : q)
+    {
+        auto it = map_.find(lba);
+        if (it != map_.end() && it->second.id == id && it->second.main == main)
+            live.push_back({lba, id});
+    }
+    q.swap(live);
+}
+
+void ReadCache::evict()
+{
+    if (small_n_ >= small_cap_ || !main_n_)
+        evict_small();
+    else
+        evict_main();
+}
+
+// small 队首：访问过的转入 main（总数不变，put 里的循环接着淘汰），否则淘汰并记入 ghost
+void ReadCache::evict_small()
+{
+    while (!small_.empty())
+    {
+        auto [lba, id] = small_.front();
+        small_.pop_front();
+        auto it = map_.find(lba);
+        if (it == map_.end() || it->second.id != id || it->second.main)
+            continue;
+        small_n_--;
+        if (it->second.freq > 0)
+        {
+            it->second.freq = 0;
+            it->second.main = true;
+            main_.push_back({lba, id});
+            main_n_++;
+            stats_.promotions++;
+            return;
+        }
+        map_.erase(it);
+        add_ghost(lba);
+        stats_.evictions++;
+        return;
+    }
+    evict_main();
+}
+
+void ReadCache::evict_main()
+{
+    while (!main_.empty())
+    {
+        auto [lba, id] = main_.front();
+        main_.pop_front();
+        auto it = map_.find(lba);
+        if (it == map_.end() || it->second.id != id || !it->second.main)
+            continue;
+        if (it->second.freq > 0)
+        {
+            it->second.freq--;
+            main_.push_back({lba, id});
+            continue;
+        }
+        map_.erase(it);
+        main_n_--;
+        stats_.evictions++;
+        return;
+    }
+}
+
+// ghost 只记 LBA，容量与 main 相同
+void ReadCache::add_ghost(int lba)
+{
+    uint64_t id = next_id_++;
+    ghost_map_[lba] = id;
+    ghost_.push_back({lba, id});
+    while (ghost_.size() > cap_ - small_cap_ + 1)
+    {
+        auto [old, oid] = ghost_.front();
+        ghost_.pop_front();
+        auto it = ghost_map_.find(old);
+        if (it != ghost_map_.end() && it->second == oid)
+            ghost_map_.erase(it);
+    }
+}
+
+size_t ReadCache::memory_bytes() const
+{
+    size_t bytes = (small_.size() + main_.size() + ghost_.size()) * sizeof(Slot);
+    bytes += map_.size() * (sizeof(pair<const int, Entry>) + 2 * sizeof(void *));
+    bytes += ghost_map_.size() * (sizeof(pair<const int, uint64_t>) + 2 * sizeof(void *));
+    for (const auto &kv : map_)
+        bytes += kv.second.data.capacity() > 15 ? kv.second.data.capacity() : 0;
+    return bytes;
+}
+
+size_t ReadCache::estimate_bytes(size_t capacity, size_t payload_bytes)
+{
+    if (!capacity)
+        return 0;
+    size_t small_cap = max<size_t>(1, capacity / 10), ghost = capacity - small_cap + 1;
+    size_t bytes = mem_hash_bytes<pair<const int, Entry>>(capacity) + capacity * mem_string_heap(payload_bytes);
+    bytes += mem_deque_bytes<Slot>(small_cap) + mem_deque_bytes<Slot>(capacity - small_cap) + mem_deque_bytes<Slot>(ghost);
+    return bytes + mem_hash_bytes<pair<const int, uint64_t>>(ghost);
+}
@@ -0,0 +1,74 @@
+#ifndef READ_CACHE_H
+#define READ_CACHE_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- ReadCache：按 LBA 缓存读出的负载（S3-FIFO） ----------------
+   - small FIFO（容量的 1/10）接收新条目；淘汰时被再次访问过的转入 main FIFO，
+     没有的只把 LBA 留在 ghost 队列里（不占负载），ghost 里的 LBA 再次插入时直接进 main
+   - 命中只把频次加一（封顶 3），不挪动队列：一次性扫描的条目在 small 里很快被挤出，不冲掉 main 里的热数据
+   - main 淘汰队首：频次 > 0 的减一后重新排到队尾，为 0 才真正淘汰
+   - 失效只删表项，队列里的旧位置出队时按 id 跳过；失效过多时压缩队列
+*/
+class ReadCache
+{
+public:
+    struct Stats
+    {
+        uint64_t lookups = 0;
+        uint64_t hits = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+        uint64_t ghost_hits = 0;    // 插入时 LBA 在 ghost 里（直接进 main）
+        uint64_t promotions = 0;    // small -> main
+    };
+
+    explicit ReadCache(size_t capacity = 0) { set_capacity(capacity); }
+
+    // 条目数（0 = 关闭）；清空现有内容
+    void set_capacity(size_t n);
+    size_t capacity() const { return cap_; }
+    size_t size() const { return map_.size(); }
+    bool enabled() const { return cap_ > 0; }
+
+    // 命中返回负载（到下一次 put / invalidate 前有效），未命中返回 nullptr
+    const string *get(int lba);
+    void put(int lba, const string &data);
+    void invalidate(int lba);
+    void clear();
+
+    const Stats &stats() const { return stats_; }
+    void reset_stats() { stats_ = Stats{}; }
+    // 表项 + 负载 + 队列的粗略 DRAM 占用
+    size_t memory_bytes() const;
+    // 分析值：容量 capacity 条、平均负载 payload_bytes 时占满的堆字节（mem_estimate 用，不需要实例）
+    static size_t estimate_bytes(size_t capacity, size_t payload_bytes);
+
+private:
+    struct Entry
+    {
+        string data;
+        uint64_t id = 0;
+        uint8_t freq = 0;
+        bool main = false;
+    };
+    using Slot = pair<int, uint64_t>; // (lba, id)
+
+    size_t cap_ = 0, small_cap_ = 0;
+    size_t small_n_ = 0, main_n_ = 0;
+    uint64_t next_id_ = 1;
+    unordered_map<int, Entry> map_;
+    deque<Slot> small_, main_, ghost_;
+    unordered_map<int, uint64_t> ghost_map_;
+    Stats stats_;
+
+    void evict();
+    void evict_small();
+    void evict_main();
+    void add_ghost(int lba);
+    void compact(deque<Slot> &q, bool main);
+};
+
+#endif // READ_CACHE_H
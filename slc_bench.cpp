@@ -0,0 +1,162 @@
+#include "ftl.h"
+#include "logger.h"
+
+/* ---------------- SLC 缓存悬崖 benchmark ----------------
+   顺序预写满全部 LBA 并 idle 到缓存 fold 空（不计入统计），之后交替：一段背靠背的主机写（burst，闭环），
+   再 idle 一段时间让后台 fold 把缓存腾空。burst 长度默认是缓存容量的 3 倍：前一段写落在空的 SLC 缓存上，
+   缓存用尽后每写满一个 SLC 条带都要在写路径里同步 fold 一个，写延迟掉下悬崖；idle 之后下一段 burst 重新从快的一侧开始。
+   写为 hot/cold：hot_write_pct% 的写落在 hot_pct% 的 LBA 上；热数据在缓存里被覆盖失效，fold 先挑有效页最少的条带，搬走的是剩下的冷数据。
+   逐 burst 输出缓存命中率、fold 条带数（其中只擦不搬的）、悬崖前后的平均 / 最大写延迟与悬崖位置，
+   并按 64 个写一个窗口打印第一段 burst 的平均写延迟，最后比较 SLC 与原生块的平均擦除次数。
+   用法：slc_bench [--slc N] [--bursts N] [--burst-x X] [--idle-ms MS] [--watermark N] [--hot-pct P]
+                  [--hot-write-pct P] [--seed S]
+   --slc：每 plane 的 SLC 块数；--burst-x：每段 burst 的写数 = X × 缓存页数；--watermark：前台 fold 低水位（空闲 SLC 条带数）
+*/
+
+struct SlcConfig
+{
+    int dies = 2, planes = 2, blocks = 64, pages = 96;
+    int reserved_write = 1, reserved_spare = 2;
+    int slc = 6;
+    double user_ratio = 0.85;
+    int bursts = 3;
+    double burst_x = 3.0;
+    double idle_ms = 2000;
+    int watermark = 1;
+    double hot_pct = 20;
+    int hot_write_pct = 80;
+    uint32_t seed = 1;
+};
+
+static double mean_us(const vector<uint64_t> &v, size_t a, size_t e)
+{
+    e = min(e, v.size());
+    if (a >= e)
+        return 0;
+    return accumulate(v.begin() + a, v.begin() + e, 0.0) / (e - a) / 1000.0;
+}
+
+// 悬崖之后只有每写满一个 SLC 条带的那一个写在路径里等 fold，占比不到 1%，p99 看不到，取最大值
+static double max_us(const vector<uint64_t> &v, size_t a, size_t e)
+{
+    e = min(e, v.size());
+    if (a >= e)
+        return 0;
+    return *max_element(v.begin() + a, v.begin() + e) / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    SlcConfig c;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--slc" && i + 1 < argc)
+            c.slc = max(1, stoi(argv[++i]));
+        else if (arg == "--bursts" && i + 1 < argc)
+            c.bursts = max(1, stoi(argv[++i]));
+        else if (arg == "--burst-x" && i + 1 < argc)
+            c.burst_x = max(0.1, stod(argv[++i]));
+        else if (arg == "--idle-ms" && i + 1 < argc)
+            c.idle_ms = max(0.0, stod(argv[++i]));
+        else if (arg == "--watermark" && i + 1 < argc)
+            c.watermark = max(0, stoi(argv[++i]));
+        else if (arg == "--hot-pct" && i + 1 < argc)
+            c.hot_pct = clamp(stod(argv[++i]), 0.1, 100.0);
+        else if (arg == "--hot-write-pct" && i + 1 < argc)
+            c.hot_write_pct = clamp(stoi(argv[++i]), 0, 100);
+        else if (arg == "--seed" && i + 1 < argc)
+            c.seed = (uint32_t)stoul(argv[++i]);
+        else
+        {
+            cerr << "usage: slc_bench [--slc N] [--bursts N] [--burst-x X] [--idle-ms MS] [--watermark N] [--hot-pct P]"
+                    " [--hot-write-pct P] [--seed S]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare, c.slc);
+    int lanes = c.dies * c.planes;
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare - c.slc) * c.pages * lanes;
+    int lbas = (int)(writable * c.user_ratio);
+    FTL ftl(driver, runtime, bm, lbas);
+    ftl.set_slc_fold_watermark(c.watermark);
+    int cache_pages = c.slc * lanes * driver.slc_pages_per_block();
+    uint64_t idle_ns = (uint64_t)(c.idle_ms * 1e6);
+
+    for (int l = 0; l < lbas; ++l)
+        ftl.write(l, "P");
+    ftl.idle(idle_ns);
+
+    cout << "geometry " << c.dies << "x" << c.planes << "x" << c.blocks << "x" << c.pages << " slc=" << c.slc
+         << "/plane cache_pages=" << cache_pages << " lbas=" << lbas << " watermark=" << c.watermark
+         << " hot=" << c.hot_write_pct << "%->" << c.hot_pct << "%\n";
+    cout << left << setw(7) << "burst" << right << setw(8) << "writes" << setw(9) << "slc_hit" << setw(7) << "folds"
+         << setw(7) << "empty" << setw(10) << "cliff_at" << setw(12) << "pre_avg_us" << setw(12) << "pre_max_us"
+         << setw(13) << "post_avg_us" << setw(13) << "post_max_us" << "\n";
+
+    mt19937 rng(c.seed);
+    int hot = max(1, (int)(lbas * c.hot_pct / 100));
+    int n = max(1, (int)(cache_pages * c.burst_x));
+    const int kWindow = 64;
+    vector<double> first_windows;
+    for (int b = 0; b < c.bursts; ++b)
+    {
+        FTL::SlcStats s0 = ftl.slc_stats();
+        vector<uint64_t> lat;
+        lat.reserve(n);
+        for (int i = 0; i < n; ++i)
+        {
+            int lba = (int)(rng() % 100) < c.hot_write_pct ? rng() % hot : hot + rng() % max(1, lbas - hot);
+            uint64_t t0 = ftl.now_ns();
+            ftl.write(lba, "W" + to_string(b));
+            lat.push_back(ftl.now_ns() - t0);
+        }
+        // 悬崖：第一个平均延迟超过首窗口两倍的窗口
+        double base = mean_us(lat, 0, kWindow);
+        int cliff = -1;
+        for (size_t w = 0; w * kWindow < lat.size(); ++w)
+        {
+            double avg = mean_us(lat, w * kWindow, (w + 1) * kWindow);
+            if (b == 0)
+                first_windows.push_back(avg);
+            if (cliff == -1 && avg > 2 * base)
+                cliff = (int)(w * kWindow);
+        }
+        const auto &s = ftl.slc_stats();
+        uint64_t hw = s.host_writes - s0.host_writes;
+        size_t split = cliff == -1 ? lat.size() : (size_t)cliff;
+        cout << left << setw(7) << b << right << setw(8) << n << fixed << setprecision(3) << setw(9)
+             << (hw ? (double)(s.slc_writes - s0.slc_writes) / hw : 0.0) << setprecision(1) << setw(7)
+             << s.fold_blocks - s0.fold_blocks << setw(7) << s.fold_empty - s0.fold_empty << setw(10)
+             << (cliff == -1 ? string("-") : to_string(cliff)) << setw(12) << mean_us(lat, 0, split) << setw(12)
+             << max_us(lat, 0, split) << setw(13) << mean_us(lat, split, lat.size()) << setw(13)
+             << max_us(lat, split, lat.size()) << defaultfloat << "\n";
+        ftl.idle(idle_ns);
+    }
+
+    cout << "burst 0 write latency per " << kWindow << " writes (avg_us):";
+    for (double w : first_windows)
+        cout << " " << (int)w;
+    cout << "\n";
+
+    // 擦除次数：SLC 块承接全部主机写，耐久按 SLC 模式算
+    double ec[2] = {0, 0};
+    int cnt[2] = {0, 0};
+    for (int d = 0; d < c.dies; ++d)
+        for (int p = 0; p < c.planes; ++p)
+            for (int blk = 0; blk < c.blocks; ++blk)
+            {
+                int k = driver.is_block_slc(d, p, blk) ? 1 : 0;
+                ec[k] += runtime.erase_count[runtime.idx(d, p, blk)];
+                cnt[k]++;
+            }
+    cout << fixed << setprecision(1) << "erase mean: slc=" << (cnt[1] ? ec[1] / cnt[1] : 0.0)
+         << " native=" << (cnt[0] ? ec[0] / cnt[0] : 0.0) << defaultfloat << "\n";
+    ftl.dump_slc_stats();
+    return 0;
+}
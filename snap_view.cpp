@@ -0,0 +1,167 @@
+#include "snapshot.h"
+#include "logger.h"
+
+/* ---------------- 快照查看 ----------------
+   读 FTL::capture_snapshot 保存的列式快照，离线输出：
+   - 概要：几何、仿真时刻、各列 min / max / mean
+   - 直方图：选定列按值域等分 bins 桶（坏块不计）
+   - 热图：每个 (die, plane) 一行，块数超过 --width 时相邻块取平均；坏块为 X
+   用法：snap_view FILE [--column NAME] [--bins N] [--width N] [--pgm OUT] [--csv OUT]
+   --pgm：热图写成灰度 PGM（宽 = 块数，高 = die × plane，坏块为黑）
+   --csv：逐块导出全部列，便于画图
+*/
+
+static const char kShade[] = " .:-=+*#%@";
+
+static bool write_csv(const BlockSnapshot &s, const string &path)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out << "die,plane,pbn";
+    for (const auto &c : s.columns)
+        out << "," << c.first;
+    out << "\n";
+    for (int d = 0; d < s.dies; ++d)
+        for (int p = 0; p < s.planes; ++p)
+            for (int b = 0; b < s.blocks; ++b)
+            {
+                size_t i = ((size_t)d * s.planes + p) * s.blocks + b;
+                out << d << "," << p << "," << b;
+                for (const auto &c : s.columns)
+                    out << "," << c.second[i];
+                out << "\n";
+            }
+    return (bool)out;
+}
+
+static bool write_pgm(const BlockSnapshot &s, const vector<int32_t> &v, const vector<int32_t> *bad, int lo, int hi,
+                      const string &path)
+{
+    ofstream out(path, ios::binary);
+    if (!out)
+        return false;
+    out << "P5\n" << s.blocks << " " << s.dies * s.planes << "\n255\n";
+    string row(s.blocks, '\0');
+    for (size_t r = 0; r < (size_t)s.dies * s.planes; ++r)
+    {
+        for (int b = 0; b < s.blocks; ++b)
+        {
+            size_t i = r * s.blocks + b;
+            if (bad && (*bad)[i])
+                row[b] = 0;
+            else
+                row[b] = (char)(hi > lo ? 32 + (long)(v[i] - lo) * 223 / (hi - lo) : 128);
+        }
+        out.write(row.data(), row.size());
+    }
+    return (bool)out;
+}
+
+int main(int argc, char **argv)
+{
+    string file, col = "erase_count", pgm, csv;
+    int bins = 10, width = 64;
+    bool usage = argc < 2;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--column" && i + 1 < argc)
+            col = argv[++i];
+        else if (arg == "--bins" && i + 1 < argc)
+            bins = max(1, stoi(argv[++i]));
+        else if (arg == "--width" && i + 1 < argc)
+            width = max(1, stoi(argv[++i]));
+        else if (arg == "--pgm" && i + 1 < argc)
+            pgm = argv[++i];
+        else if (arg == "--csv" && i + 1 < argc)
+            csv = argv[++i];
+        else if (file.empty() && arg[0] != '-')
+            file = arg;
+        else
+            usage = true;
+    }
+    if (usage || file.empty())
+    {
+        cerr << "usage: snap_view FILE [--column NAME] [--bins N] [--width N] [--pgm OUT] [--csv OUT]\n";
+        return 1;
+    }
+    BlockSnapshot s;
+    if (!s.load(file))
+    {
+        Logger::instance().flush();
+        cerr << "cannot load " << file << "\n";
+        return 1;
+    }
+    cout << "geometry " << s.dies << "x" << s.planes << "x" << s.blocks << "x" << s.pages_per_block
+         << " sectors/page=" << s.sectors_per_page << " now_us=" << s.now_ns / 1000 << "\n";
+    const vector<int32_t> *bad = s.column("bad");
+    for (const auto &[name, v] : s.columns)
+    {
+        auto [mn, mx] = minmax_element(v.begin(), v.end());
+        double sum = accumulate(v.begin(), v.end(), 0.0);
+        cout << left << setw(12) << name << right << " min=" << setw(8) << (v.empty() ? 0 : *mn)
+             << " max=" << setw(8) << (v.empty() ? 0 : *mx) << " mean=" << fixed << setprecision(2)
+             << (v.empty() ? 0.0 : sum / v.size()) << defaultfloat << "\n";
+    }
+
+    const vector<int32_t> *vp = s.column(col);
+    if (!vp)
+    {
+        cerr << "no column " << col << "\n";
+        return 1;
+    }
+    const auto &v = *vp;
+    auto good = [&](size_t i) { return !bad || !(*bad)[i]; };
+    int lo = INT_MAX, hi = INT_MIN;
+    for (size_t i = 0; i < v.size(); ++i)
+        if (good(i))
+            lo = min(lo, v[i]), hi = max(hi, v[i]);
+    if (lo > hi)
+        lo = hi = 0;
+
+    // 直方图
+    vector<uint64_t> hist(bins);
+    for (size_t i = 0; i < v.size(); ++i)
+        if (good(i))
+            hist[hi > lo ? min<long>(bins - 1, (long)(v[i] - lo) * bins / (hi - lo)) : 0]++;
+    uint64_t peak = max<uint64_t>(1, *max_element(hist.begin(), hist.end()));
+    cout << "\n[HIST] " << col << "\n";
+    for (int k = 0; k < bins; ++k)
+    {
+        long a = lo + (long)(hi - lo) * k / bins, b = lo + (long)(hi - lo) * (k + 1) / bins;
+        cout << "  [" << setw(8) << a << ", " << setw(8) << b << (k + 1 == bins ? "]" : ")") << " " << setw(8)
+             << hist[k] << " " << string(hist[k] * 50 / peak, '#') << "\n";
+    }
+
+    // 热图：每行一个 (die, plane)
+    int cols = min(width, s.blocks);
+    cout << "\n[HEAT] " << col << " (' '=" << lo << " '@'=" << hi << ", X=bad, " << s.blocks << " blocks -> "
+         << cols << " cells)\n";
+    for (int d = 0; d < s.dies; ++d)
+        for (int p = 0; p < s.planes; ++p)
+        {
+            string line;
+            size_t base = ((size_t)d * s.planes + p) * s.blocks;
+            for (int c = 0; c < cols; ++c)
+            {
+                int b0 = (int)((long)c * s.blocks / cols), b1 = (int)((long)(c + 1) * s.blocks / cols);
+                double sum = 0;
+                int n = 0;
+                for (int b = b0; b < b1; ++b)
+                    if (good(base + b))
+                        sum += v[base + b], n++;
+                if (!n)
+                    line += 'X';
+                else
+                    line += kShade[hi > lo ? min(9, (int)((sum / n - lo) * 10 / (hi - lo))) : 0];
+            }
+            cout << "  d" << d << "p" << p << " |" << line << "|\n";
+        }
+
+    if (!pgm.empty() && !write_pgm(s, v, bad, lo, hi, pgm))
+        cerr << "cannot write " << pgm << "\n";
+    if (!csv.empty() && !write_csv(s, csv))
+        cerr << "cannot write " << csv << "\n";
+    return 0;
+}
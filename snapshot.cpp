@@ -0,0 +1,188 @@
+#include "snapshot.h"
+#include "logger.h"
+
+static const char kSnapMagic[8] = {'F', 'T', 'L', 'S', 'N', 'A', 'P', '1'};
+
+static uint64_t fnv1a(const char *p, size_t n, uint64_t h = 1469598103934665603ull)
+{
+    for (size_t i = 0; i < n; ++i)
+        h = (h ^ (uint8_t)p[i]) * 1099511628211ull;
+    return h;
+}
+
+const vector<int32_t> *BlockSnapshot::column(const string &name) const
+{
+    for (const auto &c : columns)
+        if (c.first == name)
+            return &c.second;
+    return nullptr;
+}
+
+vector<int32_t> &BlockSnapshot::column_for_write(const string &name)
+{
+    for (auto &c : columns)
+        if (c.first == name)
+        {
+            c.second.resize(rows());
+            return c.second;
+        }
+    columns.push_back({name, vector<int32_t>(rows())});
+    return columns.back().second;
+}
+
+static void put_varint(string &buf, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        buf.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back((char)v);
+}
+
+static void encode_column(string &buf, const vector<int32_t> &v, bool delta)
+{
+    if (!delta)
+    {
+        buf.append(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(int32_t));
+        return;
+    }
+    int32_t prev = 0;
+    for (int32_t x : v)
+    {
+        int32_t d = (int32_t)((uint32_t)x - (uint32_t)prev);
+        put_varint(buf, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+        prev = x;
+    }
+}
+
+static bool decode_column(const char *p, size_t n, uint8_t enc, vector<int32_t> &v)
+{
+    if (enc == BlockSnapshot::RAW)
+    {
+        if (n != v.size() * sizeof(int32_t))
+            return false;
+        memcpy(v.data(), p, n);
+        return true;
+    }
+    if (enc != BlockSnapshot::DELTA)
+        return false;
+    size_t pos = 0;
+    int32_t prev = 0;
+    for (auto &x : v)
+    {
+        uint32_t z = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            if (pos >= n || shift > 28)
+                return false;
+            uint8_t b = (uint8_t)p[pos++];
+            z |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        int32_t d = (int32_t)((z >> 1) ^ -(z & 1));
+        x = prev = (int32_t)((uint32_t)prev + (uint32_t)d);
+    }
+    return pos == n;
+}
+
+bool BlockSnapshot::save(const string &path, bool compress) const
+{
+    string buf(kSnapMagic, sizeof(kSnapMagic));
+    auto put32 = [&](uint32_t v) { buf.append(reinterpret_cast<const char *>(&v), sizeof(v)); };
+    for (int v : {dies, planes, blocks, pages_per_block, sectors_per_page})
+        put32((uint32_t)v);
+    buf.append(reinterpret_cast<const char *>(&now_ns), sizeof(now_ns));
+    put32((uint32_t)columns.size());
+    for (const auto &[name, v] : columns)
+    {
+        if (v.size() != rows() || name.size() > 255)
+        {
+            LOG_ERROR("[SNAP] bad column " << name);
+            return false;
+        }
+        buf.push_back((char)name.size());
+        buf += name;
+        buf.push_back((char)(compress ? DELTA : RAW));
+        size_t len_at = buf.size();
+        put32(0);
+        encode_column(buf, v, compress);
+        uint32_t len = (uint32_t)(buf.size() - len_at - sizeof(uint32_t));
+        memcpy(&buf[len_at], &len, sizeof(len));
+    }
+    uint64_t h = fnv1a(buf.data(), buf.size());
+    buf.append(reinterpret_cast<const char *>(&h), sizeof(h));
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out || !out.write(buf.data(), buf.size()))
+    {
+        LOG_ERROR("[SNAP] cannot write " << path);
+        return false;
+    }
+    return true;
+}
+
+bool BlockSnapshot::load(const string &path)
+{
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    size_t head = sizeof(kSnapMagic) + 5 * 4 + 8 + 4;
+    if (buf.size() < head + 8 || memcmp(buf.data(), kSnapMagic, sizeof(kSnapMagic)) != 0)
+    {
+        LOG_ERROR("[SNAP] bad snapshot: " << path);
+        return false;
+    }
+    uint64_t h;
+    memcpy(&h, buf.data() + buf.size() - sizeof(h), sizeof(h));
+    if (fnv1a(buf.data(), buf.size() - sizeof(h)) != h)
+    {
+        LOG_ERROR("[SNAP] checksum mismatch: " << path);
+        return false;
+    }
+    size_t pos = sizeof(kSnapMagic), end = buf.size() - sizeof(h);
+    auto get32 = [&]() -> uint32_t
+    {
+        uint32_t v = 0;
+        if (pos + sizeof(v) <= end)
+            memcpy(&v, buf.data() + pos, sizeof(v));
+        pos += sizeof(v);
+        return v;
+    };
+    dies = (int)get32();
+    planes = (int)get32();
+    blocks = (int)get32();
+    pages_per_block = (int)get32();
+    sectors_per_page = (int)get32();
+    memcpy(&now_ns, buf.data() + pos, sizeof(now_ns));
+    pos += sizeof(now_ns);
+    uint32_t ncols = get32();
+    columns.clear();
+    for (uint32_t i = 0; i < ncols; ++i)
+    {
+        if (pos >= end)
+            break;
+        size_t nlen = (uint8_t)buf[pos++];
+        if (pos + nlen + 1 > end)
+            break;
+        string name = buf.substr(pos, nlen);
+        pos += nlen;
+        uint8_t enc = (uint8_t)buf[pos++];
+        uint32_t len = get32();
+        auto &v = column_for_write(name);
+        if (pos > end || len > end - pos || !decode_column(buf.data() + pos, len, enc, v))
+        {
+            LOG_ERROR("[SNAP] corrupt column " << name << ": " << path);
+            return false;
+        }
+        pos += len;
+    }
+    if (pos != end)
+    {
+        LOG_ERROR("[SNAP] truncated snapshot: " << path);
+        return false;
+    }
+    return true;
+}
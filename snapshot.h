@@ -0,0 +1,40 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- BlockSnapshot：块级遥测快照（列式二进制） ----------------
+   - 每个物理块一行，行序同 NandRuntime::idx（die -> plane -> PBN），各量按列连续存放
+   - FTL::capture_snapshot 填列：erase_count / prog_count / read_count / valid（有效扇区）/ bad / slc /
+     vbn（该 PBN 承载的 VBN，-1 = 未映射，即 spare 或已换下的坏块）
+   - 文件：magic "FTLSNAP1" | 头部 | 列 × ncols | FNV-1a 校验（uint64，覆盖之前全部字节）
+     列：名字长度 (uint8) 名字 | 编码 (uint8) | 字节数 (uint32) | 数据
+   - 编码 RAW：int32 小端；DELTA：与前一块之差 zigzag 后变长编码（相邻块计数接近，多数 1 字节）
+   - 同一对象反复 capture 复用列缓冲，运行中途采集只是几次顺序拷贝
+*/
+struct BlockSnapshot
+{
+    enum Encoding : uint8_t
+    {
+        RAW = 0,
+        DELTA = 1
+    };
+
+    int dies = 0, planes = 0, blocks = 0;
+    int pages_per_block = 0, sectors_per_page = 1;
+    uint64_t now_ns = 0;
+    vector<pair<string, vector<int32_t>>> columns;
+
+    size_t rows() const { return (size_t)dies * planes * blocks; }
+    // 按名字取列；不存在返回 nullptr
+    const vector<int32_t> *column(const string &name) const;
+    // 取列（不存在则追加），长度置为 rows()
+    vector<int32_t> &column_for_write(const string &name);
+
+    // compress = true 时各列用 DELTA 编码
+    bool save(const string &path, bool compress = true) const;
+    bool load(const string &path);
+};
+
+#endif // SNAPSHOT_H
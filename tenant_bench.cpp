@@ -0,0 +1,179 @@
+#include "host_sched.h"
+#include "logger.h"
+
+/* ---------------- 多租户 QoS benchmark ----------------
+   两个 namespace 共用一个 BlockManager：
+   - 租户 A：随机覆盖写，持续触发 GC
+   - 租户 B：读为主（少量写）
+   默认到达间隔让设备处于争用状态（队列有积压）。同一到达序列分别用 FIFO 与 WFQ 调度，比较 B 的读尾延迟与各自的 GC 代价。
+   GC 仍在触发它的那个写请求里同步执行：gc_runs 按 victim 所属 namespace 计，gc_inline 按执行 GC 的写所属 namespace 计。
+   WFQ 只调度主机请求，B 的写触发、回收 A 的条带的 GC 仍算在 B 的服务时间里，这部分干扰隔离不了。
+   每种调度再按 NAND 读调度各跑一次：off（读排在队尾）/ prio（读插到排队的 program/erase 之前）/
+   suspend（读优先且可打断正在执行的 program/erase）。
+   写缓冲下主机写在 program 完成前就返回，读插队 / 打断的代价不出现在主机写延迟里，而是落在 program 上：
+   每种模式另输出 program 的最终时延平均 / p99（下发到完成，含返回之后被读推迟的部分）与被推迟的 program/erase 数、平均推迟。
+   用法：tenant_bench [--ops N] [--seed S] [--weight-b W] [--a-gap-us US] [--b-gap-us US]
+                      [--suspend N] [--suspend-us US] [--write-buffer PAGES]
+   --write-buffer：主机写进入写缓冲即返回（program 在后台完成），读才会碰到忙碌的 die
+*/
+
+struct TenantConfig
+{
+    int dies = 2, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85;
+    int ops = 20000;       // 预写之后的请求数（两个租户合计）
+    double a_gap_us = 2000; // A 的平均到达间隔
+    double b_gap_us = 600;  // B 的平均到达间隔
+    int b_write_pct = 5;
+    double weight_b = 1.0;
+    int max_suspends = 4;    // suspend 打开时每个 program/erase 最多被打断次数
+    double suspend_us = 20;  // 暂停开销
+    int write_buffer = 16;   // 写缓冲页数（0 = 写等 program 完成）
+    uint32_t seed = 1;
+};
+
+static vector<HostIo> make_arrivals(const TenantConfig &c, const vector<int> &sizes)
+{
+    mt19937 rng(c.seed);
+    exponential_distribution<double> gap_a(1.0 / c.a_gap_us), gap_b(1.0 / c.b_gap_us);
+    double ta = gap_a(rng), tb = gap_b(rng);
+    vector<HostIo> v;
+    for (int i = 0; i < c.ops; ++i)
+    {
+        HostIo io;
+        if (ta <= tb)
+        {
+            io.ns = 0;
+            io.is_write = true;
+            io.lba = rng() % sizes[0];
+            io.arrival_ns = (uint64_t)(ta * 1000);
+            ta += gap_a(rng);
+        }
+        else
+        {
+            io.ns = 1;
+            io.is_write = (int)(rng() % 100) < c.b_write_pct;
+            io.lba = rng() % sizes[1];
+            io.arrival_ns = (uint64_t)(tb * 1000);
+            tb += gap_b(rng);
+        }
+        io.data = io.is_write ? "T" + to_string(io.ns) : string();
+        v.push_back(std::move(io));
+    }
+    return v;
+}
+
+enum class ReadMode
+{
+    OFF,
+    PRIO,
+    SUSPEND
+};
+
+static void run(const TenantConfig &c, bool fair, ReadMode mode)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    NandCellParams cp;
+    cp.read_priority = mode != ReadMode::OFF;
+    cp.max_suspends = mode == ReadMode::SUSPEND ? c.max_suspends : 0;
+    cp.t_suspend_ns = (uint64_t)(c.suspend_us * 1000);
+    driver.set_cell_params(cp);
+    driver.set_record_program_latency(true);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    int lbas = (int)(writable * c.user_ratio);
+    FTL ftl(driver, runtime, bm, lbas);
+    vector<int> sizes = {lbas * 3 / 4, lbas - lbas * 3 / 4};
+    ftl.set_namespaces(sizes);
+    ftl.set_gc_free_watermark(2);
+    ftl.set_write_buffer(c.write_buffer);
+
+    // 预写两个 namespace，不计入统计
+    for (int ns = 0; ns < 2; ++ns)
+        for (int l = 0; l < sizes[ns]; ++l)
+            ftl.write_ns(ns, l, "P");
+    FTL::NamespaceStats base[2] = {ftl.namespace_stats(0), ftl.namespace_stats(1)};
+    NandStats nbase = driver.get_stats();
+    driver.clear_program_latencies();
+
+    HostScheduler sched(ftl);
+    sched.set_fair(fair);
+    sched.set_weight(1, c.weight_b);
+    uint64_t t0 = ftl.now_ns();
+    for (HostIo io : make_arrivals(c, sizes))
+    {
+        io.arrival_ns += t0;
+        // 到达时刻之前能服务的先服务，队列只含已到达的请求
+        while (ftl.now_ns() < io.arrival_ns && sched.dispatch())
+            ;
+        sched.submit(io);
+    }
+    sched.drain();
+    static const char *const kMode[] = {"off", "prio", "suspend"};
+    const NandStats &ns = driver.get_stats();
+    vector<uint64_t> prog = driver.program_latencies_ns();
+    double prog_avg = 0, prog_p99 = 0;
+    if (!prog.empty())
+    {
+        prog_avg = accumulate(prog.begin(), prog.end(), 0.0) / prog.size() / 1000.0;
+        size_t k = min(prog.size() - 1, (size_t)(0.99 * (prog.size() - 1)));
+        nth_element(prog.begin(), prog.begin() + k, prog.end());
+        prog_p99 = prog[k] / 1000.0;
+    }
+    uint64_t delayed = ns.delayed_long_ops - nbase.delayed_long_ops;
+    cout << "-- " << (fair ? "wfq" : "fifo") << " nand_read=" << kMode[(int)mode]
+         << " suspends=" << ns.suspends - nbase.suspends << fixed << setprecision(1) << " prog_avg=" << prog_avg << "us prog_p99=" << prog_p99
+         << "us delayed_prog_erase=" << delayed << " avg_delay="
+         << (delayed ? (ns.long_op_delay_ns - nbase.long_op_delay_ns) / 1000.0 / delayed : 0.0) << "us"
+         << defaultfloat << "\n";
+    sched.dump_latency_stats();
+    for (int ns = 0; ns < 2; ++ns)
+    {
+        auto st = ftl.namespace_stats(ns);
+        cout << "        ns" << ns << " host_writes=" << st.host_writes - base[ns].host_writes
+             << " gc_runs=" << st.gc_runs - base[ns].gc_runs << " gc_inline=" << st.gc_inline - base[ns].gc_inline
+             << " gc_pages=" << st.gc_pages - base[ns].gc_pages << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TenantConfig cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc)
+            cfg.ops = stoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else if (arg == "--weight-b" && i + 1 < argc)
+            cfg.weight_b = stod(argv[++i]);
+        else if (arg == "--a-gap-us" && i + 1 < argc)
+            cfg.a_gap_us = stod(argv[++i]);
+        else if (arg == "--b-gap-us" && i + 1 < argc)
+            cfg.b_gap_us = stod(argv[++i]);
+        else if (arg == "--suspend" && i + 1 < argc)
+            cfg.max_suspends = max(1, stoi(argv[++i]));
+        else if (arg == "--suspend-us" && i + 1 < argc)
+            cfg.suspend_us = stod(argv[++i]);
+        else if (arg == "--write-buffer" && i + 1 < argc)
+            cfg.write_buffer = max(0, stoi(argv[++i]));
+        else
+        {
+            cerr << "usage: tenant_bench [--ops N] [--seed S] [--weight-b W] [--a-gap-us US] [--b-gap-us US]"
+                    " [--suspend N] [--suspend-us US] [--write-buffer PAGES]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+         << " ops=" << cfg.ops << " a_gap=" << cfg.a_gap_us << "us b_gap=" << cfg.b_gap_us << "us"
+         << " write_buffer=" << cfg.write_buffer << "\n";
+    for (bool fair : {false, true})
+        for (ReadMode mode : {ReadMode::OFF, ReadMode::PRIO, ReadMode::SUSPEND})
+            run(cfg, fair, mode);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "trace.h"
+#include "nand_driver.h"
+#include "logger.h"
+
+/* ---------------- Tracer ---------------- */
+Tracer &Tracer::instance()
+{
+    static Tracer t;
+    return t;
+}
+
+void Tracer::enable(bool on, size_t per_thread_capacity)
+{
+    {
+        lock_guard<mutex> lk(reg_mtx_);
+        size_t cap = 1;
+        while (cap < max<size_t>(per_thread_capacity, 1))
+            cap <<= 1;
+        capacity_ = cap;
+    }
+    g_trace_enabled.store(on, memory_order_relaxed);
+}
+
+Tracer::Ring *Tracer::register_thread()
+{
+    lock_guard<mutex> lk(reg_mtx_);
+    auto r = make_unique<Ring>();
+    r->buf.resize(capacity_);
+    r->mask = capacity_ - 1;
+    r->tid = (int)rings_.size();
+    rings_.push_back(move(r));
+    return rings_.back().get();
+}
+
+void Tracer::record(const TraceRecord &rec)
+{
+    static thread_local Ring *ring = nullptr;
+    if (!ring)
+        ring = register_thread();
+    // 单写者：本线程独占该 ring，只需发布 head
+    uint64_t h = ring->head.load(memory_order_relaxed);
+    ring->buf[h & ring->mask] = rec;
+    ring->head.store(h + 1, memory_order_release);
+}
+
+void Tracer::clear()
+{
+    lock_guard<mutex> lk(reg_mtx_);
+    for (auto &r : rings_)
+        r->head.store(0, memory_order_relaxed);
+}
+
+size_t Tracer::size() const
+{
+    lock_guard<mutex> lk(reg_mtx_);
+    size_t n = 0;
+    for (auto &r : rings_)
+        n += min<uint64_t>(r->head.load(memory_order_acquire), r->buf.size());
+    return n;
+}
+
+static const char *trace_cmd_name(uint8_t cmd)
+{
+    switch ((NandCmd)cmd)
+    {
+    case NandCmd::READ_PAGE:    return "READ";
+    case NandCmd::PROGRAM_PAGE: return "PROGRAM";
+    case NandCmd::ERASE_BLOCK:  return "ERASE";
+    }
+    return "UNKNOWN";
+}
+
+static const char *trace_status_name(uint8_t st)
+{
+    switch ((NandStatus)st)
+    {
+    case NandStatus::SUCCESS:   return "SUCCESS";
+    case NandStatus::FAILED:    return "FAILED";
+    case NandStatus::BAD_BLOCK: return "BAD_BLOCK";
+    case NandStatus::ECC_ERROR: return "ECC_ERROR";
+    case NandStatus::TIMEOUT:   return "TIMEOUT";
+    case NandStatus::INVALID_PARAM: return "INVALID_PARAM";
+    }
+    return "UNKNOWN";
+}
+
+static const char *trace_span_name(TraceKind k)
+{
+    switch (k)
+    {
+    case TraceKind::GC:      return "GC";
+    case TraceKind::FOLD:    return "FOLD";
+    case TraceKind::REFRESH: return "REFRESH";
+    default:                 break;
+    }
+    return "UNKNOWN";
+}
+
+// 导出 Chrome trace-event JSON：pid 0 = NAND（tid = die），pid 1 = FTL（tid = 记录线程）
+bool Tracer::export_chrome_json(const string &path) const
+{
+    ofstream os(path);
+    if (!os)
+    {
+        LOG_ERROR("[TRACE] open failed: " << path);
+        return false;
+    }
+    lock_guard<mutex> lk(reg_mtx_);
+    os << fixed << setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"NAND\"}},\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"FTL\"}}";
+    set<int> dies;
+    for (const auto &r : rings_)
+    {
+        uint64_t head = r->head.load(memory_order_acquire);
+        uint64_t n = min<uint64_t>(head, r->buf.size());
+        for (uint64_t i = head - n; i < head; ++i)
+        {
+            const TraceRecord &e = r->buf[i & r->mask];
+            double ts = e.ts_ns / 1000.0, dur = e.dur_ns / 1000.0;
+            os << ",\n";
+            switch (e.kind)
+            {
+            case TraceKind::NAND_OP:
+                dies.insert(e.die);
+                os << "{\"name\":\"" << trace_cmd_name(e.cmd) << "\",\"cat\":\"nand\",\"ph\":\"X\",\"ts\":" << ts
+                   << ",\"dur\":" << dur << ",\"pid\":0,\"tid\":" << e.die << ",\"args\":{\"plane\":" << e.plane
+                   << ",\"block\":" << e.block << ",\"page\":" << e.page << ",\"status\":\""
+                   << trace_status_name(e.status) << "\",\"wait_us\":" << e.wait_ns / 1000.0 << "}}";
+                break;
+            case TraceKind::GC:
+            case TraceKind::FOLD:
+            case TraceKind::REFRESH:
+                os << "{\"name\":\"" << trace_span_name(e.kind) << "\",\"cat\":\"ftl\",\"ph\":\"X\",\"ts\":"
+                   << ts << ",\"dur\":" << dur << ",\"pid\":1,\"tid\":" << r->tid << ",\"args\":{\"superblock\":"
+                   << e.arg0 << ",\"relocated\":" << e.arg1 << "}}";
+                break;
+            case TraceKind::REMAP:
+                os << "{\"name\":\"REMAP\",\"cat\":\"ftl\",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << ts
+                   << ",\"pid\":1,\"tid\":" << r->tid << ",\"args\":{\"die\":" << e.die << ",\"plane\":" << e.plane
+                   << ",\"bad_pbn\":" << e.block << ",\"new_pbn\":" << e.arg0 << "}}";
+                break;
+            }
+        }
+    }
+    for (int d : dies)
+        os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << d << ",\"args\":{\"name\":\"die " << d << "\"}}";
+    os << "\n]}\n";
+    return (bool)os;
+}
@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+/* ---------------- Tracer：环形缓冲区事件追踪 ----------------
+   - 始终编译进来、运行期开关；关闭时热路径只有一次 trace_enabled() 判断
+   - 每个线程一个环形缓冲区（首次记录时注册），写入无锁；写满后覆盖最老的记录
+   - 时间戳用仿真时钟（NandOp::issue_ns/complete_ns、FTL::now_ns），与时序模型一致
+   - 导出 Chrome trace-event JSON（Perfetto / chrome://tracing 可直接打开）：
+     NAND 操作按 die 分轨，GC/folding/refresh/remap 在 FTL 轨道上
+   - 导出、clear() 需在没有线程写入时调用
+*/
+enum class TraceKind : uint8_t
+{
+    NAND_OP, // cmd = NandCmd，status = NandStatus
+    GC,      // arg0 = victim 超级块，arg1 = 搬移页数
+    FOLD,    // arg0 = SLC 超级块，arg1 = 搬移页数
+    REMAP,   // (die, plane, block) = 坏 PBN，arg0 = 新 PBN（-1 = 无 spare）
+    REFRESH  // arg0 = 刷新的超级块，arg1 = 搬移页数
+};
+
+struct TraceRecord
+{
+    uint64_t ts_ns = 0;
+    uint64_t dur_ns = 0;
+    uint64_t wait_ns = 0; // NAND_OP：issue 到 die 开始执行的排队时间
+    TraceKind kind = TraceKind::NAND_OP;
+    uint8_t cmd = 0;
+    uint8_t status = 0;
+    int16_t die = -1, plane = -1;
+    int32_t block = -1, page = -1;
+    int32_t arg0 = -1, arg1 = -1;
+};
+
+class Tracer
+{
+public:
+    static Tracer &instance();
+
+    // per_thread_capacity 向上取 2 的幂，只影响之后新注册的线程
+    void enable(bool on, size_t per_thread_capacity = 1 << 16);
+    void record(const TraceRecord &r);
+    void clear();
+    size_t size() const;
+    bool export_chrome_json(const string &path) const;
+
+private:
+    struct Ring
+    {
+        vector<TraceRecord> buf;
+        size_t mask = 0;
+        atomic<uint64_t> head{0};
+        int tid = 0;
+    };
+
+    mutable mutex reg_mtx_; // 只保护线程注册
+    vector<unique_ptr<Ring>> rings_;
+    size_t capacity_ = 1 << 16;
+
+    Ring *register_thread();
+};
+
+inline atomic<bool> g_trace_enabled{false};
+
+inline bool trace_enabled()
+{
+    return __builtin_expect(g_trace_enabled.load(memory_order_relaxed), 0);
+}
+
+#endif // TRACE_H
@@ -0,0 +1,347 @@
+#include "zns.h"
+#include "logger.h"
+
+const char *zns_status_name(ZnsStatus s)
+{
+    switch (s)
+    {
+    case ZnsStatus::SUCCESS: return "SUCCESS";
+    case ZnsStatus::INVALID_FIELD: return "INVALID_FIELD";
+    case ZnsStatus::OUT_OF_RANGE: return "OUT_OF_RANGE";
+    case ZnsStatus::INVALID_WRITE: return "INVALID_WRITE";
+    case ZnsStatus::ZONE_FULL: return "ZONE_FULL";
+    case ZnsStatus::ZONE_READ_ONLY: return "ZONE_READ_ONLY";
+    case ZnsStatus::ZONE_OFFLINE: return "ZONE_OFFLINE";
+    case ZnsStatus::TOO_MANY_OPEN: return "TOO_MANY_OPEN";
+    case ZnsStatus::TOO_MANY_ACTIVE: return "TOO_MANY_ACTIVE";
+    case ZnsStatus::WRITE_FAULT: return "WRITE_FAULT";
+    case ZnsStatus::READ_ERROR: return "READ_ERROR";
+    }
+    return "?";
+}
+
+const char *zone_state_name(ZoneState s)
+{
+    switch (s)
+    {
+    case ZoneState::EMPTY: return "EMPTY";
+    case ZoneState::IMPLICIT_OPEN: return "IMP_OPEN";
+    case ZoneState::EXPLICIT_OPEN: return "EXP_OPEN";
+    case ZoneState::CLOSED: return "CLOSED";
+    case ZoneState::FULL: return "FULL";
+    case ZoneState::READ_ONLY: return "READ_ONLY";
+    case ZoneState::OFFLINE: return "OFFLINE";
+    }
+    return "?";
+}
+
+static bool is_open(ZoneState s) { return s == ZoneState::IMPLICIT_OPEN || s == ZoneState::EXPLICIT_OPEN; }
+static bool is_active(ZoneState s) { return is_open(s) || s == ZoneState::CLOSED; }
+
+ZnsDevice::ZnsDevice(NandDriver &drv, NandRuntime &rt, BlockManager &bm, int max_open, int max_active)
+    : drv_(drv), runtime_(rt), bm_(bm)
+{
+    // 与 FTL 相同：BlockManager 未从系统区载入时按 OOB 建 BBT
+    if (!bm_.initialized())
+    {
+        for (int d = 0; d < drv_.dies_per_nand(); ++d)
+            for (int p = 0; p < drv_.planes_per_die(); ++p)
+                for (int b = 0; b < drv_.blocks_per_plane(); ++b)
+                    runtime_.bad_block_table[runtime_.idx(d, p, b)] = drv_.is_block_bad(d, p, b);
+        bm_.init_from_bbt([this](int d, int p, int b) { return (bool)runtime_.bad_block_table[runtime_.idx(d, p, b)]; });
+    }
+    zone_size_ = drv_.pages_per_block() * drv_.dies_per_nand() * drv_.planes_per_die();
+    zones_.resize(bm_.free_superblocks(false));
+    for (int z = 0; z < (int)zones_.size(); ++z)
+    {
+        zones_[z].start = zones_[z].wp = z * zone_size_;
+        zones_[z].cap = zone_size_;
+    }
+    max_active_ = max(1, min(max_active, zone_count()));
+    max_open_ = max(1, min(max_open, max_active_));
+}
+
+void ZnsDevice::set_state(int z, ZoneState s)
+{
+    auto &zn = zones_[z];
+    n_open_ += (int)is_open(s) - (int)is_open(zn.state);
+    n_active_ += (int)is_active(s) - (int)is_active(zn.state);
+    if (zn.state == ZoneState::IMPLICIT_OPEN)
+        implicit_open_.erase(find(implicit_open_.begin(), implicit_open_.end(), z));
+    if (s == ZoneState::IMPLICIT_OPEN)
+        implicit_open_.push_back(z);
+    zn.state = s;
+}
+
+NandAddr ZnsDevice::addr_of(const Zone &zn, int off) const
+{
+    const auto &m = bm_.superblock_members(zn.sb);
+    auto [d, p] = m[off % m.size()];
+    return {d, p, bm_.resolve_pbn(d, p, zn.sb), off / (int)m.size()};
+}
+
+ZnsStatus ZnsDevice::writable(int z) const
+{
+    switch (zones_[z].state)
+    {
+    case ZoneState::FULL: return ZnsStatus::ZONE_FULL;
+    case ZoneState::READ_ONLY: return ZnsStatus::ZONE_READ_ONLY;
+    case ZoneState::OFFLINE: return ZnsStatus::ZONE_OFFLINE;
+    default: return ZnsStatus::SUCCESS;
+    }
+}
+
+ZnsStatus ZnsDevice::open_internal(int z, bool explicit_open)
+{
+    auto &zn = zones_[z];
+    if (is_open(zn.state))
+    {
+        if (explicit_open && zn.state == ZoneState::IMPLICIT_OPEN)
+            set_state(z, ZoneState::EXPLICIT_OPEN);
+        return ZnsStatus::SUCCESS;
+    }
+    if (zn.state != ZoneState::EMPTY && zn.state != ZoneState::CLOSED)
+        return ZnsStatus::INVALID_FIELD;
+    if (zn.state == ZoneState::EMPTY && n_active_ >= max_active_)
+        return ZnsStatus::TOO_MANY_ACTIVE;
+    if (n_open_ >= max_open_)
+    {
+        // 设备可以自行关闭隐式打开的 zone 腾出名额，显式打开的由主机管理
+        if (implicit_open_.empty())
+            return ZnsStatus::TOO_MANY_OPEN;
+        close_internal(implicit_open_.front());
+        stats_.implicit_closes++;
+    }
+    if (zn.state == ZoneState::EMPTY)
+    {
+        int sb = bm_.take_superblock();
+        if (sb == -1)
+        {
+            LOG_WARN("[ZNS] no superblock for zone " << z);
+            set_state(z, ZoneState::OFFLINE);
+            return ZnsStatus::ZONE_OFFLINE;
+        }
+        zn.sb = sb;
+        zn.cap = (int)bm_.superblock_members(sb).size() * drv_.pages_per_block();
+        zn.wp = zn.start;
+        zn.written = 0;
+    }
+    set_state(z, explicit_open ? ZoneState::EXPLICIT_OPEN : ZoneState::IMPLICIT_OPEN);
+    return ZnsStatus::SUCCESS;
+}
+
+void ZnsDevice::close_internal(int z)
+{
+    auto &zn = zones_[z];
+    if (zn.written == 0)
+    {
+        // 没写过的超级块仍是擦除态，直接交还
+        bm_.release_superblock(zn.sb);
+        zn.sb = -1;
+        zn.cap = zone_size_;
+        set_state(z, ZoneState::EMPTY);
+        return;
+    }
+    set_state(z, ZoneState::CLOSED);
+}
+
+ZnsStatus ZnsDevice::prepare_write(int z)
+{
+    if (is_open(zones_[z].state))
+        return ZnsStatus::SUCCESS;
+    return open_internal(z, false);
+}
+
+ZnsStatus ZnsDevice::program(int z, const string &data)
+{
+    auto &zn = zones_[z];
+    NandAddr a = addr_of(zn, zn.written);
+    NandOp op;
+    op.cmd = NandCmd::PROGRAM_PAGE;
+    op.targets.push_back(a);
+    op.data.push_back(data);
+    op.oob_lba.push_back(zn.wp);
+    op.oob_seq.push_back(seq_++);
+    op.issue_ns = now_ns_;
+    NandStatus st = runtime_.bad_block_table[runtime_.idx(a.die, a.plane, a.block)] ? NandStatus::BAD_BLOCK
+                                                                                     : drv_.submit(op).first;
+    // 负载超出镜像页等参数错误：未触及介质，不判坏
+    if (st == NandStatus::INVALID_PARAM)
+        return reject(ZnsStatus::INVALID_FIELD);
+    if (st != NandStatus::SUCCESS)
+    {
+        // 块判坏并 remap；zone 不再可写
+        drv_.mark_block_bad_oob(a.die, a.plane, a.block);
+        runtime_.bad_block_table[runtime_.idx(a.die, a.plane, a.block)] = true;
+        bm_.remap_grown_bad(a.die, a.plane, a.block);
+        set_state(z, ZoneState::READ_ONLY);
+        stats_.write_faults++;
+        LOG_WARN("[ZNS] program fail zone " << z << " -> READ_ONLY");
+        return reject(ZnsStatus::WRITE_FAULT);
+    }
+    now_ns_ = max(now_ns_, op.complete_ns - min(op.complete_ns, write_buffer_ns_));
+    zn.wp++;
+    zn.written++;
+    if (zn.written == zn.cap)
+        set_state(z, ZoneState::FULL);
+    return ZnsStatus::SUCCESS;
+}
+
+ZnsStatus ZnsDevice::write(int lba, const string &data)
+{
+    if (lba < 0 || lba >= lbas())
+        return reject(ZnsStatus::OUT_OF_RANGE);
+    int z = lba / zone_size_;
+    ZnsStatus st = writable(z);
+    if (st != ZnsStatus::SUCCESS)
+        return reject(st);
+    if (lba != zones_[z].wp)
+        return reject(ZnsStatus::INVALID_WRITE);
+    if ((st = prepare_write(z)) != ZnsStatus::SUCCESS)
+        return reject(st);
+    stats_.writes++;
+    return program(z, data);
+}
+
+ZnsStatus ZnsDevice::append(int z, const string &data, int &lba)
+{
+    if (z < 0 || z >= zone_count())
+        return reject(ZnsStatus::INVALID_FIELD);
+    ZnsStatus st = writable(z);
+    if (st == ZnsStatus::SUCCESS)
+        st = prepare_write(z);
+    if (st != ZnsStatus::SUCCESS)
+        return reject(st);
+    lba = zones_[z].wp;
+    stats_.appends++;
+    return program(z, data);
+}
+
+ZnsStatus ZnsDevice::read(int lba, string &out)
+{
+    if (lba < 0 || lba >= lbas())
+        return reject(ZnsStatus::OUT_OF_RANGE);
+    int z = lba / zone_size_;
+    const auto &zn = zones_[z];
+    int off = lba - zn.start;
+    if (zn.sb == -1 || off >= zn.written)
+        return reject(ZnsStatus::OUT_OF_RANGE);
+    NandOp op;
+    op.cmd = NandCmd::READ_PAGE;
+    op.targets.push_back(addr_of(zn, off));
+    op.issue_ns = now_ns_;
+    auto r = drv_.submit(op);
+    now_ns_ = max(now_ns_, op.complete_ns);
+    stats_.reads++;
+    if (r.first != NandStatus::SUCCESS || op.data.empty())
+    {
+        stats_.read_errors++;
+        return reject(ZnsStatus::READ_ERROR);
+    }
+    out = move(op.data[0]);
+    return ZnsStatus::SUCCESS;
+}
+
+ZnsStatus ZnsDevice::open_zone(int z)
+{
+    if (z < 0 || z >= zone_count())
+        return reject(ZnsStatus::INVALID_FIELD);
+    ZnsStatus st = open_internal(z, true);
+    return st == ZnsStatus::SUCCESS ? st : reject(st);
+}
+
+ZnsStatus ZnsDevice::close_zone(int z)
+{
+    if (z < 0 || z >= zone_count())
+        return reject(ZnsStatus::INVALID_FIELD);
+    if (zones_[z].state == ZoneState::CLOSED)
+        return ZnsStatus::SUCCESS;
+    if (!is_open(zones_[z].state))
+        return reject(ZnsStatus::INVALID_FIELD);
+    close_internal(z);
+    return ZnsStatus::SUCCESS;
+}
+
+ZnsStatus ZnsDevice::finish_zone(int z)
+{
+    if (z < 0 || z >= zone_count())
+        return reject(ZnsStatus::INVALID_FIELD);
+    auto &zn = zones_[z];
+    if (zn.state == ZoneState::FULL)
+        return ZnsStatus::SUCCESS;
+    if (zn.state != ZoneState::EMPTY && !is_active(zn.state))
+        return reject(ZnsStatus::INVALID_FIELD);
+    zn.wp = zn.start + zn.cap;
+    set_state(z, ZoneState::FULL);
+    stats_.finishes++;
+    return ZnsStatus::SUCCESS;
+}
+
+// 各成员的擦除同一时刻发出，不同 die 上并行；擦除失败的块判坏 remap，release 时无 spare 的 lane 退出
+ZnsStatus ZnsDevice::reset_zone(int z)
+{
+    if (z < 0 || z >= zone_count())
+        return reject(ZnsStatus::INVALID_FIELD);
+    auto &zn = zones_[z];
+    if (zn.state == ZoneState::OFFLINE)
+        return reject(ZnsStatus::ZONE_OFFLINE);
+    if (zn.state == ZoneState::EMPTY)
+        return ZnsStatus::SUCCESS;
+    if (zn.sb != -1)
+    {
+        uint64_t done = now_ns_;
+        for (auto [d, p] : bm_.superblock_members(zn.sb))
+        {
+            int pbn = bm_.resolve_pbn(d, p, zn.sb);
+            if (runtime_.bad_block_table[runtime_.idx(d, p, pbn)])
+                continue;
+            NandOp op;
+            op.cmd = NandCmd::ERASE_BLOCK;
+            op.targets.push_back({d, p, pbn, -1});
+            op.issue_ns = now_ns_;
+            if (drv_.submit(op).first != NandStatus::SUCCESS)
+            {
+                drv_.mark_block_bad_oob(d, p, pbn);
+                runtime_.bad_block_table[runtime_.idx(d, p, pbn)] = true;
+                bm_.remap_grown_bad(d, p, pbn);
+            }
+            done = max(done, op.complete_ns);
+        }
+        now_ns_ = done;
+        bm_.release_superblock(zn.sb);
+        zn.sb = -1;
+    }
+    zn.wp = zn.start;
+    zn.written = 0;
+    zn.cap = zone_size_;
+    set_state(z, ZoneState::EMPTY);
+    stats_.resets++;
+    return ZnsStatus::SUCCESS;
+}
+
+size_t ZnsDevice::dram_bytes() const
+{
+    return sizeof(*this) + zones_.capacity() * sizeof(Zone) + implicit_open_.size() * sizeof(int);
+}
+
+void ZnsDevice::dump_zones(int max_lines)
+{
+    for (int z = 0; z < zone_count() && z < max_lines; ++z)
+    {
+        const auto &zn = zones_[z];
+        cout << "[ZNS] zone " << z << " " << zone_state_name(zn.state) << " wp=+" << zn.wp - zn.start << "/" << zn.cap
+             << " sb=" << zn.sb << "\n";
+    }
+    if (zone_count() > max_lines)
+        cout << "[ZNS] ... " << zone_count() - max_lines << " more zones\n";
+}
+
+void ZnsDevice::dump_stats()
+{
+    cout << "[ZNS] zones=" << zone_count() << " zone_size=" << zone_size_ << " open=" << n_open_ << "/" << max_open_
+         << " active=" << n_active_ << "/" << max_active_ << " writes=" << stats_.writes << " appends=" << stats_.appends
+         << " reads=" << stats_.reads << " resets=" << stats_.resets << " finishes=" << stats_.finishes
+         << " implicit_closes=" << stats_.implicit_closes << " rejected=" << stats_.rejected
+         << " write_faults=" << stats_.write_faults << " read_errors=" << stats_.read_errors
+         << " dram_bytes=" << dram_bytes() << "\n";
+}
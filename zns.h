@@ -0,0 +1,142 @@
+#ifndef ZNS_H
+#define ZNS_H
+
+#include <bits/stdc++.h>
+#include "nand_model.h"
+#include "nand_runtime.h"
+#include "nand_driver.h"
+#include "block_allocator.h"
+using namespace std;
+
+/* ---------------- ZnsDevice：主机管理的顺序写 zone（ZNS） ----------------
+   - 与 FTL 并列，直接建在 NandDriver + BlockManager 之上：没有页级 L2P、没有 GC、不留 OP
+   - zone 数 = 构造时空闲的原生超级块数；zone 打开时向 BlockManager 取一个超级块（按宽度、擦除次数挑），
+     zone 内偏移 o 落在成员 o % 宽度 的第 o / 宽度 页（与条带写入顺序一致，顺序写跨 die 并行）
+   - zone 大小 = 满宽超级块的页数；zone 容量 = 实际成员数 × 每块页数（坏块退出的 lane 不计）
+   - 写必须落在写指针上（否则 INVALID_WRITE）；zone append 由设备决定位置并返回 LBA
+   - zone reset = 擦除超级块各成员后归还 BlockManager；finish 把写指针推到容量末尾（剩余页不再可写）
+   - 资源限制（NVMe ZNS）：open = 隐式 + 显式打开，active = open + closed；
+     写一个 EMPTY / CLOSED zone 时隐式打开，open 已满则先隐式关闭最早的隐式打开 zone，没有可关的返回 TOO_MANY_OPEN；
+     EMPTY 转入 active 时 active 已满返回 TOO_MANY_ACTIVE
+   - program 失败：块判坏、走 BBT remap，zone 转 READ_ONLY（坏块上已写的页随之丢失，其余照常可读；主机搬走后 reset）
+   - 时序与 FTL 同步模式一致：操作在当前时钟下发，读 / reset 等完成，写按写缓冲提前返回
+*/
+enum class ZoneState : uint8_t
+{
+    EMPTY,
+    IMPLICIT_OPEN,
+    EXPLICIT_OPEN,
+    CLOSED,
+    FULL,
+    READ_ONLY,
+    OFFLINE
+};
+
+enum class ZnsStatus : uint8_t
+{
+    SUCCESS,
+    INVALID_FIELD,   // zone 号越界 / 当前状态不允许该操作
+    OUT_OF_RANGE,    // LBA 越界，或读写指针之后的 LBA
+    INVALID_WRITE,   // 写不在写指针上
+    ZONE_FULL,
+    ZONE_READ_ONLY,
+    ZONE_OFFLINE,    // 没有可用超级块
+    TOO_MANY_OPEN,
+    TOO_MANY_ACTIVE,
+    WRITE_FAULT,
+    READ_ERROR
+};
+
+const char *zns_status_name(ZnsStatus s);
+const char *zone_state_name(ZoneState s);
+
+class ZnsDevice
+{
+public:
+    struct Zone
+    {
+        ZoneState state = ZoneState::EMPTY;
+        int start = 0;   // 首 LBA
+        int wp = 0;      // 写指针（LBA）
+        int written = 0; // 实际写入的页数（finish 后写指针之后的页没有写过）
+        int cap = 0;     // 可写页数（未打开时为满宽估计）
+        int sb = -1;     // 背后的超级块
+    };
+
+    struct Stats
+    {
+        uint64_t writes = 0;
+        uint64_t appends = 0;
+        uint64_t reads = 0;
+        uint64_t resets = 0;
+        uint64_t finishes = 0;
+        uint64_t implicit_closes = 0; // 为腾出 open 名额而隐式关闭的 zone
+        uint64_t rejected = 0;        // 返回非 SUCCESS 的命令
+        uint64_t write_faults = 0;
+        uint64_t read_errors = 0;
+    };
+
+    ZnsDevice(NandDriver &drv, NandRuntime &rt, BlockManager &bm, int max_open = 14, int max_active = 14);
+
+    int zone_count() const { return (int)zones_.size(); }
+    int zone_size() const { return zone_size_; }
+    int lbas() const { return zone_count() * zone_size_; }
+    const Zone &zone(int z) const { return zones_[z]; }
+    int open_zones() const { return n_open_; }
+    int active_zones() const { return n_active_; }
+    int max_open() const { return max_open_; }
+    int max_active() const { return max_active_; }
+
+    ZnsStatus write(int lba, const string &data);
+    // 追加到 zone 写指针处，lba 返回实际写入位置
+    ZnsStatus append(int z, const string &data, int &lba);
+    ZnsStatus read(int lba, string &out);
+    ZnsStatus open_zone(int z);
+    ZnsStatus close_zone(int z);
+    ZnsStatus finish_zone(int z);
+    ZnsStatus reset_zone(int z);
+
+    // 写缓冲：与 FTL::set_write_buffer 相同，写在 program 距完成不超过 pages 个 program 时长时返回
+    void set_write_buffer(int pages) { write_buffer_ns_ = (uint64_t)max(0, pages) * drv_.cell_params().t_prog_ns; }
+    uint64_t now_ns() const { return now_ns_; }
+    void advance_to(uint64_t t) { now_ns_ = max(now_ns_, t); }
+
+    const Stats &stats() const { return stats_; }
+    // 设备侧元数据（zone 表 + 打开队列）的 DRAM 占用
+    size_t dram_bytes() const;
+    void dump_zones(int max_lines = 16);
+    void dump_stats();
+
+private:
+    NandDriver &drv_;
+    NandRuntime &runtime_;
+    BlockManager &bm_;
+    int max_open_, max_active_;
+    int zone_size_ = 0;
+    vector<Zone> zones_;
+    deque<int> implicit_open_; // 隐式打开的 zone，按打开先后
+    int n_open_ = 0, n_active_ = 0;
+    uint64_t now_ns_ = 0;
+    uint64_t write_buffer_ns_ = 0;
+    uint64_t seq_ = 1;
+    Stats stats_;
+
+    ZnsStatus reject(ZnsStatus s)
+    {
+        stats_.rejected++;
+        return s;
+    }
+    // 状态是否允许写（FULL / READ_ONLY / OFFLINE 不行）
+    ZnsStatus writable(int z) const;
+    // 写之前：EMPTY / CLOSED 隐式打开（按资源限制）
+    ZnsStatus prepare_write(int z);
+    // 从 EMPTY / CLOSED 进入打开状态（explicit：显式打开）
+    ZnsStatus open_internal(int z, bool explicit_open);
+    // 打开的 zone 转 CLOSED；一页没写的直接交还超级块，回到 EMPTY
+    void close_internal(int z);
+    void set_state(int z, ZoneState s);
+    ZnsStatus program(int z, const string &data);
+    NandAddr addr_of(const Zone &zn, int off) const;
+};
+
+#endif // ZNS_H
@@ -0,0 +1,246 @@
+#include "ftl.h"
+#include "zns.h"
+#include "logger.h"
+
+/* ---------------- ZNS 与常规 FTL 对比 benchmark ----------------
+   同一套 NAND 几何上模拟一个追加写的存储引擎：数据按段（segment，大小 = 一个 zone）顺序写，
+   writers 个段同时在写（逐页轮转交错），段写满后成为只读数据；需要新段而没有空闲段时随机删掉一个整段
+   （日志 / TTL 式删除，引擎自身的 compaction 两边相同，不计入）。读随机落在已写满的段上。
+   - ZNS：段 = zone，写用 zone append，删段 = zone reset；导出容量为全部超级块
+   - 常规：段 = 一段连续 LBA，删段不通知设备（没有 trim），下次复用时覆盖写；FTL 照常留 OP、做 GC
+   先把所有段写一遍（不计入），再测 turns 轮导出容量的写入，输出 WAF、GC 次数、设备侧映射 DRAM 与读写延迟。
+   用法：zns_bench [--dies N] [--blocks N] [--pages N] [--writers N] [--turns N] [--read-pct PCT]
+                  [--write-buffer PAGES] [--user-ratio R] [--seed S]
+   --user-ratio：常规 FTL 导出的 LBA 占可写页的比例（其余为 OP）
+*/
+
+struct ZnsConfig
+{
+    int dies = 4, planes = 2, blocks = 64, pages = 32;
+    int reserved_write = 1, reserved_spare = 2;
+    double user_ratio = 0.85;
+    int writers = 4;
+    int turns = 4;
+    int read_pct = 30;
+    int write_buffer = 16;
+    uint32_t seed = 1;
+};
+
+struct ZnsResult
+{
+    long segments = 0, capacity = 0; // 段数、导出页数
+    uint64_t host_writes = 0, programs = 0, gc_runs = 0;
+    size_t dram_bytes = 0;
+    double write_avg_us = 0, write_p99_us = 0, read_avg_us = 0, read_p99_us = 0, reset_avg_us = 0;
+    int bad = 0; // 读回与写入不一致
+};
+
+static void summarize(vector<uint64_t> &v, double &avg, double &p99)
+{
+    if (v.empty())
+        return;
+    double sum = 0;
+    for (uint64_t x : v)
+        sum += x;
+    avg = sum / v.size() / 1000.0;
+    size_t k = min(v.size() - 1, (size_t)(0.99 * (v.size() - 1)));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    p99 = v[k] / 1000.0;
+}
+
+// 设备适配：write_page 把段内第 i 页写下去，read_page 读回，drop 删段；返回设备时钟
+struct SegmentDevice
+{
+    function<bool(int seg, int i, const string &data)> write_page;
+    function<bool(int seg, int i, string &out)> read_page;
+    function<void(int seg)> drop;
+    function<uint64_t()> now;
+};
+
+static void run_engine(const ZnsConfig &c, int segments, int seg_pages, SegmentDevice &dev, NandDriver &drv,
+                       ZnsResult &r, function<uint64_t()> gc_runs)
+{
+    mt19937 rng(c.seed);
+    vector<int> gen(segments, 0); // 段被写过几次（负载里带上，检验读到的是最新一代）
+    vector<int> full;             // 已写满的段
+    vector<int> free_segs(segments);
+    iota(free_segs.rbegin(), free_segs.rend(), 0);
+    int writers = min(c.writers, segments);
+    vector<pair<int, int>> w(writers, {-1, 0}); // (段, 已写页数)
+    vector<uint64_t> wl, rl, xl;
+    long total = (long)segments * seg_pages * (1 + c.turns);
+    long warm = (long)segments * seg_pages;
+    uint64_t programs0 = 0, gc0 = 0;
+    auto payload = [](int seg, int i, int g) { return "S" + to_string(seg) + "." + to_string(i) + "." + to_string(g); };
+
+    for (long n = 0, k = 0; n < total; ++k)
+    {
+        if (n == warm && programs0 == 0)
+        {
+            programs0 = drv.get_stats().program_ops;
+            gc0 = gc_runs();
+        }
+        bool measure = n >= warm;
+        if (!full.empty() && (int)(rng() % 100) < c.read_pct)
+        {
+            int seg = full[rng() % full.size()];
+            int i = rng() % seg_pages;
+            string out;
+            uint64_t t0 = dev.now();
+            if (!dev.read_page(seg, i, out) || out != payload(seg, i, gen[seg]))
+                r.bad++;
+            if (measure)
+                rl.push_back(dev.now() - t0);
+            continue;
+        }
+        auto &[seg, done] = w[k % writers];
+        if (seg == -1)
+        {
+            if (free_segs.empty())
+            {
+                // 随机删一个已写满的段
+                size_t v = rng() % full.size();
+                int victim = full[v];
+                full[v] = full.back();
+                full.pop_back();
+                uint64_t t0 = dev.now();
+                dev.drop(victim);
+                if (measure)
+                    xl.push_back(dev.now() - t0);
+                free_segs.push_back(victim);
+            }
+            seg = free_segs.back();
+            free_segs.pop_back();
+            done = 0;
+            gen[seg]++;
+        }
+        uint64_t t0 = dev.now();
+        if (!dev.write_page(seg, done, payload(seg, done, gen[seg])))
+            r.bad++;
+        if (measure)
+            wl.push_back(dev.now() - t0);
+        n++;
+        if (++done == seg_pages)
+        {
+            full.push_back(seg);
+            seg = -1;
+        }
+    }
+    r.host_writes = wl.size();
+    r.programs = drv.get_stats().program_ops - programs0;
+    r.gc_runs = gc_runs() - gc0;
+    summarize(wl, r.write_avg_us, r.write_p99_us);
+    summarize(rl, r.read_avg_us, r.read_p99_us);
+    double xsum = 0;
+    for (uint64_t x : xl)
+        xsum += x;
+    r.reset_avg_us = xl.empty() ? 0 : xsum / xl.size() / 1000.0;
+}
+
+static ZnsResult run_ftl(const ZnsConfig &c, int seg_pages)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    int writable = (c.blocks - c.reserved_write - c.reserved_spare) * c.pages * c.planes * c.dies;
+    int segments = (int)(writable * c.user_ratio) / seg_pages;
+    FTL ftl(driver, runtime, bm, segments * seg_pages);
+    ftl.set_write_buffer(c.write_buffer);
+    SegmentDevice dev;
+    dev.write_page = [&](int seg, int i, const string &d)
+    {
+        ftl.write(seg * seg_pages + i, d);
+        return true;
+    };
+    dev.read_page = [&](int seg, int i, string &out) { return ftl.read_lba(seg * seg_pages + i, out); };
+    dev.drop = [](int) {};
+    dev.now = [&] { return ftl.now_ns(); };
+    ZnsResult r;
+    r.segments = segments;
+    r.capacity = (long)segments * seg_pages;
+    run_engine(c, segments, seg_pages, dev, driver, r, [&] { return ftl.gc_stats().runs; });
+    r.dram_bytes = ftl.mapping_dram_bytes();
+    return r;
+}
+
+static ZnsResult run_zns(const ZnsConfig &c)
+{
+    NandModel model(c.dies, c.planes, c.blocks, c.pages);
+    NandRuntime runtime(c.dies, c.planes, c.blocks);
+    NandDriver driver(model, runtime);
+    BlockManager bm(driver, runtime, c.reserved_write, c.reserved_spare);
+    ZnsDevice zns(driver, runtime, bm, c.writers, c.writers);
+    zns.set_write_buffer(c.write_buffer);
+    vector<int> base(zns.zone_count()); // 段 -> 本代首个 LBA（append 返回）
+    SegmentDevice dev;
+    dev.write_page = [&](int seg, int i, const string &d)
+    {
+        int lba = -1;
+        bool ok = zns.append(seg, d, lba) == ZnsStatus::SUCCESS;
+        if (i == 0)
+            base[seg] = lba;
+        return ok && lba == base[seg] + i;
+    };
+    dev.read_page = [&](int seg, int i, string &out) { return zns.read(base[seg] + i, out) == ZnsStatus::SUCCESS; };
+    dev.drop = [&](int seg) { zns.reset_zone(seg); };
+    dev.now = [&] { return zns.now_ns(); };
+    ZnsResult r;
+    r.segments = zns.zone_count();
+    r.capacity = (long)zns.zone_count() * zns.zone_size();
+    run_engine(c, zns.zone_count(), zns.zone_size(), dev, driver, r, [] { return (uint64_t)0; });
+    r.dram_bytes = zns.dram_bytes();
+    return r;
+}
+
+static void print(const char *name, const ZnsResult &r)
+{
+    cout << setw(5) << name << fixed << setprecision(2) << "  segments=" << r.segments << "  capacity=" << r.capacity
+         << "  waf=" << (r.host_writes ? (double)r.programs / r.host_writes : 0.0) << "  gc_runs=" << r.gc_runs
+         << "  dram=" << r.dram_bytes << "B" << setprecision(1) << "  write avg=" << r.write_avg_us
+         << "us p99=" << r.write_p99_us << "us  read avg=" << r.read_avg_us << "us p99=" << r.read_p99_us
+         << "us  reset avg=" << r.reset_avg_us << "us  bad=" << r.bad << defaultfloat << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    ZnsConfig cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--dies" && i + 1 < argc)
+            cfg.dies = max(1, stoi(argv[++i]));
+        else if (arg == "--blocks" && i + 1 < argc)
+            cfg.blocks = max(8, stoi(argv[++i]));
+        else if (arg == "--pages" && i + 1 < argc)
+            cfg.pages = max(2, stoi(argv[++i]));
+        else if (arg == "--writers" && i + 1 < argc)
+            cfg.writers = max(1, stoi(argv[++i]));
+        else if (arg == "--turns" && i + 1 < argc)
+            cfg.turns = max(1, stoi(argv[++i]));
+        else if (arg == "--read-pct" && i + 1 < argc)
+            cfg.read_pct = min(99, max(0, stoi(argv[++i])));
+        else if (arg == "--write-buffer" && i + 1 < argc)
+            cfg.write_buffer = max(0, stoi(argv[++i]));
+        else if (arg == "--user-ratio" && i + 1 < argc)
+            cfg.user_ratio = min(1.0, max(0.1, stod(argv[++i])));
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = (uint32_t)stoul(argv[++i]);
+        else
+        {
+            cerr << "usage: zns_bench [--dies N] [--blocks N] [--pages N] [--writers N] [--turns N] [--read-pct PCT]"
+                    " [--write-buffer PAGES] [--user-ratio R] [--seed S]\n";
+            return 1;
+        }
+    }
+    Logger::set_level(LogLevel::OFF);
+    cout << "geometry " << cfg.dies << "x" << cfg.planes << "x" << cfg.blocks << "x" << cfg.pages
+         << " writers=" << cfg.writers << " turns=" << cfg.turns << " read_pct=" << cfg.read_pct
+         << " user_ratio=" << cfg.user_ratio << "\n";
+    ZnsResult z = run_zns(cfg);
+    // 常规 FTL 的段与 zone 同样大，便于对照
+    ZnsResult f = run_ftl(cfg, cfg.pages * cfg.planes * cfg.dies);
+    print("ftl", f);
+    print("zns", z);
+    return 0;
+}